@@ -12,6 +12,7 @@
 #include "../../src/utils/log.h"
 
 #include <chrono>
+#include <limits>
 #include <thread>
 #include <sys/stat.h>
 
@@ -604,12 +605,16 @@ cdm::Time CdmAdapter::GetCurrentWallTime()
 
 void CdmAdapter::OnResolvePromise(uint32_t promise_id)
 {
+  SendClientMessage(nullptr, 0, CdmAdapterClient::kPromiseResolved, nullptr, 0, promise_id);
 }
 
 void CdmAdapter::OnResolveNewSessionPromise(uint32_t promise_id,
                       const char* session_id,
                       uint32_t session_id_size)
 {
+  // session_id is NULL when a session to be loaded does not exist
+  SendClientMessage(session_id, session_id ? session_id_size : 0,
+                    CdmAdapterClient::kPromiseResolved, nullptr, 0, promise_id);
 }
 
 void CdmAdapter::OnSessionKeysChange(const char* session_id,
@@ -636,7 +641,13 @@ void CdmAdapter::OnExpirationChange(const char* session_id,
                   uint32_t session_id_size,
                   cdm::Time new_expiry_time)
 {
-  SendClientMessage(session_id, session_id_size, CdmAdapterClient::kSessionExpired, nullptr, 0, 0);
+  // The expiration time in seconds since the epoch, 0 when the license never expires
+  uint32_t expiryTime{0};
+  if (new_expiry_time > 0 && new_expiry_time < std::numeric_limits<uint32_t>::max())
+    expiryTime = static_cast<uint32_t>(new_expiry_time);
+
+  SendClientMessage(session_id, session_id_size, CdmAdapterClient::kSessionExpired, nullptr, 0,
+                    expiryTime);
 }
 
 void CdmAdapter::OnSessionClosed(const char* session_id,
@@ -682,6 +693,12 @@ void CdmAdapter::OnResolveKeyStatusPromise(uint32_t promise_id, cdm::KeyStatus k
 void CdmAdapter::OnRejectPromise(uint32_t promise_id, cdm::Exception exception,
   uint32_t system_code, const char* error_message, uint32_t error_message_size)
 {
+  LOG::Log(LOGDEBUG, "%s: Promise %u rejected, exception: %d syscode: %u", __func__, promise_id,
+           exception, system_code);
+
+  SendClientMessage(nullptr, 0, CdmAdapterClient::kPromiseRejected,
+                    reinterpret_cast<const uint8_t*>(error_message),
+                    error_message ? error_message_size : 0, promise_id);
 }
 
 void CdmAdapter::OnSessionMessage(const char* session_id, uint32_t session_id_size,
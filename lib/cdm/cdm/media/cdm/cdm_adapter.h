@@ -37,7 +37,9 @@ public:
     kSessionExpired,
     kSessionKeysChange,
     kSessionClosed,
-    kLegacySessionError
+    kLegacySessionError,
+    kPromiseResolved, // status is the promise id
+    kPromiseRejected // status is the promise id
   };
 
   virtual void OnCDMMessage(const char* session, uint32_t session_size, CDMADPMSG msg, const uint8_t *data, size_t data_size, uint32_t status) = 0;
@@ -9,6 +9,7 @@
 #include "ES_MPEGVideo.h"
 #include "bitstream.h"
 #include "debug.h"
+#include "startCode.h"
 
 using namespace TSDemux;
 
@@ -68,6 +69,8 @@ void ES_MPEG2Video::Parse(STREAM_PKT *pkt)
 {
   int frame_ptr = es_consumed;
   int p = es_parsed;
+  // Until 4 bytes have been shifted in, the startcode register holds bytes of the previous call
+  const int scan_ptr = es_parsed + 4;
   uint32_t startcode = m_StartCode;
   bool frameComplete = false;
   int l;
@@ -80,6 +83,14 @@ void ES_MPEG2Video::Parse(STREAM_PKT *pkt)
         break;
       }
     }
+    else if (p >= scan_ptr)
+    {
+      // Jump where the byte loop would stop next, after the start code and its id byte
+      size_t sc = FindStartCode(es_buf, p - 3, es_len - 5);
+      p = static_cast<int>(sc < es_len - 5 ? sc + 4 : es_len - 3);
+      startcode = LoadStartCodeRegister(es_buf + p - 4);
+      continue;
+    }
     startcode = startcode << 8 | es_buf[p++];
   }
   es_parsed = p;
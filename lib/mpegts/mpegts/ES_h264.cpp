@@ -9,6 +9,7 @@
 #include "ES_h264.h"
 #include "bitstream.h"
 #include "debug.h"
+#include "startCode.h"
 
 #include <cstring>      // for memset memcpy
 
@@ -83,6 +84,8 @@ void ES_h264::Parse(STREAM_PKT* pkt)
 {
   size_t frame_ptr = es_consumed;
   size_t pOld = es_parsed, p = es_parsed;
+  // Until 4 bytes have been shifted in, the startcode register holds bytes of the previous call
+  const size_t scan_ptr = es_parsed + 4;
   uint32_t startcode = m_StartCode;
   bool frameComplete = false;
 
@@ -120,6 +123,14 @@ void ES_h264::Parse(STREAM_PKT* pkt)
         break;
       }
     }
+    else if (p >= scan_ptr)
+    {
+      // Jump where the byte loop would stop next, after the start code and NAL header byte
+      size_t sc = FindStartCode(es_buf, p - 3, es_len - 5);
+      p = sc < es_len - 5 ? sc + 4 : es_len - 3;
+      startcode = LoadStartCodeRegister(es_buf + p - 4);
+      continue;
+    }
     startcode = (startcode << 8) | es_buf[p++];
   }
   es_parsed = p;
@@ -9,6 +9,7 @@
 #include "ES_hevc.h"
 #include "bitstream.h"
 #include "debug.h"
+#include "startCode.h"
 
 #include <cstring>      // for memset memcpy
 
@@ -40,6 +41,8 @@ void ES_hevc::Parse(STREAM_PKT* pkt)
 
   size_t frame_ptr = es_consumed;
   size_t p = es_parsed;
+  // Until 4 bytes have been shifted in, the startcode register holds bytes of the previous call
+  const size_t scan_ptr = es_parsed + 4;
   uint32_t startcode = m_StartCode;
   bool frameComplete = false;
 
@@ -48,6 +51,15 @@ void ES_hevc::Parse(STREAM_PKT* pkt)
 
   while (p < es_len)
   {
+    if (p >= scan_ptr)
+    {
+      // Jump to the last byte of the next start code, or consume all the data
+      size_t sc = FindStartCode(es_buf, p - 2, es_len);
+      p = sc < es_len ? sc + 2 : es_len;
+      startcode = LoadStartCodeRegister(es_buf + p - 4);
+      if (p == es_len)
+        break;
+    }
     startcode = startcode << 8 | es_buf[p++];
     if ((startcode & 0x00ffffff) == 0x00000001)
     {
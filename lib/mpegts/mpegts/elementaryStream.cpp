@@ -31,6 +31,7 @@ ElementaryStream::ElementaryStream(uint16_t pes_pid)
   , es_consumed(0)
   , es_pts_pointer(0)
   , es_parsed(0)
+  , es_bytes_moved(0)
   , es_found_frame(false)
   , es_frame_valid(false)
   , es_extraDataChanged(false)
@@ -42,7 +43,8 @@ ElementaryStream::~ElementaryStream(void)
 {
   if (es_buf)
   {
-    DBG(DEMUX_DBG_DEBUG, "free stream buffer %.4x: allocated size was %zu\n", pid, es_alloc);
+    DBG(DEMUX_DBG_DEBUG, "free stream buffer %.4x: allocated size was %zu, moved %llu bytes\n",
+        pid, es_alloc, (unsigned long long)es_bytes_moved);
     free(es_buf);
     es_buf = NULL;
   }
@@ -70,7 +72,10 @@ int ElementaryStream::Append(const unsigned char* buf, size_t len, bool new_pts)
   {
     if (es_consumed < es_len)
     {
+      // Compaction happens right after a packet has been consumed, so only the few bytes
+      // of the next frame parsed so far are moved, not a whole PES payload
       memmove(es_buf, es_buf + es_consumed, es_len - es_consumed);
+      es_bytes_moved += es_len - es_consumed;
       es_len -= es_consumed;
       es_parsed -= es_consumed;
       if (es_pts_pointer > es_consumed)
@@ -115,6 +115,7 @@ namespace TSDemux
     size_t es_consumed;           ///< Consumed payload. Will be erased on next append
     size_t es_pts_pointer;        ///< Position in buffer where current PTS becomes applicable
     size_t es_parsed;             ///< Parser: Last processed position in buffer
+    uint64_t es_bytes_moved;      ///< Statistic: Bytes moved by buffer compaction
     bool   es_found_frame;        ///< Parser: Found frame
     bool   es_frame_valid;
     bool   es_extraDataChanged;
@@ -0,0 +1,119 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "startCode.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define STARTCODE_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STARTCODE_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define STARTCODE_USE_NEON
+#endif
+
+#if defined(_MSC_VER) && (defined(STARTCODE_USE_AVX2) || defined(STARTCODE_USE_SSE2))
+#include <intrin.h>
+#endif
+
+using namespace TSDemux;
+
+#if defined(STARTCODE_USE_AVX2) || defined(STARTCODE_USE_SSE2)
+static inline unsigned int count_trailing_zeros(uint32_t value)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return index;
+#else
+  return __builtin_ctz(value);
+#endif
+}
+#endif
+
+size_t TSDemux::FindStartCodeScalar(const uint8_t* buf, size_t from, size_t to)
+{
+  size_t i = from;
+  while (i + 2 < to)
+  {
+    // The third byte of a prefix is 1 and the first two are 0, so a byte
+    // greater than 1 at i + 2 excludes a prefix at i, i + 1 and i + 2
+    if (buf[i + 2] > 1)
+      i += 3;
+    else if (buf[i + 2] == 0)
+      i += 1;
+    else if (buf[i] == 0 && buf[i + 1] == 0)
+      return i;
+    else
+      i += 3;
+  }
+  return to;
+}
+
+size_t TSDemux::FindStartCode(const uint8_t* buf, size_t from, size_t to)
+{
+  size_t i = from;
+
+#if defined(STARTCODE_USE_AVX2)
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi8(1);
+  // Each step test 32 prefix positions, so it reads up to i + 33
+  while (i + 34 <= to)
+  {
+    const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf + i));
+    const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf + i + 1));
+    const __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buf + i + 2));
+    const __m256i match = _mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpeq_epi8(b0, zero), _mm256_cmpeq_epi8(b1, zero)),
+        _mm256_cmpeq_epi8(b2, one));
+    const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(match));
+    if (mask)
+      return i + count_trailing_zeros(mask);
+    i += 32;
+  }
+#elif defined(STARTCODE_USE_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi8(1);
+  // Each step test 16 prefix positions, so it reads up to i + 17
+  while (i + 18 <= to)
+  {
+    const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i));
+    const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i + 1));
+    const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i + 2));
+    const __m128i match = _mm_and_si128(
+        _mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)),
+        _mm_cmpeq_epi8(b2, one));
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(match));
+    if (mask)
+      return i + count_trailing_zeros(mask);
+    i += 16;
+  }
+#elif defined(STARTCODE_USE_NEON)
+  const uint8x16_t zero = vdupq_n_u8(0);
+  const uint8x16_t one = vdupq_n_u8(1);
+  // Each step test 16 prefix positions, so it reads up to i + 17
+  while (i + 18 <= to)
+  {
+    const uint8x16_t b0 = vld1q_u8(buf + i);
+    const uint8x16_t b1 = vld1q_u8(buf + i + 1);
+    const uint8x16_t b2 = vld1q_u8(buf + i + 2);
+    const uint8x16_t match =
+        vandq_u8(vandq_u8(vceqq_u8(b0, zero), vceqq_u8(b1, zero)), vceqq_u8(b2, one));
+    const uint64x2_t match64 = vreinterpretq_u64_u8(match);
+    // NEON has no movemask, the exact position is found by the scalar
+    // scan, that is guaranteed to stop within these 16 positions
+    if (vgetq_lane_u64(match64, 0) | vgetq_lane_u64(match64, 1))
+      return FindStartCodeScalar(buf, i, i + 18);
+    i += 16;
+  }
+#endif
+
+  return FindStartCodeScalar(buf, i, to);
+}
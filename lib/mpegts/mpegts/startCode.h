@@ -0,0 +1,42 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#ifndef STARTCODE_H
+#define STARTCODE_H
+
+#include <inttypes.h>
+#include <cstddef>    // for size_t
+
+namespace TSDemux
+{
+  /**
+   * Find the first "00 00 01" start code prefix entirely contained in buf[from, to).
+   * Uses SSE2/AVX2/NEON when available at build time, otherwise FindStartCodeScalar.
+   * @param buf The buffer
+   * @param from The position where the search begin
+   * @param to The position where the search end (excluded)
+   * @return The position of the first prefix byte, or "to" when not found
+   */
+  size_t FindStartCode(const uint8_t* buf, size_t from, size_t to);
+
+  /**
+   * Portable version of FindStartCode, also used to verify the vectorized version.
+   */
+  size_t FindStartCodeScalar(const uint8_t* buf, size_t from, size_t to);
+
+  /**
+   * Get the big-endian 32 bit value at the specified position, in the same way
+   * the ES parsers build their shifting "startcode" register byte by byte.
+   */
+  inline uint32_t LoadStartCodeRegister(const uint8_t* buf)
+  {
+    return (uint32_t)buf[0] << 24 | (uint32_t)buf[1] << 16 | (uint32_t)buf[2] << 8 | buf[3];
+  }
+}
+
+#endif /* STARTCODE_H */
@@ -30,6 +30,20 @@ bool CAdaptiveByteStream::ReadFull(std::vector<uint8_t>& buffer)
   return m_adStream->ReadFullBuffer(buffer);
 }
 
+AP4_Result CAdaptiveByteStream::ReadAvailable(void* buffer,
+                                             AP4_Size minBytes,
+                                             AP4_Size maxBytes,
+                                             AP4_Size& bytesRead)
+{
+  bytesRead = m_adStream->ReadAvailable(buffer, minBytes, maxBytes);
+  return bytesRead > 0 ? AP4_SUCCESS : AP4_ERROR_READ_FAILED;
+}
+
+AP4_Position CAdaptiveByteStream::GetAvailableEndPosition()
+{
+  return m_adStream->GetAvailableEndPosition();
+}
+
 AP4_Result CAdaptiveByteStream::Seek(AP4_Position position)
 {
   return m_adStream->seek(position) ? AP4_SUCCESS : AP4_ERROR_NOT_SUPPORTED;
@@ -60,3 +74,10 @@ void CAdaptiveByteStream::SetSegmentFileOffset(uint64_t offset)
 {
   m_adStream->SetSegmentFileOffset(offset);
 }
+
+bool CAdaptiveByteStream::GetCurrentSegmentInfo(std::string& repId,
+                                                uint64_t& segmentNumber,
+                                                uint64_t& startPos)
+{
+  return m_adStream->GetCurrentSegmentInfo(repId, segmentNumber, startPos);
+}
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <string>
+
 #include <bento4/Ap4.h>
 
 #ifdef INPUTSTREAM_TEST_BUILD
@@ -41,6 +43,26 @@ public:
   */
   bool ReadFull(std::vector<uint8_t>& buffer);
 
+  /*!
+  * \brief Read in bulk the data available from the current segment.
+  * \param buffer[OUT] The buffer where to copy the data, must have the size of maxBytes
+  * \param minBytes The minimum bytes to read, waiting for them when needed
+  * \param maxBytes The maximum bytes to read
+  * \param bytesRead[OUT] The bytes read
+  * \return AP4_SUCCESS if has success, otherwise an error code
+  */
+  AP4_Result ReadAvailable(void* buffer,
+                           AP4_Size minBytes,
+                           AP4_Size maxBytes,
+                           AP4_Size& bytesRead);
+
+  /*!
+  * \brief Get the position where the data that can be read without waiting ends,
+  *        see AdaptiveStream::GetAvailableEndPosition.
+  * \return The position, or 0 if no data is available
+  */
+  AP4_Position GetAvailableEndPosition();
+
   AP4_Result Seek(AP4_Position position) override;
   AP4_Result Tell(AP4_Position& position) override;
   AP4_Result GetSize(AP4_LargeSize& size) override;
@@ -52,6 +74,17 @@ public:
   void FixateInitialization(bool on);
   void SetSegmentFileOffset(uint64_t offset);
 
+  /*!
+  * \brief Get the identity and the start position of the segment currently read.
+  * \param repId[OUT] The id of the segment representation
+  * \param segmentNumber[OUT] The segment number
+  * \param startPos[OUT] The stream position where the segment data begins
+  * \return True if a segment is being read, otherwise false
+  */
+  bool GetCurrentSegmentInfo(std::string& repId,
+                             uint64_t& segmentNumber,
+                             uint64_t& startPos);
+
 protected:
   adaptive::AdaptiveStream* m_adStream;
 };
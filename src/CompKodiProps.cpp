@@ -364,6 +364,18 @@ void ADP::KODI_PROPS::CCompKodiProps::ParseManifestConfig(const std::string& dat
     {
       m_manifestConfig.liveDelay = jDictVal.GetUint64();
     }
+    else if (configName == "live_catchup" && jDictVal.IsBool())
+    {
+      m_manifestConfig.liveCatchup = jDictVal.GetBool();
+    }
+    else if (configName == "live_catchup_max_delay" && jDictVal.IsUint64())
+    {
+      m_manifestConfig.liveCatchupMaxDelay = jDictVal.GetUint64();
+    }
+    else if (configName == "segment_availability_margin" && jDictVal.IsUint64())
+    {
+      m_manifestConfig.segmentAvailabilityMargin = jDictVal.GetUint64();
+    }
     else
     {
       LOG::LogF(LOGERROR, "Unsupported \"%s\" config or wrong data type on \"%s\" property",
@@ -60,6 +60,15 @@ struct ManifestConfig
   bool hlsFixDiscontSequence{false};
   // Custom delay from LIVE edge in seconds
   uint64_t liveDelay{0};
+  // Keep the playback of live streams close to the live delay, by recommending
+  // playback rate adjustments and by seeking forward when too far from the live edge
+  bool liveCatchup{false};
+  // Max delay from LIVE edge in seconds, above which the live catch-up seeks
+  // to the live delay, a value of 0 means use the manifest value or the default
+  uint64_t liveCatchupMaxDelay{0};
+  // Safety margin in ms added to the availability time of the live segments generated
+  // by DASH SegmentTemplate without timeline, before requesting them
+  uint64_t segmentAvailabilityMargin{250};
 };
 
 struct DrmCfg
@@ -115,6 +115,11 @@ std::string ADP::SETTINGS::CCompSettings::GetDecrypterPath() const
   return kodi::vfs::TranslateSpecialProtocol(kodi::addon::GetSettingString("DECRYPTERPATH"));
 }
 
+bool ADP::SETTINGS::CCompSettings::IsDecryptAhead() const
+{
+  return kodi::addon::GetSettingBoolean("decrypt.ahead");
+}
+
 bool ADP::SETTINGS::CCompSettings::IsDebugLicense() const
 {
   return kodi::addon::GetSettingBoolean("debug.save.license");
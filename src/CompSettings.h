@@ -71,6 +71,8 @@ public:
   bool IsDisableSecureDecoder() const;
   std::string GetDecrypterPath() const; // Widevine decrypter binary path
 
+  bool IsDecryptAhead() const;
+
   bool IsDebugLicense() const;
   bool IsDebugManifest() const;
   bool IsDebugVerbose() const;
@@ -17,18 +17,43 @@
 #include "common/Chooser.h"
 #include "decrypters/DrmFactory.h"
 #include "decrypters/Helpers.h"
+#include "decrypters/LicenseCache.h"
 #include "utils/Base64Utils.h"
 #include "utils/CurlUtils.h"
 #include "utils/StringUtils.h"
+#include "utils/ThreadPool.h"
 #include "utils/UrlUtils.h"
 #include "utils/Utils.h"
 #include "utils/log.h"
 
+#include <algorithm>
+#include <future>
+#include <map>
+
 using namespace adaptive;
 using namespace PLAYLIST;
 using namespace SESSION;
 using namespace UTILS;
 
+namespace
+{
+// Max number of license sessions that can be created concurrently
+constexpr size_t MAX_CONCURRENT_LICENSE_SESSIONS = 4;
+// Interval between the live catch-up checks of the delay from the live edge
+constexpr std::chrono::milliseconds LIVE_CATCHUP_CHECK_INTERVAL{1000};
+// Max number of last events notified kept to ignore the repeated ones
+constexpr size_t MAX_EVENT_MESSAGES = 64;
+
+struct LicenseSessionRequest
+{
+  std::vector<uint8_t> m_initData;
+  std::vector<uint8_t> m_defaultKid;
+  std::string m_licenseUrl;
+  CryptoMode m_cryptoMode{CryptoMode::NONE};
+  std::shared_ptr<Adaptive_CencSingleSampleDecrypter> m_decrypter;
+};
+} // unnamed namespace
+
 SESSION::CSession::~CSession()
 {
   LOG::Log(LOGDEBUG, "CSession::~CSession()");
@@ -52,6 +77,17 @@ void SESSION::CSession::DeleteStreams()
   m_streams.clear();
 }
 
+UTILS::CThreadPool* SESSION::CSession::GetDecryptAheadPool()
+{
+  if (!CSrvBroker::GetSettings().IsDecryptAhead())
+    return nullptr;
+
+  if (!m_decryptAheadPool)
+    m_decryptAheadPool = std::make_unique<UTILS::CThreadPool>();
+
+  return m_decryptAheadPool.get();
+}
+
 void SESSION::CSession::SetSupportedDecrypterURN(std::vector<std::string_view>& keySystems)
 {
   std::string decrypterPath = CSrvBroker::GetSettings().GetDecrypterPath();
@@ -185,6 +221,7 @@ bool SESSION::CSession::Initialize(std::string manifestUrl)
 
   m_adaptiveTree->PostOpen();
   m_reprChooser->PostInit();
+  InitializeLiveCatchup();
 
   CSrvBroker::GetInstance()->InitStage2(m_adaptiveTree);
 
@@ -346,6 +383,48 @@ bool SESSION::CSession::InitializeDRM(bool addDefaultKID /* = false */)
       }
     }
 
+    const uint64_t drmStartTime = UTILS::GetTimestampMs();
+    DRM::CLicenseCache::GetInstance().ResetStats();
+
+    // Provide the default KIDs of the PSSH sets known from the manifest, so that
+    // where supported the keys can be requested together with a single license request
+    std::vector<std::vector<uint8_t>> periodKeyIds;
+    for (size_t ses{1}; ses < m_cdmSessions.size(); ++ses)
+    {
+      const CPeriod::PSSHSet& psshSet = m_adaptiveTree->m_currentPeriod->GetPSSHSets()[ses];
+      if (m_cdmSessions[ses].m_cencSingleSampleDecrypter || psshSet.defaultKID_.empty() ||
+          psshSet.adaptation_set_->GetStreamType() == StreamType::NOTYPE)
+        continue;
+
+      std::vector<uint8_t> keyId = DRM::ConvertKidStrToBytes(psshSet.defaultKID_);
+      if (!keyId.empty() &&
+          std::find(periodKeyIds.begin(), periodKeyIds.end(), keyId) == periodKeyIds.end())
+        periodKeyIds.emplace_back(keyId);
+    }
+    m_decrypter->SetPeriodKeyIds(periodKeyIds);
+
+    // Where supported, the license sessions of different PSSH sets are created concurrently,
+    // otherwise are created one at time, in the PSSH sets order
+    const bool isConcurrentSessions = m_decrypter->IsConcurrentSessionsSupported();
+    std::vector<LicenseSessionRequest> requests;
+    // The sessions to be initialized, with their default KID
+    std::vector<std::pair<size_t, std::vector<uint8_t>>> initSessions;
+    // The license session request index used by each session
+    std::map<size_t, size_t> sessionRequests;
+
+    auto createLicenseSession = [this](LicenseSessionRequest& request)
+    {
+      const uint64_t startTime = UTILS::GetTimestampMs();
+
+      request.m_decrypter = m_decrypter->CreateSingleSampleDecrypter(
+          request.m_initData, request.m_defaultKid, request.m_licenseUrl, false,
+          request.m_cryptoMode == CryptoMode::NONE ? CryptoMode::AES_CTR : request.m_cryptoMode);
+
+      LOG::Log(LOGDEBUG, "Initialize DRM: License session for KID %s %s in %llu ms",
+               STRING::ToHexadecimal(request.m_defaultKid).c_str(),
+               request.m_decrypter ? "created" : "failed", UTILS::GetTimestampMs() - startTime);
+    };
+
     // cdmSession 0 is reserved for unencrypted streams
     for (size_t ses{1}; ses < m_cdmSessions.size(); ++ses)
     {
@@ -433,7 +512,8 @@ bool SESSION::CSession::InitializeDRM(bool addDefaultKID /* = false */)
         // If a decrypter has the default KID, re-use the same decrypter for also this session
         for (size_t i{1}; i < ses; ++i)
         {
-          if (m_decrypter->HasLicenseKey(m_cdmSessions[i].m_cencSingleSampleDecrypter, defaultKid))
+          if (m_cdmSessions[i].m_cencSingleSampleDecrypter &&
+              m_decrypter->HasLicenseKey(m_cdmSessions[i].m_cencSingleSampleDecrypter, defaultKid))
           {
             session.m_cencSingleSampleDecrypter = m_cdmSessions[i].m_cencSingleSampleDecrypter;
             break;
@@ -456,12 +536,78 @@ bool SESSION::CSession::InitializeDRM(bool addDefaultKID /* = false */)
         }
       }
 
-      if (session.m_cencSingleSampleDecrypter ||
-          (session.m_cencSingleSampleDecrypter = m_decrypter->CreateSingleSampleDecrypter(
-               initData, defaultKid, sessionPsshset.m_licenseUrl, false,
-               sessionPsshset.m_cryptoMode == CryptoMode::NONE ? CryptoMode::AES_CTR
-                                                               : sessionPsshset.m_cryptoMode)) !=
-              nullptr)
+      initSessions.emplace_back(ses, defaultKid);
+
+      if (session.m_cencSingleSampleDecrypter)
+        continue;
+
+      if (isConcurrentSessions)
+      {
+        // The license session of a previous PSSH set with same KID or init data will be re-used,
+        // as its license cannot be checked for the KID before its creation
+        auto itRequest = std::find_if(
+            requests.begin(), requests.end(),
+            [&](const LicenseSessionRequest& request)
+            {
+              return (!defaultKid.empty() && request.m_defaultKid == defaultKid) ||
+                     (!initData.empty() && request.m_initData == initData);
+            });
+        if (itRequest != requests.end())
+        {
+          sessionRequests[ses] = static_cast<size_t>(itRequest - requests.begin());
+          continue;
+        }
+      }
+
+      sessionRequests[ses] = requests.size();
+      LicenseSessionRequest& request = requests.emplace_back();
+      request.m_initData = initData;
+      request.m_defaultKid = defaultKid;
+      request.m_licenseUrl = sessionPsshset.m_licenseUrl;
+      request.m_cryptoMode = sessionPsshset.m_cryptoMode;
+
+      if (!isConcurrentSessions)
+      {
+        createLicenseSession(request);
+        // Stop on failure, the error is handled below
+        if (!request.m_decrypter)
+          break;
+
+        session.m_cencSingleSampleDecrypter = request.m_decrypter;
+      }
+    }
+
+    if (isConcurrentSessions && requests.size() > 1)
+    {
+      UTILS::CThreadPool pool{std::min(requests.size(), MAX_CONCURRENT_LICENSE_SESSIONS)};
+      std::vector<std::future<void>> results;
+
+      for (LicenseSessionRequest& request : requests)
+      {
+        results.emplace_back(
+            pool.Submit([&createLicenseSession, &request] { createLicenseSession(request); }));
+      }
+      for (std::future<void>& result : results)
+      {
+        result.wait();
+      }
+    }
+    else if (isConcurrentSessions && requests.size() == 1)
+    {
+      createLicenseSession(requests.front());
+    }
+
+    // Set up the sessions in the PSSH sets order, with the license sessions created
+    for (const auto& [ses, defaultKid] : initSessions)
+    {
+      CCdmSession& session{m_cdmSessions[ses]};
+      const CPeriod::PSSHSet& sessionPsshset = m_adaptiveTree->m_currentPeriod->GetPSSHSets()[ses];
+
+      auto itSessionRequest = sessionRequests.find(ses);
+      if (itSessionRequest != sessionRequests.end())
+        session.m_cencSingleSampleDecrypter = requests[itSessionRequest->second].m_decrypter;
+
+      if (session.m_cencSingleSampleDecrypter)
       {
         m_decrypter->GetCapabilities(session.m_cencSingleSampleDecrypter, defaultKid,
                                      sessionPsshset.media_, session.m_decrypterCaps);
@@ -500,6 +646,13 @@ bool SESSION::CSession::InitializeDRM(bool addDefaultKID /* = false */)
         return false;
       }
     }
+
+    DRM::CLicenseCache& licenseCache = DRM::CLicenseCache::GetInstance();
+    LOG::Log(LOGDEBUG,
+             "Initialize DRM: License sessions ready in %llu ms "
+             "(license cache hits: %u, misses: %u)",
+             UTILS::GetTimestampMs() - drmStartTime, licenseCache.GetHits(),
+             licenseCache.GetMisses());
   }
 
   bool isHdcpOverride = CSrvBroker::GetSettings().IsHdcpOverride();
@@ -1116,23 +1269,24 @@ bool SESSION::CSession::SeekTime(double seekTime, unsigned int streamId, bool pr
   // don't try to seek past the end of the stream, leave a sensible amount so we can buffer properly
   if (m_adaptiveTree->IsLive())
   {
-    double maxSeek{0};
-    uint64_t curTime;
-    uint64_t maxTime{0};
-    for (auto& stream : m_streams)
-    {
-      if (stream->m_isEnabled && (curTime = stream->m_adStream.getMaxTimeMs()) && curTime > maxTime)
-      {
-        maxTime = curTime;
-      }
-    }
+    const uint64_t maxTime = GetLiveEdgeTimeMs();
 
-    maxSeek = (static_cast<double>(maxTime) / 1000) - m_adaptiveTree->m_liveDelay;
+    double maxSeek = static_cast<double>(maxTime) / 1000 -
+                     static_cast<double>(m_adaptiveTree->GetLiveDelayMs()) / 1000;
     if (maxSeek < 0)
       maxSeek = 0;
 
     if (seekTime > maxSeek)
       seekTime = maxSeek;
+
+    // A seek far from the live edge is wanted by the user, the live catch-up must not undo it
+    if (m_liveCatchup.IsEnabled())
+    {
+      const double delay = static_cast<double>(maxTime) - seekTime * 1000;
+      m_isLiveCatchupSuspended = delay > m_liveCatchup.GetConfig().m_maxLatency;
+      if (m_isLiveCatchupSuspended)
+        m_liveCatchup.Reset();
+    }
   }
 
   // correct for starting segment pts value of chapter and chapter offset within program
@@ -1227,6 +1381,8 @@ void SESSION::CSession::OnDemuxRead()
       ResetChapterSeekTime();
     }
   }
+
+  CheckLiveCatchup();
 }
 
 void SESSION::CSession::OnSegmentChanged(adaptive::AdaptiveStream* adStream)
@@ -1244,6 +1400,42 @@ void SESSION::CSession::OnSegmentChanged(adaptive::AdaptiveStream* adStream)
       break;
     }
   }
+
+  // The manifest events of the period, the manifest updates are paused here
+  if (adStream->getPeriod())
+  {
+    for (const CEventMessage& event : adStream->getPeriod()->GetEventMessages())
+    {
+      NotifyEventMessage(event);
+    }
+  }
+}
+
+void SESSION::CSession::OnEventMessage(adaptive::AdaptiveStream* adStream,
+                                       const PLAYLIST::CEventMessage& event)
+{
+  NotifyEventMessage(event);
+}
+
+void SESSION::CSession::NotifyEventMessage(const PLAYLIST::CEventMessage& event)
+{
+  std::lock_guard<std::mutex> lck{m_eventMessagesMutex};
+
+  if (std::any_of(m_eventMessages.cbegin(), m_eventMessages.cend(),
+                  [&event](const CEventMessage& item) { return item.IsSameEvent(event); }))
+  {
+    return;
+  }
+
+  if (m_eventMessages.size() == MAX_EVENT_MESSAGES)
+    m_eventMessages.pop_front();
+  m_eventMessages.emplace_back(event);
+
+  LOG::Log(LOGINFO,
+           "Event message (scheme: %s, value: %s, id: %u, presentation time: %llu ms, "
+           "data size: %zu)",
+           event.m_schemeIdUri.c_str(), event.m_value.c_str(), event.m_id,
+           event.GetPresentationTimeMs(), event.m_messageData.size());
 }
 
 void SESSION::CSession::OnStreamChange(adaptive::AdaptiveStream* adStream)
@@ -1378,6 +1570,98 @@ int64_t SESSION::CSession::GetChapterPos(int ch) const
   return sum / STREAM_TIME_BASE;
 }
 
+uint64_t SESSION::CSession::GetLiveEdgeTimeMs()
+{
+  uint64_t maxTime{0};
+  for (auto& stream : m_streams)
+  {
+    if (stream->m_isEnabled)
+      maxTime = std::max(maxTime, stream->m_adStream.getMaxTimeMs());
+  }
+  return maxTime;
+}
+
+void SESSION::CSession::InitializeLiveCatchup()
+{
+  auto& manifestConfig = CSrvBroker::GetKodiProps().GetManifestConfig();
+  if (!m_adaptiveTree->IsLive() || !manifestConfig.liveCatchup)
+    return;
+
+  // The manifest can provide the latency range and the playback rates,
+  // the max delay set by the add-on has the priority
+  CLiveCatchup::Config config;
+  config.m_targetLatency = m_adaptiveTree->GetLiveDelayMs();
+  if (m_adaptiveTree->m_minLatency != NO_VALUE)
+    config.m_minLatency = m_adaptiveTree->m_minLatency;
+  if (manifestConfig.liveCatchupMaxDelay > 0)
+    config.m_maxLatency = manifestConfig.liveCatchupMaxDelay * 1000;
+  else if (m_adaptiveTree->m_maxLatency != NO_VALUE)
+    config.m_maxLatency = m_adaptiveTree->m_maxLatency;
+  config.m_minRate = m_adaptiveTree->m_minPlaybackRate.value_or(0);
+  config.m_maxRate = m_adaptiveTree->m_maxPlaybackRate.value_or(0);
+
+  m_liveCatchup.Configure(config);
+
+  const CLiveCatchup::Config& cfg = m_liveCatchup.GetConfig();
+  LOG::Log(LOGINFO,
+           "Live catch-up enabled (Target delay: %llu ms, Delay range: %llu-%llu ms, "
+           "Playback rate range: %.2f-%.2f)",
+           cfg.m_targetLatency, cfg.m_minLatency, cfg.m_maxLatency, cfg.m_minRate, cfg.m_maxRate);
+}
+
+void SESSION::CSession::CheckLiveCatchup()
+{
+  if (!m_liveCatchup.IsEnabled() || !m_timingStream || m_adaptiveTree->IsChangingPeriod())
+    return;
+
+  const auto now = std::chrono::steady_clock::now();
+  if (now - m_liveCatchupCheckTime < LIVE_CATCHUP_CHECK_INTERVAL)
+    return;
+  m_liveCatchupCheckTime = now;
+
+  const uint64_t liveEdgeTime = GetLiveEdgeTimeMs();
+  const uint64_t chapterStartTime = GetChapterStartTime();
+  if (liveEdgeTime == 0 || m_elapsedTime < chapterStartTime)
+    return;
+
+  // The position of the last demuxed sample, relative to the chapter start as the live edge
+  const uint64_t position = (m_elapsedTime - chapterStartTime) / 1000;
+  const uint64_t delay = liveEdgeTime > position ? liveEdgeTime - position : 0;
+
+  if (m_isLiveCatchupSuspended)
+  {
+    if (delay > m_liveCatchup.GetConfig().m_maxLatency)
+      return;
+    m_isLiveCatchupSuspended = false;
+  }
+
+  const uint64_t bufferedEndTime = m_timingStream->m_adStream.GetBufferedEndTimeMs();
+  const uint64_t bufferLevel = bufferedEndTime > position ? bufferedEndTime - position : 0;
+
+  switch (m_liveCatchup.Update(delay, bufferLevel))
+  {
+    case CLiveCatchup::Action::SEEK:
+    {
+      const uint64_t targetDelay = m_liveCatchup.GetConfig().m_targetLatency;
+      const uint64_t seekTime = liveEdgeTime > targetDelay ? liveEdgeTime - targetDelay : 0;
+      const double seekSecs = static_cast<double>(chapterStartTime / 1000 + seekTime) / 1000;
+      LOG::Log(LOGINFO,
+               "Live catch-up: delay of %llu ms from the live edge, seeking to %.3f secs",
+               delay, seekSecs);
+      SeekTime(seekSecs, 0, false);
+      break;
+    }
+    case CLiveCatchup::Action::ADJUST_RATE:
+      LOG::Log(LOGDEBUG,
+               "Live catch-up: delay of %llu ms from the live edge (buffer %llu ms), "
+               "recommended playback rate %.2f",
+               delay, bufferLevel, m_liveCatchup.GetPlaybackRate());
+      break;
+    default:
+      break;
+  }
+}
+
 uint64_t SESSION::CSession::GetChapterStartTime() const
 {
   uint64_t start_time = 0;
@@ -11,16 +11,25 @@
 #include "Stream.h"
 #include "common/AdaptiveStream.h"
 #include "common/AdaptiveTree.h"
+#include "common/LiveCatchup.h"
 #include "decrypters/IDecrypter.h"
 
 #if defined(ANDROID)
 #include <kodi/platform/android/System.h>
 #endif
 
+#include <chrono>
+#include <deque>
 #include <memory>
+#include <mutex>
 
 class Adaptive_CencSingleSampleDecrypter;
 
+namespace UTILS
+{
+class CThreadPool;
+}
+
 namespace SESSION
 {
 class ATTR_DLL_LOCAL CSession : public adaptive::AdaptiveStreamObserver
@@ -161,6 +170,12 @@ public:
     return m_cdmSessions[index].m_decrypterCaps;
   };
 
+  /*! \brief Get the worker threads used by the sample readers to decrypt samples ahead,
+   *         created at first use, the pool is joined when the session is deleted
+   *  \return The thread pool, or nullptr if the decrypt ahead is disabled
+   */
+  UTILS::CThreadPool* GetDecryptAheadPool();
+
   /*! \brief Get the total time in ms of the stream
    *  \return The total time in ms of the stream
    */
@@ -224,6 +239,12 @@ public:
    */
   bool IsLive() const { return m_adaptiveTree->IsLive(); };
 
+  /*! \brief Get the playback rate recommended by the live catch-up to keep
+   *         the delay from the live edge within the configured band
+   *  \return The playback rate, 1.0 for the normal speed
+   */
+  double GetLiveCatchupRate() const { return m_liveCatchup.GetPlaybackRate(); };
+
   /*! \brief Get the mask of included streams
    *  \return A 32 uint with bits set of 'included' streams
    */
@@ -318,6 +339,14 @@ public:
    */
   void OnStreamChange(adaptive::AdaptiveStream* adStream) override;
 
+  /*! \brief Notify a new event signalled by the segments of a stream.
+   *         To be called from the stream download thread when a segment has an event message.
+   *  \param adStream The adaptive stream that has signalled the event
+   *  \param event The event message
+   */
+  void OnEventMessage(adaptive::AdaptiveStream* adStream,
+                      const PLAYLIST::CEventMessage& event) override;
+
   /*!
    * \brief Callback from CInputStreamAdaptive::GetStream.
    * \param streamid The requested stream id
@@ -347,6 +376,26 @@ protected:
                                    const std::vector<std::string_view>& keySystems);
 
 private:
+  /*! \brief Get the live edge time, from the end of the timeline of the enabled streams
+   *  \return The live edge time in ms, relative to the current chapter/period start
+   */
+  uint64_t GetLiveEdgeTimeMs();
+
+  /*! \brief Configure the live catch-up from the manifest and Kodi properties
+   */
+  void InitializeLiveCatchup();
+
+  /*! \brief Periodically check the delay from the live edge, to seek or change
+   *         the recommended playback rate when it is out of the live catch-up band
+   */
+  void CheckLiveCatchup();
+
+  /*! \brief Notify an event of the manifest or of the segments, the events already
+   *         notified by other streams or by previous segments are ignored
+   *  \param event The event message
+   */
+  void NotifyEventMessage(const PLAYLIST::CEventMessage& event);
+
   std::shared_ptr<DRM::IDecrypter> m_decrypter;
 
   struct CCdmSession
@@ -356,6 +405,8 @@ private:
     std::string m_sessionId;
   };
   std::vector<CCdmSession> m_cdmSessions;
+  // Must be destroyed after the streams, since the readers submit decryptions to it
+  std::unique_ptr<UTILS::CThreadPool> m_decryptAheadPool;
 
   adaptive::AdaptiveTree* m_adaptiveTree{nullptr};
   CHOOSER::IRepresentationChooser* m_reprChooser{nullptr};
@@ -367,6 +418,13 @@ private:
   uint64_t m_elapsedTime{0};
   uint64_t m_chapterStartTime{0}; // In STREAM_TIME_BASE
   double m_chapterSeekTime{0.0}; // In seconds
+  adaptive::CLiveCatchup m_liveCatchup;
+  std::chrono::steady_clock::time_point m_liveCatchupCheckTime;
+  // The user has seeked far from the live edge, the catch-up is suspended until back near it
+  bool m_isLiveCatchupSuspended{false};
+  // The last events notified, guarded by m_eventMessagesMutex
+  std::deque<PLAYLIST::CEventMessage> m_eventMessages;
+  std::mutex m_eventMessagesMutex;
   uint8_t m_mediaTypeMask{0};
 };
 } // namespace SESSION
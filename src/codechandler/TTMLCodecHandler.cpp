@@ -46,7 +46,7 @@ void TTMLCodecHandler::SetPTSOffset(AP4_UI64 offset)
 }
 
 TTMLCodecHandler::TTMLCodecHandler(AP4_SampleDescription* sd, bool isFile)
-  : CodecHandler(sd), m_ttml(isFile)
+  : CodecHandler(sd), m_ttml(isFile), m_isFile(isFile)
 {
   // For Miscrosoft Smooth Streaming, the subtitle time is relative to sample time,
   // in this case its needed apply an offset.
@@ -58,5 +58,10 @@ bool TTMLCodecHandler::Transform(AP4_UI64 pts,
                                  AP4_DataBuffer& buf,
                                  AP4_UI64 timescale)
 {
+  // The data of a "sidecar" file is not used after the transform,
+  // so it can be parsed in-situ without make a copy of the whole file
+  if (m_isFile)
+    return m_ttml.ParseInPlace(buf.UseData(), buf.GetDataSize(), timescale);
+
   return m_ttml.Parse(buf.GetData(), buf.GetDataSize(), timescale);
 }
@@ -32,4 +32,5 @@ private:
   TTML2SRT m_ttml;
   AP4_UI64 m_ptsOffset{0};
   bool m_isTimeRelative;
+  bool m_isFile;
 };
@@ -13,6 +13,7 @@
 #include "utils/XMLUtils.h"
 #include "utils/log.h"
 
+#include <algorithm>
 #include <cstring>
 
 using namespace pugi;
@@ -20,17 +21,18 @@ using namespace UTILS;
 
 bool TTML2SRT::Parse(const void* buffer, size_t bufferSize, uint64_t timescale)
 {
-  m_currSubPos = 0;
-  m_seekTime = NO_PTS;
-  m_subtitlesList.clear();
-  m_timescale = timescale;
-  m_styles.clear();
-  m_styleStack.resize(1); // Add empty style
+  ResetParser(timescale);
 
-  if (!ParseData(buffer, bufferSize))
-    return false;
+  xml_document doc;
+  return ParseData(doc, doc.load_buffer(buffer, bufferSize));
+}
 
-  return true;
+bool TTML2SRT::ParseInPlace(void* buffer, size_t bufferSize, uint64_t timescale)
+{
+  ResetParser(timescale);
+
+  xml_document doc;
+  return ParseData(doc, doc.load_buffer_inplace(buffer, bufferSize));
 }
 
 bool TTML2SRT::TimeSeek(uint64_t seekPos)
@@ -42,8 +44,11 @@ bool TTML2SRT::TimeSeek(uint64_t seekPos)
 void TTML2SRT::Reset()
 {
   m_subtitlesList.clear();
+  m_textPool.clear();
   m_currSubPos = 0;
-  m_lastSubFeed = SubtitleData();
+  m_lastSubFeedStart = NO_PTS;
+  m_lastSubFeedEnd = NO_PTS;
+  m_preparedSubText.clear();
 }
 
 bool TTML2SRT::Prepare(uint64_t& pts, uint32_t& duration)
@@ -54,12 +59,13 @@ bool TTML2SRT::Prepare(uint64_t& pts, uint32_t& duration)
   {
     // For cases of single "sidecar" file's
     // there is stored whole file in memory, so its needed to find the position
-    // of the first subtitle that fall into the seek time
-    m_currSubPos = 0;
-    while (m_currSubPos < m_subtitlesList.size() && m_subtitlesList[m_currSubPos].end < m_seekTime)
-    {
-      m_currSubPos++;
-    }
+    // of the first subtitle that fall into the seek time.
+    // The max end time never decreases along the list, so a binary search on it
+    // finds the same position of the first subtitle that ends after the seek time
+    auto itSub = std::partition_point(m_subtitlesList.begin(), m_subtitlesList.end(),
+                                      [this](const SubtitleData& sub)
+                                      { return sub.maxEnd < m_seekTime; });
+    m_currSubPos = static_cast<size_t>(std::distance(m_subtitlesList.begin(), itSub));
 
     m_seekTime = NO_PTS;
   }
@@ -67,12 +73,13 @@ bool TTML2SRT::Prepare(uint64_t& pts, uint32_t& duration)
   if (m_currSubPos >= m_subtitlesList.size())
     return false;
 
-  SubtitleData& sub = m_subtitlesList[m_currSubPos++];
+  const SubtitleData& sub = m_subtitlesList[m_currSubPos++];
+  const std::string_view subText{m_textPool.data() + sub.textPos, sub.textSize};
 
   // Some segmented TTML repeat the last cue on the next segment packet(s)
   // this causes a doubling of the text displayed on the screen, so skip it
-  if (sub.start == m_lastSubFeed.start && sub.end == m_lastSubFeed.end &&
-      sub.text == m_lastSubFeed.text)
+  if (sub.start == m_lastSubFeedStart && sub.end == m_lastSubFeedEnd &&
+      subText == m_preparedSubText)
   {
     return false;
   }
@@ -80,17 +87,26 @@ bool TTML2SRT::Prepare(uint64_t& pts, uint32_t& duration)
   pts = sub.start;
   duration = static_cast<uint32_t>(sub.end - sub.start);
 
-  m_preparedSubText = sub.text;
-  m_lastSubFeed = sub;
+  m_preparedSubText = subText;
+  m_lastSubFeedStart = sub.start;
+  m_lastSubFeedEnd = sub.end;
 
   return true;
 }
 
-bool TTML2SRT::ParseData(const void* buffer, size_t bufferSize)
+void TTML2SRT::ResetParser(uint64_t timescale)
 {
-  xml_document doc;
-  xml_parse_result parseRes = doc.load_buffer(buffer, bufferSize);
+  m_currSubPos = 0;
+  m_seekTime = NO_PTS;
+  m_subtitlesList.clear();
+  m_textPool.clear();
+  m_timescale = timescale;
+  m_styles.clear();
+  m_styleStack.resize(1); // Add empty style
+}
 
+bool TTML2SRT::ParseData(const pugi::xml_document& doc, const pugi::xml_parse_result& parseRes)
+{
   if (parseRes.status != status_ok)
   {
     LOG::LogF(LOGERROR, "Failed to parse XML data, error code: %i", parseRes.status);
@@ -174,7 +190,9 @@ void TTML2SRT::ParseTagBody(pugi::xml_node nodeTT)
       // Parse additional style attributes of node and add them as another style stack
       StackStyle(ParseStyle(nodeP));
 
-      std::string subText;
+      // The text is appended directly to the text pool, to avoid a string allocation for each <p>
+      const size_t textPos = m_textPool.size();
+      std::string& subText = m_textPool;
       // NOTE: subtitle text is contained as children of the <p> tag as PCDATA type
       // so we treat the text as XML nodes
       for (pugi::xml_node subTextNode : nodeP.children())
@@ -200,7 +218,7 @@ void TTML2SRT::ParseTagBody(pugi::xml_node nodeTT)
 
       UnstackStyle();
       UnstackStyle();
-      StackSubtitle(id, beginTime, endTime, subText);
+      StackSubtitle(id, beginTime, endTime, textPos);
     }
   }
 }
@@ -240,33 +258,48 @@ void TTML2SRT::AppendStyledText(std::string_view textPart, std::string& subText)
 {
   if (!textPart.empty())
   {
-    std::string strFmt;
-    std::string strFmtEnd;
-    Style& curStyle = m_styleStack.back();
+    const StyleTags& tags = GetStyleTags(m_styleStack.back());
+    subText += tags.begin;
+    subText += textPart;
+    subText += tags.end;
+  }
+}
+
+const TTML2SRT::StyleTags& TTML2SRT::GetStyleTags(Style& style)
+{
+  if (style.tagsIndex == NO_STYLE_TAGS)
+  {
+    StyleTags tags;
 
-    if (!curStyle.color.empty())
+    if (!style.color.empty())
     {
-      strFmt = "<font color=\"" + curStyle.color + "\">";
-      strFmtEnd = "</font>";
+      tags.begin = "<font color=\"" + style.color + "\">";
+      tags.end = "</font>";
     }
-    if (curStyle.isFontBold.has_value() && *curStyle.isFontBold)
+    if (style.isFontBold.has_value() && *style.isFontBold)
     {
-      strFmt += "<b>";
-      strFmtEnd = "</b>" + strFmtEnd;
+      tags.begin += "<b>";
+      tags.end = "</b>" + tags.end;
     }
-    if (curStyle.isFontItalic.has_value() && *curStyle.isFontItalic)
+    if (style.isFontItalic.has_value() && *style.isFontItalic)
     {
-      strFmt += "<i>";
-      strFmtEnd = "</i>" + strFmtEnd;
+      tags.begin += "<i>";
+      tags.end = "</i>" + tags.end;
     }
-    if (curStyle.isFontUnderline.has_value() && *curStyle.isFontUnderline)
+    if (style.isFontUnderline.has_value() && *style.isFontUnderline)
     {
-      strFmt += "<u>";
-      strFmtEnd = "</u>" + strFmtEnd;
+      tags.begin += "<u>";
+      tags.end = "</u>" + tags.end;
     }
 
-    subText += strFmt + textPart.data() + strFmtEnd;
+    // The end tags depend only on the begin tags, so the begin tags identify the style format
+    auto [itIndex, isInserted] = m_styleTagsIndex.try_emplace(tags.begin, m_styleTags.size());
+    if (isInserted)
+      m_styleTags.emplace_back(std::move(tags));
+
+    style.tagsIndex = itIndex->second;
   }
+  return m_styleTags[style.tagsIndex];
 }
 
 TTML2SRT::Style TTML2SRT::ParseStyle(pugi::xml_node node)
@@ -305,16 +338,12 @@ TTML2SRT::Style TTML2SRT::ParseStyle(pugi::xml_node node)
 
 void TTML2SRT::StackStyle(const Style& style)
 {
+  const Style& lastStyle = m_styleStack.back();
   // Get last style add and merge with the style found
-  Style newStyle = m_styleStack.back();
+  Style newStyle = lastStyle;
 
   if (!style.id.empty())
-  {
-    if (style.id.empty())
-      newStyle.id += "_nested";
-    else
-      newStyle.id = style.id;
-  }
+    newStyle.id = style.id;
 
   if (!style.color.empty())
     newStyle.color = style.color;
@@ -328,37 +357,25 @@ void TTML2SRT::StackStyle(const Style& style)
   if (style.isFontUnderline.has_value())
     newStyle.isFontUnderline = style.isFontUnderline;
 
-  m_styleStack.emplace_back(newStyle);
+  // The interned format tags of the last style can be reused only if the format is unchanged
+  if (newStyle.color != lastStyle.color || newStyle.isFontBold != lastStyle.isFontBold ||
+      newStyle.isFontItalic != lastStyle.isFontItalic ||
+      newStyle.isFontUnderline != lastStyle.isFontUnderline)
+  {
+    newStyle.tagsIndex = NO_STYLE_TAGS;
+  }
+
+  m_styleStack.emplace_back(std::move(newStyle));
 }
 
 void TTML2SRT::StackStyle(std::string_view styleId)
 {
   if (!styleId.empty())
   {
-    auto itStyle = std::find_if(m_styles.begin(), m_styles.end(),
-                                [&styleId](const Style& item) { return item.id == styleId; });
-
+    auto itStyle = m_styles.find(std::string(styleId));
     if (itStyle != m_styles.end())
     {
-      // Get last style add and merge with the style found
-      Style newStyle = m_styleStack.back();
-
-      if (!itStyle->id.empty())
-        newStyle.id = itStyle->id;
-
-      if (!itStyle->color.empty())
-        newStyle.color = itStyle->color;
-
-      if (itStyle->isFontBold.has_value())
-        newStyle.isFontBold = itStyle->isFontBold;
-
-      if (itStyle->isFontItalic.has_value())
-        newStyle.isFontItalic = itStyle->isFontItalic;
-
-      if (itStyle->isFontUnderline.has_value())
-        newStyle.isFontUnderline = itStyle->isFontUnderline;
-
-      m_styleStack.emplace_back(newStyle);
+      StackStyle(itStyle->second);
       return;
     }
   }
@@ -373,21 +390,28 @@ void TTML2SRT::UnstackStyle()
 void TTML2SRT::StackSubtitle(std::string_view id,
                              std::string_view beginTime,
                              std::string_view endTime,
-                             std::string_view text)
+                             size_t textPos)
 {
   if (beginTime.empty() || endTime.empty())
+  {
+    m_textPool.resize(textPos); // Discard the subtitle text
     return;
+  }
 
   // Don't stack subtitle if begin and end are equal
   if (beginTime == endTime)
+  {
+    m_textPool.resize(textPos);
     return;
+  }
 
   SubtitleData newSub;
   newSub.start = GetTime(beginTime);
   newSub.end = GetTime(endTime);
-  newSub.text = text;
+  newSub.textPos = static_cast<uint32_t>(textPos);
+  newSub.textSize = static_cast<uint32_t>(m_textPool.size() - textPos);
 
-  if (!m_subtitlesList.empty() && !newSub.text.empty())
+  if (!m_subtitlesList.empty() && newSub.textSize > 0)
   {
     // This is a workaround for Kodi overlapped subtitles rendering,
     // when there are multiple lines of text provided by multiple "p" elements
@@ -404,11 +428,18 @@ void TTML2SRT::StackSubtitle(std::string_view id,
     SubtitleData& lastSub = m_subtitlesList.back();
     if (lastSub.start == newSub.start && lastSub.end == newSub.end)
     {
-      lastSub.text += "<br/>" + newSub.text;
+      // The text of the last subtitle always precedes the new text in the pool
+      constexpr std::string_view lineBreak{"<br/>"};
+      m_textPool.insert(textPos, lineBreak.data(), lineBreak.size());
+      lastSub.textSize += static_cast<uint32_t>(lineBreak.size()) + newSub.textSize;
       return;
     }
   }
 
+  newSub.maxEnd = newSub.end;
+  if (!m_subtitlesList.empty())
+    newSub.maxEnd = std::max(newSub.maxEnd, m_subtitlesList.back().maxEnd);
+
   m_subtitlesList.emplace_back(newSub);
 }
 
@@ -12,6 +12,7 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #ifdef INPUTSTREAM_TEST_BUILD
@@ -23,7 +24,9 @@
 // Forward
 namespace pugi
 {
+class xml_document;
 class xml_node;
+struct xml_parse_result;
 }
 
 constexpr uint64_t NO_PTS = ~0;
@@ -36,6 +39,16 @@ public:
 
   bool Parse(const void* buffer, size_t bufferSize, uint64_t timescale);
 
+  /*!
+   * \brief Parse the TTML data in-situ, without make a copy of the data,
+   *        the buffer content is modified and cannot be used after the call.
+   * \param buffer The writable TTML data buffer
+   * \param bufferSize The buffer size
+   * \param timescale The timescale of the subtitle times
+   * \return True if success, otherwise false
+   */
+  bool ParseInPlace(void* buffer, size_t bufferSize, uint64_t timescale);
+
   bool TimeSeek(uint64_t seekPos);
 
   void Reset();
@@ -45,11 +58,14 @@ public:
   size_t GetPreparedDataSize() const { return m_preparedSubText.size(); }
 
 private:
-  bool ParseData(const void* buffer, size_t bufferSize);
+  void ResetParser(uint64_t timescale);
+  bool ParseData(const pugi::xml_document& doc, const pugi::xml_parse_result& parseRes);
   void ParseTagHead(pugi::xml_node nodeHead);
   void ParseTagBody(pugi::xml_node nodeTT);
   void ParseTagSpan(pugi::xml_node spanNode, std::string& subText);
 
+  static constexpr size_t NO_STYLE_TAGS = ~static_cast<size_t>(0);
+
   struct Style
   {
     std::string id;
@@ -57,22 +73,45 @@ private:
     std::optional<bool> isFontItalic;
     std::optional<bool> isFontBold;
     std::optional<bool> isFontUnderline;
+    size_t tagsIndex{NO_STYLE_TAGS}; // Index of the interned text format tags, if resolved
+  };
+
+  // Text format tags of a style, e.g. "<font color="white"><b>" and "</b></font>"
+  struct StyleTags
+  {
+    std::string begin;
+    std::string end;
   };
 
   void AppendStyledText(std::string_view textPart, std::string& subText);
 
+  /*!
+   * \brief Get the text format tags of a style, the tags are interned
+   *        so they are built once for all the text parts that share the same style.
+   * \param style The style, the resolved tags index is cached on it
+   * \return The text format tags
+   */
+  const StyleTags& GetStyleTags(Style& style);
+
   Style ParseStyle(pugi::xml_node node);
 
-  void InsertStyle(const Style& style) { m_styles.emplace_back(style); }
+  void InsertStyle(const Style& style) { m_styles.emplace(style.id, style); }
 
   void StackStyle(const Style& style);
   void StackStyle(std::string_view styleId);
   void UnstackStyle();
 
+  /*!
+   * \brief Add a subtitle, its text must be already appended to the text pool.
+   * \param id The subtitle id
+   * \param beginTime The begin time expression
+   * \param endTime The end time expression
+   * \param textPos The position of the subtitle text in the text pool
+   */
   void StackSubtitle(std::string_view id,
                      std::string_view beginTime,
                      std::string_view endTime,
-                     std::string_view text);
+                     size_t textPos);
 
   uint64_t GetTime(std::string_view timeExpr);
 
@@ -80,15 +119,22 @@ private:
   {
     uint64_t start{0};
     uint64_t end{0};
-    std::string text;
+    uint64_t maxEnd{0}; // Max end time of all subtitles up to this one, for the seek search
+    uint32_t textPos{0}; // Text position in the text pool
+    uint32_t textSize{0};
   };
 
   size_t m_currSubPos{0};
   std::vector<SubtitleData> m_subtitlesList;
-  SubtitleData m_lastSubFeed; // Last subtitle fed to Kodi demuxer
+  std::string m_textPool; // The text of all subtitles, stored contiguously
+  // Times of the last subtitle fed to Kodi demuxer, its text is m_preparedSubText
+  uint64_t m_lastSubFeedStart{NO_PTS};
+  uint64_t m_lastSubFeedEnd{NO_PTS};
 
-  std::vector<Style> m_styles;
+  std::unordered_map<std::string, Style> m_styles; // Styles defined on <head>, by style id
   std::vector<Style> m_styleStack;
+  std::vector<StyleTags> m_styleTags; // Interned text format tags
+  std::unordered_map<std::string, size_t> m_styleTagsIndex; // Begin tags to m_styleTags index
 
   std::string m_preparedSubText;
 
@@ -53,3 +53,53 @@ AP4_Result CAdaptiveCencSampleDecrypter::DecryptSampleData(AP4_UI32 poolid,
     return m_decrypter->DecryptSampleData(poolid, data_in, data_out, iv_block, subsample_count,
                                           bytes_of_cleartext_data, bytes_of_encrypted_data);
   }
+
+void CAdaptiveCencSampleDecrypter::SetSampleInfoTable(AP4_CencSampleInfoTable* sampleInfoTable)
+{
+  delete m_SampleInfoTable;
+  m_SampleInfoTable = sampleInfoTable;
+  m_SampleCursor = 0;
+}
+
+AP4_Result CAdaptiveCencSampleDecrypter::GetNextSampleCryptoData(CencSampleCryptoData& cryptoData)
+{
+  // increment the sample cursor
+  unsigned int sampleCursor = m_SampleCursor++;
+
+  const AP4_UI08* iv = m_SampleInfoTable->GetIv(sampleCursor);
+  if (!iv)
+    return AP4_ERROR_INVALID_FORMAT;
+
+  unsigned int ivSize = m_SampleInfoTable->GetIvSize();
+  AP4_CopyMemory(cryptoData.m_iv, iv, ivSize);
+  if (ivSize != 16)
+    AP4_SetMemory(&cryptoData.m_iv[ivSize], 0, 16 - ivSize);
+
+  unsigned int subsampleCount = 0;
+  const AP4_UI16* bytesOfCleartextData = nullptr;
+  const AP4_UI32* bytesOfEncryptedData = nullptr;
+  AP4_Result result = m_SampleInfoTable->GetSampleInfo(sampleCursor, subsampleCount,
+                                                       bytesOfCleartextData, bytesOfEncryptedData);
+  if (AP4_FAILED(result))
+    return result;
+
+  cryptoData.m_bytesOfCleartextData.assign(bytesOfCleartextData,
+                                           bytesOfCleartextData + subsampleCount);
+  cryptoData.m_bytesOfEncryptedData.assign(bytesOfEncryptedData,
+                                           bytesOfEncryptedData + subsampleCount);
+  return AP4_SUCCESS;
+}
+
+AP4_Result CAdaptiveCencSampleDecrypter::DecryptSampleData(AP4_UI32 poolid,
+                                                           AP4_DataBuffer& data_in,
+                                                           AP4_DataBuffer& data_out,
+                                                           const CencSampleCryptoData& cryptoData)
+{
+  const unsigned int subsampleCount =
+      static_cast<unsigned int>(cryptoData.m_bytesOfCleartextData.size());
+
+  return m_decrypter->DecryptSampleData(
+      poolid, data_in, data_out, cryptoData.m_iv, subsampleCount,
+      subsampleCount > 0 ? cryptoData.m_bytesOfCleartextData.data() : nullptr,
+      subsampleCount > 0 ? cryptoData.m_bytesOfEncryptedData.data() : nullptr);
+}
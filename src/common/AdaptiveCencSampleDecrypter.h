@@ -9,9 +9,20 @@
 #include "AdaptiveDecrypter.h"
 
 #include <memory>
+#include <vector>
 
 #include <bento4/Ap4.h>
 
+/*!
+ * \brief The CENC data needed to decrypt a single sample, independently from the sample table.
+ */
+struct CencSampleCryptoData
+{
+  AP4_UI08 m_iv[16];
+  std::vector<AP4_UI16> m_bytesOfCleartextData;
+  std::vector<AP4_UI32> m_bytesOfEncryptedData;
+};
+
 class CAdaptiveCencSampleDecrypter : public AP4_CencSampleDecrypter
 {
 public:
@@ -24,6 +35,30 @@ public:
                                        AP4_DataBuffer& data_out,
                                        const AP4_UI08* iv);
 
+  /*!
+   * \brief Replace the sample info table, to reuse the decrypter with a new fragment,
+   *        the sample cursor is moved to the first sample.
+   * \param sampleInfoTable The sample info table of the new fragment, the ownership is taken
+   */
+  void SetSampleInfoTable(AP4_CencSampleInfoTable* sampleInfoTable);
+
+  /*!
+   * \brief Get the CENC data of the next sample and increment the sample cursor,
+   *        so that the sample can be decrypted later by using the CENC data.
+   * \param cryptoData [OUT] The sample CENC data
+   * \return AP4_SUCCESS if has success, otherwise an error code
+   */
+  AP4_Result GetNextSampleCryptoData(CencSampleCryptoData& cryptoData);
+
+  /*!
+   * \brief Decrypt a sample by using CENC data previously obtained.
+   *        Can be called concurrently when the single sample decrypter support it.
+   */
+  AP4_Result DecryptSampleData(AP4_UI32 poolid,
+                               AP4_DataBuffer& data_in,
+                               AP4_DataBuffer& data_out,
+                               const CencSampleCryptoData& cryptoData);
+
 protected:
   std::shared_ptr<Adaptive_CencSingleSampleDecrypter> m_decrypter;
 };
@@ -56,4 +56,9 @@ public:
   virtual AP4_UI32 AddPool() { return 0; }
   virtual void RemovePool(AP4_UI32 poolId) {}
   virtual std::string GetSessionId() { return {}; }
+
+  /*! \brief Check if DecryptSampleData can be called concurrently by multiple threads
+   *  \return True if supported, otherwise false
+   */
+  virtual bool IsConcurrentDecryptSupported() { return false; }
 };
@@ -10,7 +10,7 @@
 
 #include "AdaptiveTree.h"
 #ifndef INPUTSTREAM_TEST_BUILD
-#include "demuxers/WebmReader.h"
+#include "demuxers/WebmCues.h"
 #endif
 #include "Chooser.h"
 #include "CompKodiProps.h"
@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 
@@ -36,6 +37,26 @@ using namespace kodi::tools;
 using namespace PLAYLIST;
 using namespace UTILS;
 
+namespace
+{
+// Max number of index ranges of other representations downloaded at same time
+constexpr size_t INDEX_PREFETCH_THREADS = 2;
+// Limits of the consecutive segments byte ranges merged in a single request
+constexpr uint64_t MAX_COALESCED_BYTES = 2 * 1024 * 1024;
+constexpr uint64_t MAX_COALESCED_DURATION_SECS = 10;
+// Interval to check the manifest updates for the new parts of low latency segments
+constexpr std::chrono::milliseconds PARTS_POLL_INTERVAL{50};
+// Max time to wait for the new parts of low latency segments, as number of part durations
+constexpr uint64_t MAX_PARTS_WAIT = 10;
+
+bool IsCoalescableSegment(const CRepresentation* rep, const CSegment& segment)
+{
+  // Only the segments of a single file, where the subsegments are stored one after the other
+  return rep->HasSegmentBase() && !segment.IsInitialization() && segment.HasByteRange() &&
+         segment.range_end_ != NO_VALUE && segment.range_end_ >= segment.range_begin_;
+}
+} // unnamed namespace
+
 uint32_t AdaptiveStream::globalClsId = 0;
 
 AdaptiveStream::AdaptiveStream(AdaptiveTree* tree,
@@ -69,6 +90,11 @@ AdaptiveStream::AdaptiveStream(AdaptiveTree* tree,
 
 AdaptiveStream::~AdaptiveStream()
 {
+  // Skip the index prefetch not started yet, and cancel the downloads in progress,
+  // e.g. on period change, so the destruction is not delayed
+  m_isIndexPrefetchStopped = true;
+  m_indexPrefetchPool.reset();
+
   Stop();
   DisposeWorker();
   clear();
@@ -142,13 +168,24 @@ bool adaptive::AdaptiveStream::DownloadImpl(const DownloadInfo& downloadInfo,
   else if (statusCode >= 400)
     LOG::Log(LOGERROR, "[AS-%u] Download failed, HTTP error %d: %s", clsId, statusCode,
              url.c_str());
+  else if (downloadInfo.m_isResumed && statusCode != 206)
+  {
+    // The server ignored the range, the data would be appended again from the start
+    LOG::Log(LOGERROR, "[AS-%u] Download failed, cannot resume (HTTP status %d): %s", clsId,
+             statusCode, url.c_str());
+  }
   else // Start the download
   {
     CURL::ReadStatus downloadStatus = CURL::ReadStatus::CHUNK_READ;
     bool isChunked = curl.IsChunked();
+    // The segment buffer in download, when the byte ranges of more segments are coalesced
+    size_t coalescedIndex{0};
 
     while (downloadStatus == CURL::ReadStatus::CHUNK_READ)
     {
+      if (downloadInfo.m_isCancelled && *downloadInfo.m_isCancelled)
+        break;
+
       std::vector<uint8_t> bufferData(CURL::BUFFER_SIZE_32);
       size_t bytesRead{0};
 
@@ -164,7 +201,9 @@ bool adaptive::AdaptiveStream::DownloadImpl(const DownloadInfo& downloadInfo,
         {
           // We only set lastChunk to true in the case of non-chunked transfers, the
           // current structure does not allow for knowing the file has finished for
-          // chunked transfers here - IsEOF() will return true while doing chunked transfers
+          // chunked transfers here - IsEOF() will return true while doing chunked transfers.
+          // The data is appended to the segment buffer as it arrives, so the demuxer can
+          // read the chunks (e.g. CMAF moof/mdat pairs) while the segment is in download
           bool isLastChunk = !isChunked && curl.IsEOF();
           {
             std::lock_guard<std::mutex> lckrw(thread_data_->mutex_rw_);
@@ -173,12 +212,20 @@ bool adaptive::AdaptiveStream::DownloadImpl(const DownloadInfo& downloadInfo,
             if (state_ == STOPPED)
               break;
 
-            std::vector<uint8_t>& segmentBuffer = downloadInfo.m_segmentBuffer->buffer;
-
-            m_tree->OnDataArrived(downloadInfo.m_segmentBuffer->segment_number,
-                                  downloadInfo.m_segmentBuffer->segment.pssh_set_, m_decrypterIv,
-                                  bufferData.data(), bytesRead, segmentBuffer, segmentBuffer.size(),
-                                  isLastChunk);
+            if (downloadInfo.m_coalescedBuffers.empty())
+            {
+              std::vector<uint8_t>& segmentBuffer = downloadInfo.m_segmentBuffer->buffer;
+
+              m_tree->OnDataArrived(downloadInfo.m_segmentBuffer->segment_number,
+                                    downloadInfo.m_segmentBuffer->segment.pssh_set_,
+                                    m_decrypterIv, bufferData.data(), bytesRead, segmentBuffer,
+                                    segmentBuffer.size(), isLastChunk);
+            }
+            else
+            {
+              WriteCoalescedData(downloadInfo, coalescedIndex, bufferData.data(), bytesRead,
+                                 isLastChunk);
+            }
           }
           thread_data_->signal_rw_.notify_all();
         }
@@ -208,8 +255,19 @@ bool adaptive::AdaptiveStream::DownloadImpl(const DownloadInfo& downloadInfo,
       // Set current download speed to repr. chooser (to update average).
       // Small files are usually subtitles and their download speed are inaccurate
       // by causing side effects in the average bandwidth so we ignore them.
+      // Low latency segments in production are delivered in chunks at the encoding rate,
+      // so their download speed is not related to the bandwidth and are ignored too,
+      // unless the segments are signalled as complete when available (availabilityTimeComplete)
       static const size_t minSize{512 * 1024}; // 512 Kbyte
-      if (totalBytesRead > minSize)
+      bool isLowLatencyChunked = isChunked && m_tree->m_lowLatencyDelay != NO_VALUE;
+      const SEGMENTBUFFER* segBuffer = downloadInfo.m_segmentBuffer;
+      if (isLowLatencyChunked && segBuffer && segBuffer->rep &&
+          segBuffer->rep->HasSegmentTemplate() &&
+          segBuffer->rep->GetSegmentTemplate()->IsAvailabilityTimeComplete())
+      {
+        isLowLatencyChunked = false;
+      }
+      if (totalBytesRead > minSize && !isLowLatencyChunked)
         m_tree->GetRepChooser()->SetDownloadSpeed(downloadSpeed);
 
       LOG::Log(LOGDEBUG, "[AS-%u] Download finished: %s (downloaded %zu byte, speed %0.2lf byte/s)",
@@ -233,7 +291,141 @@ bool AdaptiveStream::PrepareNextDownload(DownloadInfo& downloadInfo)
   segBuffer->buffer.clear();
   downloadInfo.m_segmentBuffer = segBuffer;
 
-  return PrepareDownload(segBuffer->rep, segBuffer->segment, downloadInfo);
+  const CSegment& segment = segBuffer->segment;
+  if (m_startPartSegNumber != SEGMENT_NO_NUMBER && segment.m_number == m_startPartSegNumber)
+  {
+    downloadInfo.m_partIndex = m_startPartIndex;
+    downloadInfo.m_firstPartIndex = m_startPartIndex;
+    m_startPartSegNumber = SEGMENT_NO_NUMBER;
+  }
+
+  // The segment in production can be downloaded by parts only
+  if (segment.m_isPartial || downloadInfo.m_partIndex > 0)
+  {
+    downloadInfo.m_isPartsDownload = true;
+    return true;
+  }
+
+  if (!IsCoalescableSegment(segBuffer->rep, segBuffer->segment))
+    return PrepareDownload(segBuffer->rep, segBuffer->segment, downloadInfo);
+
+  // Merge the following queued segments with contiguous byte ranges in a single request,
+  // their segment buffers are filled in order and become valid when the download reach them
+  CSegment rangeSegment = segBuffer->segment;
+  uint64_t totalBytes = rangeSegment.range_end_ - rangeSegment.range_begin_ + 1;
+  uint64_t totalDuration = rangeSegment.m_endPts - rangeSegment.startPTS_;
+  const uint64_t maxDuration = MAX_COALESCED_DURATION_SECS * segBuffer->rep->GetTimescale();
+
+  for (size_t index = valid_segment_buffers_; index < available_segment_buffers_; ++index)
+  {
+    SEGMENTBUFFER* nextBuffer = segment_buffers_[index];
+    const CSegment& nextSegment = nextBuffer->segment;
+
+    if (nextBuffer->rep != segBuffer->rep ||
+        !IsCoalescableSegment(nextBuffer->rep, nextSegment) ||
+        nextSegment.range_begin_ != rangeSegment.range_end_ + 1)
+    {
+      break;
+    }
+
+    totalBytes += nextSegment.range_end_ - nextSegment.range_begin_ + 1;
+    totalDuration += nextSegment.m_endPts - nextSegment.startPTS_;
+    if (totalBytes > MAX_COALESCED_BYTES || totalDuration > maxDuration)
+      break;
+
+    nextBuffer->buffer.clear();
+    downloadInfo.m_coalescedBuffers.emplace_back(nextBuffer);
+    rangeSegment.range_end_ = nextSegment.range_end_;
+  }
+
+  if (!downloadInfo.m_coalescedBuffers.empty())
+  {
+    LOG::Log(LOGDEBUG, "[AS-%u] Coalesced the byte ranges of %zu segments (repr. id \"%s\")",
+             clsId, downloadInfo.m_coalescedBuffers.size() + 1, segBuffer->rep->GetId().data());
+  }
+
+  return PrepareDownload(segBuffer->rep, rangeSegment, downloadInfo);
+}
+
+void AdaptiveStream::WriteCoalescedData(const DownloadInfo& downloadInfo,
+                                        size_t& bufferIndex,
+                                        const uint8_t* data,
+                                        size_t dataSize,
+                                        bool isLastChunk)
+{
+  const size_t lastIndex = downloadInfo.m_coalescedBuffers.size();
+
+  while (dataSize > 0)
+  {
+    SEGMENTBUFFER* segBuffer = bufferIndex == 0 ? downloadInfo.m_segmentBuffer
+                                                : downloadInfo.m_coalescedBuffers[bufferIndex - 1];
+    std::vector<uint8_t>& segmentBuffer = segBuffer->buffer;
+    const CSegment& segment = segBuffer->segment;
+
+    // The last segment buffer takes all remaining data
+    size_t writeSize = dataSize;
+    bool isFull = false;
+    if (bufferIndex < lastIndex)
+    {
+      const uint64_t segmentSize = segment.range_end_ - segment.range_begin_ + 1;
+      const uint64_t remaining =
+          segmentSize - std::min<uint64_t>(segmentBuffer.size(), segmentSize);
+      writeSize = static_cast<size_t>(std::min<uint64_t>(dataSize, remaining));
+      isFull = writeSize == remaining;
+    }
+
+    if (writeSize > 0)
+    {
+      m_tree->OnDataArrived(segBuffer->segment_number, segment.pssh_set_, m_decrypterIv, data,
+                            writeSize, segmentBuffer, segmentBuffer.size(),
+                            isFull || (bufferIndex == lastIndex && isLastChunk));
+      data += writeSize;
+      dataSize -= writeSize;
+    }
+
+    if (isFull)
+    {
+      // The next segment buffer is now in download, so the current one is complete.
+      // As in ensureSegment, mutex_dl_ is locked after mutex_rw_
+      ++bufferIndex;
+      std::lock_guard<std::mutex> lckdl(thread_data_->mutex_dl_);
+      ++valid_segment_buffers_;
+    }
+  }
+}
+
+bool AdaptiveStream::SplitCoalescedDownload(DownloadInfo& downloadInfo)
+{
+  std::lock_guard<std::mutex> lckrw(thread_data_->mutex_rw_);
+
+  // Continue with the segment buffer in download only (the first one not full),
+  // the following ones are not valid yet and will be downloaded with next requests
+  for (SEGMENTBUFFER* coalescedBuffer : downloadInfo.m_coalescedBuffers)
+  {
+    const CSegment& segment = downloadInfo.m_segmentBuffer->segment;
+    if (downloadInfo.m_segmentBuffer->buffer.size() < segment.range_end_ - segment.range_begin_ + 1)
+      break;
+    downloadInfo.m_segmentBuffer = coalescedBuffer;
+  }
+  downloadInfo.m_coalescedBuffers.clear();
+  downloadInfo.m_addHeaders.clear();
+
+  // The segment buffer can be already valid and partially read by the demuxer,
+  // so keep the data received and resume the download from the missing bytes
+  SEGMENTBUFFER* segBuffer = downloadInfo.m_segmentBuffer;
+  CSegment segment = segBuffer->segment;
+  const size_t dataSize = segBuffer->buffer.size();
+  if (dataSize >= segment.range_end_ - segment.range_begin_ + 1)
+    return false; // All data received
+
+  if (dataSize > 0)
+  {
+    segment.range_begin_ += dataSize;
+    LOG::Log(LOGDEBUG, "[AS-%u] Resume the download of segment no. %llu from %zu bytes", clsId,
+             segment.m_number, dataSize);
+  }
+  PrepareDownload(segBuffer->rep, segment, downloadInfo);
+  return true;
 }
 
 bool AdaptiveStream::PrepareDownload(const PLAYLIST::CRepresentation* rep,
@@ -290,6 +482,164 @@ bool AdaptiveStream::PrepareDownload(const PLAYLIST::CRepresentation* rep,
   return true;
 }
 
+bool AdaptiveStream::DownloadSegmentParts(DownloadInfo& downloadInfo)
+{
+  SEGMENTBUFFER* segBuffer = downloadInfo.m_segmentBuffer;
+  const CRepresentation* rep = segBuffer->rep;
+  const uint64_t partDuration =
+      m_tree->m_partDuration != NO_VALUE ? m_tree->m_partDuration : 1000;
+  const auto maxWaitTime = std::chrono::milliseconds(partDuration * MAX_PARTS_WAIT);
+  auto lastProgressTime = std::chrono::steady_clock::now();
+
+  while (state_ != STOPPED && !thread_data_->thread_stop_)
+  {
+    // The segment is updated by the manifest updates, get a copy of the latest one
+    CSegment segment;
+    {
+      std::lock_guard<adaptive::AdaptiveTree::TreeUpdateThread> lckUpdTree(
+          m_tree->GetTreeUpdMutex());
+      const CSegment* timelineSeg = rep->Timeline().Find(segBuffer->segment);
+      if (!timelineSeg)
+      {
+        LOG::LogF(LOGERROR, "[AS-%u] Segment no. %llu not found on the timeline", clsId,
+                  segBuffer->segment.m_number);
+        return false;
+      }
+      segment = *timelineSeg;
+    }
+
+    if (!segment.m_isPartial && downloadInfo.m_partIndex >= segment.m_parts.size())
+    {
+      if (!segment.m_parts.empty())
+        return true; // All parts downloaded
+
+      // The parts are no longer listed, download the remaining data of the whole segment,
+      // the parts have the same data of the segment, that follow one after the other
+      DownloadInfo segmentInfo;
+      segmentInfo.m_segmentBuffer = segBuffer;
+      segmentInfo.m_isCancelled = downloadInfo.m_isCancelled;
+      const size_t dataSize = segBuffer->buffer.size();
+      if (dataSize > 0)
+      {
+        if (!PrepareDownload(rep, segment, segmentInfo))
+          return false;
+
+        // Find the byte position in the segment that follows the data of the parts downloaded
+        uint64_t resumePos = segment.range_begin_ != NO_VALUE ? segment.range_begin_ : 0;
+        if (segmentInfo.m_url == downloadInfo.m_partUrl)
+        {
+          // The parts are byte ranges of the segment resource
+          resumePos = downloadInfo.m_partUrlEnd;
+        }
+        else if (downloadInfo.m_firstPartIndex == 0)
+        {
+          // The parts are separate resources, downloaded all from the first one
+          resumePos += dataSize;
+        }
+        else
+        {
+          // The first parts have been skipped, their size is unknown
+          LOG::Log(LOGERROR,
+                   "[AS-%u] Parts of segment no. %llu no longer listed, cannot resume the download",
+                   clsId, segment.m_number);
+          return false;
+        }
+        segment.range_begin_ = resumePos;
+        segmentInfo.m_addHeaders.clear();
+        LOG::Log(LOGDEBUG,
+                 "[AS-%u] Parts of segment no. %llu no longer listed, resume from byte %llu",
+                 clsId, segment.m_number, resumePos);
+      }
+      return PrepareDownload(rep, segment, segmentInfo) && DownloadSegment(segmentInfo);
+    }
+
+    bool isProgress{false};
+
+    for (; downloadInfo.m_partIndex < segment.m_parts.size(); ++downloadInfo.m_partIndex)
+    {
+      const CSegmentPart& part = segment.m_parts[downloadInfo.m_partIndex];
+
+      CSegment partSegment;
+      partSegment.url = part.m_url;
+      partSegment.range_begin_ = part.m_rangeBegin;
+      partSegment.range_end_ = part.m_rangeEnd;
+
+      DownloadInfo partInfo;
+      partInfo.m_segmentBuffer = segBuffer;
+      partInfo.m_isCancelled = downloadInfo.m_isCancelled;
+      PrepareDownload(rep, partSegment, partInfo);
+
+      // Skip the data already downloaded with a preload hint of the same resource,
+      // or by a previous attempt failed while in download
+      if (partInfo.m_url == downloadInfo.m_partUrl)
+      {
+        const uint64_t urlEnd = downloadInfo.m_partUrlEnd;
+        if (!partSegment.HasByteRange() && !downloadInfo.m_isPartUrlComplete)
+        {
+          // Resume the download of the whole resource from the data received
+          if (urlEnd > 0)
+          {
+            partSegment.range_begin_ = urlEnd;
+            PrepareDownload(rep, partSegment, partInfo);
+            partInfo.m_isResumed = true;
+          }
+        }
+        else if (!partSegment.HasByteRange() ||
+                 (part.m_rangeEnd != NO_VALUE ? part.m_rangeEnd < urlEnd
+                                              : part.m_rangeBegin < urlEnd))
+        {
+          if (part.m_isPreloadHint)
+            break;
+          continue;
+        }
+        if (part.m_rangeBegin < urlEnd)
+        {
+          partSegment.range_begin_ = urlEnd;
+          PrepareDownload(rep, partSegment, partInfo);
+        }
+      }
+
+      const size_t dataSize = segBuffer->buffer.size();
+      const bool isDownloaded = DownloadSegment(partInfo);
+      const size_t partDataSize = segBuffer->buffer.size() - dataSize;
+
+      // Keep track of the data received, also on failure, so that a new attempt
+      // resumes the download from the missing data, without duplicate it in the buffer
+      const uint64_t rangeBegin = partSegment.HasByteRange() ? partSegment.range_begin_ : 0;
+      downloadInfo.m_partUrl = partInfo.m_url;
+      downloadInfo.m_partUrlEnd = rangeBegin + partDataSize;
+      downloadInfo.m_isPartUrlComplete = isDownloaded && part.m_rangeBegin == NO_VALUE;
+
+      if (!isDownloaded)
+        return false;
+
+      isProgress = true;
+
+      // The hint is listed again as part with the next manifest update,
+      // so the index is not increased, its data will be skipped
+      if (part.m_isPreloadHint)
+        break;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (isProgress)
+    {
+      lastProgressTime = now;
+      continue; // The manifest may have been updated in the meantime
+    }
+    if (now - lastProgressTime > maxWaitTime)
+    {
+      LOG::Log(LOGWARNING, "[AS-%u] Timeout on waiting the parts of segment no. %llu", clsId,
+               segment.m_number);
+      return false;
+    }
+
+    // Wait for the next manifest update
+    std::this_thread::sleep_for(PARTS_POLL_INTERVAL);
+  }
+  return false;
+}
+
 void AdaptiveStream::ResetSegment(const PLAYLIST::CSegment* segment)
 {
   segment_read_pos_ = 0;
@@ -316,8 +666,14 @@ void AdaptiveStream::ResetActiveBuffer(bool oneValid)
 
 bool AdaptiveStream::StopWorker(STATE state)
 {
-  // stop downloading chunks
-  state_ = state;
+  // stop downloading chunks, the state is changed with mutex_dl_ locked so that the worker
+  // cannot miss the notification between its state check and the wait of segment availability
+  {
+    std::lock_guard<std::mutex> lckdl(thread_data_->mutex_dl_);
+    state_ = state;
+  }
+  // interrupt the worker if waiting the segment availability
+  thread_data_->signal_dl_.notify_all();
   // wait until last reading operation stopped
   // make sure download section in worker thread is done.
   std::unique_lock<std::mutex> lckrw(thread_data_->mutex_rw_);
@@ -374,6 +730,23 @@ void AdaptiveStream::worker()
 
       // tell the main thread that we have processed prepare_download;
       thread_data_->signal_dl_.notify_one();
+
+      // Wait that the live segment is available on the server, a request made in advance
+      // would fail and fall in the download retry loop below
+      const uint64_t availabilityWait = GetSegmentAvailabilityWait(*downloadInfo.m_segmentBuffer);
+      if (availabilityWait > 0)
+      {
+        LOG::Log(LOGDEBUG, "[AS-%u] Wait %llu ms for the segment availability", clsId,
+                 availabilityWait);
+        const auto endTime =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(availabilityWait);
+
+        while (!thread_data_->thread_stop_ && state_ == RUNNING &&
+               thread_data_->signal_dl_.wait_until(lckdl, endTime) != std::cv_status::timeout)
+        {
+        }
+      }
+
       lckdl.unlock();
 
       //! @todo: for live content we should calculate max attempts and sleep timing
@@ -394,10 +767,21 @@ void AdaptiveStream::worker()
       // then we try downloading the segment more times before aborting playback
       while (state_ != STOPPED)
       {
-        isSegmentDownloaded = DownloadSegment(downloadInfo);
+        if (downloadInfo.m_isPartsDownload)
+          isSegmentDownloaded = DownloadSegmentParts(downloadInfo);
+        else
+          isSegmentDownloaded = DownloadSegment(downloadInfo);
         if (isSegmentDownloaded || downloadAttempts == maxAttempts || state_ == STOPPED)
           break;
 
+        // Retry without coalesced byte ranges, from the segment in download
+        if (!downloadInfo.m_coalescedBuffers.empty() && !SplitCoalescedDownload(downloadInfo))
+        {
+          // The data of the last segment was received before the failure
+          isSegmentDownloaded = true;
+          break;
+        }
+
         //! @todo: forcing thread sleep block the thread also while the state_ / thread_stop_ change values
         //! we have to interrupt the sleep when it happens
         std::this_thread::sleep_for(msSleep);
@@ -405,15 +789,19 @@ void AdaptiveStream::worker()
         LOG::Log(LOGWARNING, "[AS-%u] Segment download failed, attempt %zu...", clsId, downloadAttempts);
       }
 
-      lckdl.lock();
-
-      if (!isSegmentDownloaded)
+      // mutex_rw_ must be locked before mutex_dl_ (as in ensureSegment),
+      // so the segment data is accessed before locking mutex_dl_ again
+      if (isSegmentDownloaded)
+        ProcessEventMessages(downloadInfo);
+      else
       {
         std::lock_guard<std::mutex> lckrw(thread_data_->mutex_rw_);
         // Download cancelled or cannot download the file
         state_ = STOPPED;
       }
 
+      lckdl.lock();
+
       // Signal finished download
       worker_processing_ = false;
       thread_data_->signal_rw_.notify_all();
@@ -424,6 +812,73 @@ void AdaptiveStream::worker()
   lckdl.unlock();
 }
 
+void AdaptiveStream::ProcessEventMessages(const DownloadInfo& downloadInfo)
+{
+  std::vector<CEventMessage> events;
+  {
+    std::lock_guard<std::mutex> lckrw(thread_data_->mutex_rw_);
+
+    std::vector<SEGMENTBUFFER*> segBuffers{downloadInfo.m_segmentBuffer};
+    segBuffers.insert(segBuffers.end(), downloadInfo.m_coalescedBuffers.begin(),
+                      downloadInfo.m_coalescedBuffers.end());
+
+    for (const SEGMENTBUFFER* segBuffer : segBuffers)
+    {
+      const CRepresentation* rep = segBuffer->rep;
+      if (!rep || rep->GetContainerType() != ContainerType::MP4 ||
+          segBuffer->segment.IsInitialization() || rep->GetTimescale() == 0)
+      {
+        continue;
+      }
+      const uint64_t segStartMs = segBuffer->segment.startPTS_ * 1000 / rep->GetTimescale();
+      ParseEventMessages(segBuffer->buffer.data(), segBuffer->buffer.size(), segStartMs, events);
+    }
+  }
+
+  for (const CEventMessage& event : events)
+  {
+    // The MPD has expired, update it now instead of waiting for the update interval
+    if (event.m_schemeIdUri == EVENT_SCHEME_MPD && event.m_value == "1" &&
+        m_mpdEventId != event.m_id)
+    {
+      m_mpdEventId = event.m_id;
+      if (m_tree->HasManifestUpdates())
+      {
+        LOG::Log(LOGDEBUG, "[AS-%u] MPD validity expiration event (id: %u), request the update",
+                 clsId, event.m_id);
+        m_tree->GetTreeUpdMutex().RequestUpdate();
+      }
+    }
+
+    if (observer_)
+      observer_->OnEventMessage(this, event);
+  }
+}
+
+uint64_t AdaptiveStream::GetSegmentAvailabilityWait(const SEGMENTBUFFER& segBuffer)
+{
+  const CSegment& segment = segBuffer.segment;
+  CRepresentation* rep = segBuffer.rep;
+
+  if (!m_tree->IsLive() || !rep || segment.IsInitialization() || rep->GetTimescale() == 0)
+    return 0;
+
+  uint64_t availTime = m_tree->GetSegmentAvailableTime(current_period_, rep, segment);
+  if (availTime == NO_VALUE)
+    return 0;
+
+  availTime += CSrvBroker::GetKodiProps().GetManifestConfig().segmentAvailabilityMargin;
+
+  const uint64_t now = m_tree->GetServerTimestamp();
+  if (availTime <= now)
+    return 0;
+
+  // A wait longer than the segment duration is not expected, e.g. clock not synchronized,
+  // limit it to avoid stalling the playback
+  const uint64_t segDurMs = (segment.m_endPts - segment.startPTS_) * 1000 / rep->GetTimescale();
+  return std::min(availTime - now, segDurMs * 2);
+}
+
 int AdaptiveStream::SecondsSinceUpdate() const
 {
   const std::chrono::time_point<std::chrono::system_clock>& tPoint(
@@ -443,8 +898,9 @@ bool adaptive::AdaptiveStream::IsRequiredCreateMovieAtom()
   return m_tree->GetTreeType() == TreeType::SMOOTH_STREAMING;
 }
 
-bool AdaptiveStream::parseIndexRange(PLAYLIST::CRepresentation* rep,
-                                     const std::vector<uint8_t>& buffer)
+bool AdaptiveStream::parseIndexRange(const PLAYLIST::CRepresentation* rep,
+                                     const std::vector<uint8_t>& buffer,
+                                     IndexRangeData& data)
 {
 #ifndef INPUTSTREAM_TEST_BUILD
   LOG::Log(LOGDEBUG, "[AS-%u] Build segments from SIDX atom...", clsId);
@@ -458,28 +914,23 @@ bool AdaptiveStream::parseIndexRange(PLAYLIST::CRepresentation* rep,
     if (rep->GetSegmentBase()->GetIndexRangeBegin() == 0)
       return false;
 
-    WebmReader reader(&byteStream);
-    std::vector<WebmReader::CUEPOINT> cuepoints;
-    reader.GetCuePoints(cuepoints);
+    std::vector<WEBM::CuePoint> cuepoints;
 
-    if (!cuepoints.empty())
+    if (WEBM::ParseCuePoints(buffer.data(), buffer.size(), cuepoints))
     {
       CSegment seg;
 
-      rep->SetTimescale(1000);
-      rep->SetScaling();
+      data.m_timescale = 1000;
 
-      for (const WebmReader::CUEPOINT& cue : cuepoints)
+      for (const WEBM::CuePoint& cue : cuepoints)
       {
         seg.startPTS_ = cue.pts;
         seg.m_endPts = seg.startPTS_ + cue.duration;
         seg.m_time = cue.pts;
         seg.range_begin_ = cue.pos_start;
         seg.range_end_ = cue.pos_end;
-        rep->Timeline().Add(seg);
+        data.m_timeline.Add(seg);
       }
-
-      rep->SetDuration(rep->Timeline().GetDuration());
       return true;
     }
   }
@@ -533,8 +984,7 @@ bool AdaptiveStream::parseIndexRange(PLAYLIST::CRepresentation* rep,
           continue;
         }
 
-        rep->SetTimescale(sidx->GetTimeScale());
-        rep->SetScaling();
+        data.m_timescale = sidx->GetTimeScale();
 
         seg.range_end_ = streamPos + boxSize + sidx->GetFirstOffset() - 1;
 
@@ -542,7 +992,7 @@ bool AdaptiveStream::parseIndexRange(PLAYLIST::CRepresentation* rep,
         {
           seg.range_begin_ = seg.range_end_ + 1;
           seg.range_end_ = seg.range_begin_ + refs[i].m_ReferencedSize - 1;
-          rep->Timeline().Add(seg);
+          data.m_timeline.Add(seg);
 
           seg.startPTS_ += refs[i].m_SubsegmentDuration;
           seg.m_endPts = seg.startPTS_ + refs[i].m_SubsegmentDuration;
@@ -573,17 +1023,28 @@ bool AdaptiveStream::parseIndexRange(PLAYLIST::CRepresentation* rep,
       initSeg.SetIsInitialization(true);
       initSeg.range_begin_ = 0;
       initSeg.range_end_ = initRangeEnd;
-      rep->SetInitSegment(initSeg);
+      data.m_initSegment = initSeg;
     }
-
-    rep->SetDuration(rep->Timeline().GetDuration());
-
     return true;
   }
 #endif
   return false;
 }
 
+void AdaptiveStream::SetIndexRangeData(PLAYLIST::CRepresentation* rep, IndexRangeData& data)
+{
+  if (data.m_timescale > 0)
+  {
+    rep->SetTimescale(data.m_timescale);
+    rep->SetScaling();
+  }
+  rep->Timeline().Swap(data.m_timeline);
+  rep->SetDuration(rep->Timeline().GetDuration());
+
+  if (data.m_initSegment.has_value())
+    rep->SetInitSegment(*data.m_initSegment);
+}
+
 bool AdaptiveStream::start_stream(const uint64_t startPts)
 {
   if (!current_rep_ || current_rep_->IsSubtitleFileStream())
@@ -631,15 +1092,19 @@ bool AdaptiveStream::start_stream(const uint64_t startPts)
     thread_data_->signal_dl_.wait(lckdl);
   }
 
-  if (current_rep_->Timeline().IsEmpty())
   {
-    // GenerateSidxSegments assumes mutex_dl locked
+    // The representations segments are changed only with mutex_dl locked
     std::lock_guard<std::mutex> lck(thread_data_->mutex_dl_);
-    if (!GenerateSidxSegments(current_rep_))
+
+    WaitIndexPrefetch(current_rep_);
+
+    if (current_rep_->Timeline().IsEmpty() && !GenerateSidxSegments(current_rep_))
     {
       state_ = STOPPED;
       return false;
     }
+
+    StartIndexPrefetch();
   }
 
   // For subtitles only: subs can be turned off while in playback, this means that the stream will be disabled and resetted,
@@ -669,23 +1134,48 @@ bool AdaptiveStream::start_stream(const uint64_t startPts)
         !current_rep_->Timeline().IsEmpty())
     {
       size_t segPos = current_rep_->Timeline().GetSize() - 1;
-      //! @todo: segment duration is not fixed for each segment, this can calculate a wrong delay
-      const CSegment* lastSeg = current_rep_->Timeline().GetBack();
-      uint64_t segDur = lastSeg->m_endPts - lastSeg->startPTS_;
+      size_t partIndex{0};
 
-      size_t segPosDelay =
-          static_cast<size_t>((m_tree->m_liveDelay * current_rep_->GetTimescale()) / segDur);
+      // Low latency streams start close to the live edge, unless a delay is set by the add-on
+      if (m_tree->m_lowLatencyDelay != NO_VALUE &&
+          CSrvBroker::GetKodiProps().GetManifestConfig().liveDelay == 0 &&
+          FindLowLatencyStart(segPos, partIndex))
+      {
+        // The download starts from the segment that follow the current one
+        if (partIndex > 0)
+        {
+          m_startPartSegNumber = current_rep_->Timeline().Get(segPos)->m_number;
+          m_startPartIndex = partIndex;
+        }
+        LOG::Log(LOGDEBUG, "[AS-%u] Low latency start from segment no. %llu, part %zu", clsId,
+                 current_rep_->Timeline().Get(segPos)->m_number, partIndex);
 
-      if (segPos > segPosDelay)
-        segPos -= segPosDelay;
+        current_rep_->current_segment_ =
+            segPos > 0 ? current_rep_->Timeline().Get(segPos - 1) : nullptr;
+      }
       else
       {
-        //! @todo: Unhandled! should fall on previous period (when exists)
-        //! since is needed change period all this code should be moved just after manifest parsing and before period init
-        segPos = 0;
-      }
+        //! @todo: segment duration is not fixed for each segment, this can calculate a wrong delay
+        const CSegment* lastSeg = current_rep_->Timeline().GetBack();
+        // The segment in production of low latency streams is not complete
+        if (lastSeg->m_isPartial && segPos > 0)
+          lastSeg = current_rep_->Timeline().Get(--segPos);
+        uint64_t segDur = lastSeg->m_endPts - lastSeg->startPTS_;
+
+        size_t segPosDelay =
+            static_cast<size_t>((m_tree->m_liveDelay * current_rep_->GetTimescale()) / segDur);
+
+        if (segPos > segPosDelay)
+          segPos -= segPosDelay;
+        else
+        {
+          //! @todo: Unhandled! should fall on previous period (when exists)
+          //! since is needed change period all this code should be moved just after manifest parsing and before period init
+          segPos = 0;
+        }
 
-      current_rep_->current_segment_ = current_rep_->Timeline().Get(segPos);
+        current_rep_->current_segment_ = current_rep_->Timeline().Get(segPos);
+      }
     }
     else if (m_startEvent == EVENT_TYPE::REP_CHANGE) // switching streams, align new stream segment no.
     {
@@ -775,6 +1265,41 @@ bool AdaptiveStream::start_stream(const uint64_t startPts)
   return false;
 }
 
+bool AdaptiveStream::FindLowLatencyStart(size_t& segPos, size_t& partIndex) const
+{
+  const CSegContainer& timeline = current_rep_->Timeline();
+  const CSegment* lastSeg = timeline.GetBack();
+  const uint64_t delay = m_tree->m_lowLatencyDelay * current_rep_->GetTimescale() / 1000;
+
+  if (!lastSeg || lastSeg->m_endPts == NO_PTS_VALUE || lastSeg->m_endPts < delay)
+    return false;
+
+  const uint64_t startPts = lastSeg->m_endPts - delay;
+  // Audio parts can be decoded by themselves, also when not marked as independent
+  const bool isAllIndependent = current_adp_->GetStreamType() != StreamType::VIDEO;
+
+  for (size_t pos = timeline.GetSize(); pos-- > 0;)
+  {
+    const CSegment* segment = timeline.Get(pos);
+    if (segment->startPTS_ > startPts)
+      continue;
+
+    // Find the latest independent part that starts before the start time
+    partIndex = 0;
+    uint64_t partPts = segment->startPTS_;
+    for (size_t index = 0; index < segment->m_parts.size() && partPts <= startPts; ++index)
+    {
+      const CSegmentPart& part = segment->m_parts[index];
+      if (!part.m_isPreloadHint && (part.m_isIndependent || isAllIndependent))
+        partIndex = index;
+      partPts += part.m_duration;
+    }
+    segPos = pos;
+    return true;
+  }
+  return false;
+}
+
 bool AdaptiveStream::ensureSegment()
 {
   // NOTE: Some demuxers may call ensureSegment more times to try make more attempts when it return false.
@@ -867,6 +1392,9 @@ bool AdaptiveStream::ensureSegment()
           current_rep_->SetIsWaitForSegment(true);
           LOG::LogF(LOGDEBUG, "[AS-%u] Begin WaitForSegment stream rep. id \"%s\" period id \"%s\"",
                     clsId, current_rep_->GetId().data(), current_period_->GetId().data());
+          // The stream is starving, do not wait the scheduled manifest update
+          if (m_tree->HasManifestUpdates())
+            m_tree->GetTreeUpdMutex().RequestUpdate();
           return false;
         }
       }
@@ -923,6 +1451,7 @@ bool AdaptiveStream::ensureSegment()
           m_tree->OnStreamChange(current_period_, current_adp_, current_rep_, newRep);
 
           // If the representation has been changed, segments may have to be generated (DASH)
+          WaitIndexPrefetch(newRep);
           if (newRep->Timeline().IsEmpty())
             GenerateSidxSegments(newRep);
         }
@@ -1032,6 +1561,66 @@ uint32_t AdaptiveStream::read(void* buffer, uint32_t bytesToRead)
   return 0;
 }
 
+uint32_t AdaptiveStream::ReadAvailable(void* buffer, uint32_t minBytes, uint32_t maxBytes)
+{
+  if (state_ == STOPPED)
+    return 0;
+
+  std::unique_lock<std::mutex> lckrw(thread_data_->mutex_rw_);
+
+  while (ensureSegment() && minBytes > 0)
+  {
+    size_t avail = segment_buffers_[0]->buffer.size() - segment_read_pos_;
+    // Wait until we have the minimum data required
+    //! @todo: worker_processing_ not safe check, see read()
+    while (avail < minBytes && worker_processing_)
+    {
+      thread_data_->signal_rw_.wait(lckrw);
+      avail = segment_buffers_[0]->buffer.size() - segment_read_pos_;
+    }
+
+    if (avail >= minBytes)
+    {
+      if (avail > maxBytes)
+        avail = maxBytes;
+
+      std::memcpy(buffer, segment_buffers_[0]->buffer.data() + segment_read_pos_, avail);
+      segment_read_pos_ += avail;
+      absolute_position_ += avail;
+      return static_cast<uint32_t>(avail);
+    }
+
+    // As for read(), the incomplete data at the end of the segment is skipped
+    segment_read_pos_ += avail;
+    absolute_position_ += avail;
+
+    // All data of the segment has been read, continue with the next segment
+    if (avail == 0)
+      continue;
+
+    break;
+  }
+
+  return 0;
+}
+
+uint64_t AdaptiveStream::GetAvailableEndPosition()
+{
+  if (state_ != RUNNING)
+    return 0;
+
+  std::lock_guard<std::mutex> lckrw(thread_data_->mutex_rw_);
+
+  if (valid_segment_buffers_ == 0)
+    return 0;
+
+  const size_t bufferSize = segment_buffers_[0]->buffer.size();
+  if (segment_read_pos_ >= bufferSize)
+    return absolute_position_;
+
+  return absolute_position_ + (bufferSize - segment_read_pos_);
+}
+
 bool AdaptiveStream::ReadFullBuffer(std::vector<uint8_t>& buffer)
 {
   if (ensureSegment())
@@ -1115,6 +1704,34 @@ uint64_t AdaptiveStream::getMaxTimeMs()
   return (timeExt - absolutePTSOffset_) / 1000;
 }
 
+uint64_t AdaptiveStream::GetBufferedEndTimeMs()
+{
+  if (!thread_data_)
+    return 0;
+
+  std::lock_guard<std::mutex> lckdl(thread_data_->mutex_dl_);
+
+  // The last valid segment buffer can be still in download
+  size_t downloaded = valid_segment_buffers_;
+  if (worker_processing_ && downloaded > 0)
+    downloaded--;
+  if (downloaded == 0)
+    return 0;
+
+  const SEGMENTBUFFER* segBuffer = segment_buffers_[downloaded - 1];
+  const CSegment& segment = segBuffer->segment;
+  const uint64_t endPts = segment.m_endPts != NO_PTS_VALUE ? segment.m_endPts : segment.startPTS_;
+  if (!segBuffer->rep || endPts == NO_PTS_VALUE)
+    return 0;
+
+  const uint64_t timeExt =
+      (endPts * segBuffer->rep->timescale_ext_) / segBuffer->rep->timescale_int_;
+  if (timeExt < absolutePTSOffset_)
+    return 0;
+
+  return (timeExt - absolutePTSOffset_) / 1000;
+}
+
 void adaptive::AdaptiveStream::Disable()
 {
   // Preserve following events
@@ -1256,6 +1873,24 @@ size_t adaptive::AdaptiveStream::getSegmentPos()
   return current_rep_->Timeline().GetPos(current_rep_->current_segment_);
 }
 
+bool AdaptiveStream::GetCurrentSegmentInfo(std::string& repId,
+                                           uint64_t& segmentNumber,
+                                           uint64_t& startPos)
+{
+  if (state_ == STOPPED)
+    return false;
+
+  std::lock_guard<std::mutex> lckrw(thread_data_->mutex_rw_);
+
+  if (valid_segment_buffers_ == 0 || !segment_buffers_[0]->rep)
+    return false;
+
+  repId = segment_buffers_[0]->rep->GetId();
+  segmentNumber = segment_buffers_[0]->segment_number;
+  startPos = absolute_position_ - segment_read_pos_;
+  return true;
+}
+
 bool AdaptiveStream::waitingForSegment() const
 {
   if ((m_tree->HasManifestUpdates() || m_tree->HasManifestUpdatesSegs()) && state_ == RUNNING)
@@ -1274,6 +1909,20 @@ void AdaptiveStream::FixateInitialization(bool on)
 }
 
 bool AdaptiveStream::GenerateSidxSegments(PLAYLIST::CRepresentation* rep)
+{
+  std::vector<uint8_t> sidxBuffer;
+  IndexRangeData data;
+  // We assume mutex_dl is locked so we can safely call prepare_download
+  if (!DownloadIndexRange(rep, sidxBuffer) || !parseIndexRange(rep, sidxBuffer, data))
+    return false;
+
+  SetIndexRangeData(rep, data);
+  return true;
+}
+
+bool AdaptiveStream::DownloadIndexRange(PLAYLIST::CRepresentation* rep,
+                                        std::vector<uint8_t>& buffer,
+                                        const std::atomic<bool>* isCancelled /* = nullptr */)
 {
   const ContainerType containerType = rep->GetContainerType();
   if (containerType == ContainerType::NOTYPE)
@@ -1316,16 +1965,109 @@ bool AdaptiveStream::GenerateSidxSegments(PLAYLIST::CRepresentation* rep)
     seg.range_end_ = indexRangeEnd;
   }
 
-  std::vector<uint8_t> sidxBuffer;
   DownloadInfo downloadInfo;
-  // We assume mutex_dl is locked so we can safely call prepare_download
-  if (PrepareDownload(rep, seg, downloadInfo) && Download(downloadInfo, sidxBuffer) &&
-      parseIndexRange(rep, sidxBuffer))
+  downloadInfo.m_isCancelled = isCancelled;
+  return PrepareDownload(rep, seg, downloadInfo) && Download(downloadInfo, buffer);
+}
+
+bool AdaptiveStream::IsIndexPrefetchable(const PLAYLIST::CRepresentation* rep) const
+{
+  if (rep == current_rep_ || !rep->Timeline().IsEmpty() || !rep->HasSegmentBase())
+    return false;
+
+  // Only when the index range is known, otherwise a large part of the file may be downloaded
+  const ContainerType containerType = rep->GetContainerType();
+  if (containerType == ContainerType::WEBM)
+    return rep->GetSegmentBase()->GetIndexRangeBegin() > 0;
+  if (containerType == ContainerType::MP4)
+    return rep->GetSegmentBase()->GetIndexRangeEnd() > 0;
+
+  return false;
+}
+
+void AdaptiveStream::StartIndexPrefetch()
+{
+  std::lock_guard<std::mutex> lock(m_indexPrefetchMutex);
+
+  // The representations closer to the current bandwidth are the most likely to be selected
+  // on next quality switch, so they are submitted first
+  std::vector<CRepresentation*> reps = current_adp_->GetRepresentationsPtr();
+  const uint32_t currentBandwidth = current_rep_->GetBandwidth();
+  std::stable_sort(reps.begin(), reps.end(),
+                   [currentBandwidth](const CRepresentation* a, const CRepresentation* b)
+                   {
+                     return std::abs(static_cast<int64_t>(a->GetBandwidth()) - currentBandwidth) <
+                            std::abs(static_cast<int64_t>(b->GetBandwidth()) - currentBandwidth);
+                   });
+
+  for (CRepresentation* rep : reps)
   {
-    return true;
+    // A prefetched representation can be checked only after its data has been set
+    if (m_indexPrefetches.find(rep) != m_indexPrefetches.end() || !IsIndexPrefetchable(rep))
+      continue;
+
+    if (!m_indexPrefetchPool)
+      m_indexPrefetchPool = std::make_unique<CThreadPool>(INDEX_PREFETCH_THREADS);
+
+    // The task cannot start before the future is stored, because it is submitted under lock
+    m_indexPrefetches[rep].m_future = m_indexPrefetchPool->Submit(
+        [this, rep]
+        {
+          {
+            std::lock_guard<std::mutex> lck(m_indexPrefetchMutex);
+            auto it = m_indexPrefetches.find(rep);
+            // Cancelled, the segments are generated by the caller of WaitIndexPrefetch
+            if (m_isIndexPrefetchStopped || it == m_indexPrefetches.end())
+              return;
+            it->second.m_isStarted = true;
+          }
+
+          std::vector<uint8_t> buffer;
+          IndexRangeData data;
+          if (DownloadIndexRange(rep, buffer, &m_isIndexPrefetchStopped) &&
+              !m_isIndexPrefetchStopped && parseIndexRange(rep, buffer, data))
+          {
+            std::lock_guard<std::mutex> lck(m_indexPrefetchMutex);
+            auto it = m_indexPrefetches.find(rep);
+            if (it != m_indexPrefetches.end())
+            {
+              it->second.m_data = std::move(data);
+              it->second.m_isParsed = true;
+            }
+            LOG::Log(LOGDEBUG, "[AS-%u] Prefetched index range of repr id \"%s\"", clsId,
+                     rep->GetId().data());
+          }
+          else if (!m_isIndexPrefetchStopped)
+          {
+            LOG::Log(LOGWARNING, "[AS-%u] Cannot prefetch index range of repr id \"%s\"", clsId,
+                     rep->GetId().data());
+          }
+        });
   }
+}
 
-  return false;
+void AdaptiveStream::WaitIndexPrefetch(PLAYLIST::CRepresentation* rep)
+{
+  std::unique_lock<std::mutex> lock(m_indexPrefetchMutex);
+  auto it = m_indexPrefetches.find(rep);
+  if (it == m_indexPrefetches.end())
+    return;
+
+  if (it->second.m_isStarted && it->second.m_future.valid())
+  {
+    // The task does not lock mutex_dl, so it can be waited for with mutex_dl locked
+    std::future<void> future = std::move(it->second.m_future);
+    lock.unlock();
+    future.wait();
+    lock.lock();
+    it = m_indexPrefetches.find(rep);
+    if (it == m_indexPrefetches.end())
+      return;
+  }
+
+  if (it->second.m_isParsed && rep->Timeline().IsEmpty())
+    SetIndexRangeData(rep, it->second.m_data);
+  m_indexPrefetches.erase(it);
 }
 
 void AdaptiveStream::Stop()
@@ -9,13 +9,18 @@
 #pragma once
 
 #include "AdaptiveUtils.h"
+#include "EventMessage.h"
 #include "Segment.h"
 #include "samplereader/SampleReader.h"
+#include "utils/ThreadPool.h"
 
 #include <atomic>
 #include <condition_variable>
+#include <future>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 
@@ -46,6 +51,11 @@ enum class EVENT_TYPE
   public:
     virtual void OnSegmentChanged(AdaptiveStream *stream) = 0;
     virtual void OnStreamChange(AdaptiveStream *stream) = 0;
+    /*!
+     * \brief Called from the download thread for each event message
+     *        signalled by the downloaded segments, the same event can be repeated.
+     */
+    virtual void OnEventMessage(AdaptiveStream* stream, const PLAYLIST::CEventMessage& event) = 0;
   };
 
   class ATTR_DLL_LOCAL AdaptiveStream : public SampleReaderObserver
@@ -70,6 +80,13 @@ enum class EVENT_TYPE
     void DisposeWorker();
     uint64_t getMaxTimeMs();
 
+    /*!
+     * \brief Get the end time of the media downloaded in the segment buffers,
+     *        on the same time base of getMaxTimeMs.
+     * \return The end time in ms, or 0 if no segment has been downloaded
+     */
+    uint64_t GetBufferedEndTimeMs();
+
     void Disable();
 
     EVENT_TYPE GetStartEvent() const { return m_startEvent; }
@@ -98,6 +115,23 @@ enum class EVENT_TYPE
 
     uint32_t read(void* buffer, uint32_t bytesToRead);
 
+    /*!
+     * \brief Read the data of the current segment in bulk, without wait for more data
+     *        than the minimum required, so that many small reads can be replaced by one.
+     * \param buffer[OUT] The buffer where to copy the data, must have the size of maxBytes
+     * \param minBytes The minimum bytes to read
+     * \param maxBytes The maximum bytes to read
+     * \return The bytes read, otherwise 0 if the minimum bytes are not available
+     */
+    uint32_t ReadAvailable(void* buffer, uint32_t minBytes, uint32_t maxBytes);
+
+    /*!
+     * \brief Get the stream position where the data downloaded so far of the current
+     *        segment ends, the data before this position can be read without waiting.
+     * \return The position, or 0 if no segment data is available
+     */
+    uint64_t GetAvailableEndPosition();
+
     /*!
      * \brief Read the full stream buffer until EOF.
      * \param buffer[OUT] The full data buffer bytes
@@ -119,6 +153,17 @@ enum class EVENT_TYPE
     PLAYLIST::CAdaptationSet* getAdaptationSet() { return current_adp_; };
     PLAYLIST::CRepresentation* getRepresentation() { return current_rep_; };
     size_t getSegmentPos();
+
+    /*!
+     * \brief Get the identity and the start position of the segment currently read.
+     * \param repId [OUT] The id of the segment representation
+     * \param segmentNumber [OUT] The segment number
+     * \param startPos [OUT] The stream position where the segment data begins
+     * \return True if a segment is being read, otherwise false
+     */
+    bool GetCurrentSegmentInfo(std::string& repId,
+                               uint64_t& segmentNumber,
+                               uint64_t& startPos);
     uint64_t GetCurrentPTSOffset() { return currentPTSOffset_; };
     uint64_t GetAbsolutePTSOffset() { return absolutePTSOffset_; };
     bool waitingForSegment() const;
@@ -136,8 +181,31 @@ enum class EVENT_TYPE
     bool IsRequiredCreateMovieAtom();
 
   protected:
-    virtual bool parseIndexRange(PLAYLIST::CRepresentation* rep,
-                                 const std::vector<uint8_t>& buffer);
+    // Representation data parsed from the index range
+    struct IndexRangeData
+    {
+      PLAYLIST::CSegContainer m_timeline;
+      uint32_t m_timescale{0};
+      std::optional<PLAYLIST::CSegment> m_initSegment;
+    };
+
+    /*!
+     * \brief Parse the index range of a representation, without change it.
+     * \param rep The representation
+     * \param buffer The index range data
+     * \param data [OUT] The parsed data, to be set with SetIndexRangeData
+     * \return True if success, otherwise false
+     */
+    virtual bool parseIndexRange(const PLAYLIST::CRepresentation* rep,
+                                 const std::vector<uint8_t>& buffer,
+                                 IndexRangeData& data);
+
+    /*!
+     * \brief Set the parsed index range data to the representation, mutex_dl must be locked.
+     * \param rep The representation
+     * \param data The parsed data, that is moved
+     */
+    void SetIndexRangeData(PLAYLIST::CRepresentation* rep, IndexRangeData& data);
 
     virtual void SetLastUpdated(const std::chrono::system_clock::time_point tm) {}
     std::chrono::time_point<std::chrono::system_clock> lastUpdated_;
@@ -173,6 +241,19 @@ enum class EVENT_TYPE
       std::string m_url;
       std::map<std::string, std::string> m_addHeaders; // Additional headers
       SEGMENTBUFFER* m_segmentBuffer{nullptr}; // Optional, the segment buffer where to store the data
+      const std::atomic<bool>* m_isCancelled{nullptr}; // Optional, stop the download when set
+      bool m_isResumed{false}; // The range resumes a partial download, requires HTTP 206 status
+      // Optional, the following segment buffers filled in order by the same download,
+      // when the contiguous byte ranges of more segments are requested together
+      std::vector<SEGMENTBUFFER*> m_coalescedBuffers;
+      // Low latency partial segment, the parts are downloaded one after the other
+      // in the same segment buffer, while the segment is produced
+      bool m_isPartsDownload{false};
+      size_t m_partIndex{0}; // The next part to download
+      size_t m_firstPartIndex{0}; // The first part downloaded, the previous ones are not in buffer
+      std::string m_partUrl; // The url of the last part downloaded, also partially
+      uint64_t m_partUrlEnd{0}; // The byte position that follows the data downloaded from m_partUrl
+      bool m_isPartUrlComplete{false}; // The whole resource of m_partUrl has been downloaded
     };
 
     std::string m_streamParams;
@@ -205,7 +286,50 @@ enum class EVENT_TYPE
     */
     bool DownloadImpl(const DownloadInfo& downloadInfo, std::vector<uint8_t>* data);
 
+    /*!
+     * \brief Download a low latency segment by its parts, as soon as they are listed by the
+     *        manifest updates, until the segment has been completed. The parts already
+     *        downloaded with a preload hint are skipped.
+     * \param downloadInfo The info about the segment to download, the parts download state is
+     *                     kept, so that a new call continue from the last downloaded part
+     * \return Return true if success, otherwise false
+     */
+    bool DownloadSegmentParts(DownloadInfo& downloadInfo);
+
+    /*!
+     * \brief Find the start position of low latency live streams, at the low latency delay
+     *        from the live edge, aligned to the latest independent part before that time.
+     * \param segPos[OUT] The timeline position of the segment where to start
+     * \param partIndex[OUT] The index of the part where to start, 0 for the whole segment
+     * \return True if found, otherwise false
+     */
+    bool FindLowLatencyStart(size_t& segPos, size_t& partIndex) const;
+
     bool PrepareNextDownload(DownloadInfo& downloadInfo);
+
+    /*!
+     * \brief Write the downloaded data of coalesced byte ranges to the segment buffers,
+     *        by splitting it at the byte range size of each segment (mutex_rw_ must be locked,
+     *        mutex_dl_ must not be locked).
+     * \param downloadInfo The info about the download
+     * \param bufferIndex [IN/OUT] The index of segment buffer in download, 0 is m_segmentBuffer
+     * \param data The data
+     * \param dataSize The data size
+     * \param isLastChunk True if is the last chunk of the download
+     */
+    void WriteCoalescedData(const DownloadInfo& downloadInfo,
+                            size_t& bufferIndex,
+                            const uint8_t* data,
+                            size_t dataSize,
+                            bool isLastChunk);
+
+    /*!
+     * \brief Change a download of coalesced byte ranges to the single segment in download,
+     *        used to retry a failed download from the data already received.
+     * \param downloadInfo [IN/OUT] The info about the download
+     * \return True if there is data to download, otherwise false
+     */
+    bool SplitCoalescedDownload(DownloadInfo& downloadInfo);
     bool PrepareDownload(const PLAYLIST::CRepresentation* rep,
                          const PLAYLIST::CSegment& seg,
                          DownloadInfo& downloadInfo);
@@ -225,8 +349,73 @@ enum class EVENT_TYPE
 
     int SecondsSinceUpdate() const;
 
+    /*!
+     * \brief Get the time to wait before downloading a live segment not yet available
+     *        on the server, the segment availability margin is included.
+     * \param segBuffer The segment buffer of the segment to download
+     * \return The time to wait in ms, 0 if available
+     */
+    uint64_t GetSegmentAvailabilityWait(const SEGMENTBUFFER& segBuffer);
+
+    /*!
+     * \brief Parse the event messages ("emsg" boxes) of the downloaded MP4 segments
+     *        and notify them to the observer, on a new MPD validity expiration event
+     *        an immediate manifest update is requested (mutex_dl_ must not be locked).
+     * \param downloadInfo The info of the completed download
+     */
+    void ProcessEventMessages(const DownloadInfo& downloadInfo);
+
     bool GenerateSidxSegments(PLAYLIST::CRepresentation* rep);
 
+    /*!
+     * \brief Download the index range of a representation, used to generate the segments.
+     * \param rep The representation
+     * \param buffer [OUT] The downloaded data
+     * \param isCancelled [OPT] Flag to stop the download in progress
+     * \return True if success, otherwise false
+     */
+    bool DownloadIndexRange(PLAYLIST::CRepresentation* rep,
+                            std::vector<uint8_t>& buffer,
+                            const std::atomic<bool>* isCancelled = nullptr);
+
+    /*!
+     * \brief Check if the segments of a representation can be generated in background,
+     *        mutex_dl must be locked.
+     * \param rep The representation
+     * \return True if can be prefetched, otherwise false
+     */
+    bool IsIndexPrefetchable(const PLAYLIST::CRepresentation* rep) const;
+
+    /*!
+     * \brief Download and parse in background the index range of the other representations
+     *        of the adaptation set, so a quality switch dont have to wait for it.
+     *        Mutex_dl must be locked.
+     */
+    void StartIndexPrefetch();
+
+    /*!
+     * \brief Wait for the background index prefetch of a representation, if in progress,
+     *        and set the parsed data to the representation, or cancel it if not started yet,
+     *        in this case the caller must generate the segments. Mutex_dl must be locked.
+     * \param rep The representation
+     */
+    void WaitIndexPrefetch(PLAYLIST::CRepresentation* rep);
+
+    // The prefetch tasks never change the representations, that can be in use by the worker,
+    // the parsed data is set by WaitIndexPrefetch
+    struct IndexPrefetch
+    {
+      std::future<void> m_future;
+      bool m_isStarted{false};
+      bool m_isParsed{false};
+      IndexRangeData m_data;
+    };
+    // Background prefetch of the representations index ranges, guarded by m_indexPrefetchMutex
+    std::map<const PLAYLIST::CRepresentation*, IndexPrefetch> m_indexPrefetches;
+    std::mutex m_indexPrefetchMutex;
+    std::atomic<bool> m_isIndexPrefetchStopped{false};
+    std::unique_ptr<UTILS::CThreadPool> m_indexPrefetchPool;
+
     struct THREADDATA
     {
       THREADDATA()
@@ -289,6 +478,13 @@ enum class EVENT_TYPE
     bool m_fixateInitialization;
     uint64_t m_segmentFileOffset;
 
+    // Low latency streams, the segment number and the part index where to start the download
+    uint64_t m_startPartSegNumber{PLAYLIST::SEGMENT_NO_NUMBER};
+    size_t m_startPartIndex{0};
+
+    // The id of the last MPD validity expiration event, to request the manifest update once
+    std::optional<uint32_t> m_mpdEventId;
+
     // Defines the event to start the stream, the status will be resetted by start stream method.
     EVENT_TYPE m_startEvent{EVENT_TYPE::STREAM_START};
 
@@ -32,6 +32,18 @@
 using namespace PLAYLIST;
 using namespace UTILS;
 
+namespace
+{
+// Min interval between the manifest updates, in ms
+constexpr uint64_t MIN_UPDATE_INTERVAL = 500;
+// Min interval between the manifest updates requested early by a stream, in ms
+constexpr uint64_t MIN_EARLY_UPDATE_INTERVAL = 1000;
+// Max factor to extend the manifest update interval, when there are plenty of segments
+constexpr uint64_t MAX_UPDATE_INTERVAL_FACTOR = 4;
+// Margin added to the segment availability time, to tolerate the clock skew with the server
+constexpr uint64_t CLOCK_SKEW_MARGIN = 500;
+} // unnamed namespace
+
 namespace adaptive
 {
   AdaptiveTree::AdaptiveTree(const AdaptiveTree& left) : AdaptiveTree()
@@ -43,6 +55,7 @@ namespace adaptive
     m_supportedKeySystems = left.m_supportedKeySystems;
     m_pathSaveManifest = left.m_pathSaveManifest;
     stream_start_ = left.stream_start_;
+    m_clockOffset = left.m_clockOffset.load();
 
     m_isTTMLTimeRelative = left.m_isTTMLTimeRelative;
     m_isReqPrepareStream = left.m_isReqPrepareStream;
@@ -84,6 +97,11 @@ namespace adaptive
     return UTILS::GetTimestampMs();
   }
 
+  uint64_t AdaptiveTree::GetServerTimestamp()
+  {
+    return static_cast<uint64_t>(static_cast<int64_t>(GetTimestamp()) + m_clockOffset);
+  }
+
   void AdaptiveTree::Uninitialize()
   {
     // Stop the update thread before the tree class deconstruction otherwise derived classes
@@ -112,6 +130,15 @@ namespace adaptive
              m_isLive ? "live" : "VOD");
   }
 
+  uint64_t AdaptiveTree::GetLiveDelayMs() const
+  {
+    if (m_lowLatencyDelay != NO_VALUE &&
+        CSrvBroker::GetKodiProps().GetManifestConfig().liveDelay == 0)
+      return m_lowLatencyDelay;
+
+    return m_liveDelay * 1000;
+  }
+
   void AdaptiveTree::FreeSegments(CPeriod* period, CRepresentation* repr)
   {
     for (const CSegment& segment : repr->Timeline())
@@ -222,12 +249,72 @@ namespace adaptive
     return false;
   }
 
+  uint64_t AdaptiveTree::ComputeUpdateInterval()
+  {
+    // The tree schedules the updates on its own
+    if (m_nextUpdateDelay != NO_VALUE)
+      return m_nextUpdateDelay;
+
+    const uint64_t interval = m_updateInterval;
+    if (!m_isLive || interval == NO_VALUE || interval == 0 || !m_currentPeriod)
+      return interval;
+
+    // The min duration of the segments that can still be downloaded, so the time available
+    // before a stream will starve, and the time the first new segment will be available
+    uint64_t slack{NO_VALUE};
+    uint64_t nextAvailTime{NO_VALUE};
+
+    for (auto& adpSet : m_currentPeriod->GetAdaptationSets())
+    {
+      for (auto& repr : adpSet->GetRepresentations())
+      {
+        const CSegment* lastSeg = repr->Timeline().GetBack();
+        const CSegment* currentSeg = repr->current_segment_;
+
+        if (!repr->IsEnabled() || !lastSeg || !currentSeg || repr->GetTimescale() == 0)
+          continue;
+
+        uint64_t remaining{0};
+        if (lastSeg->m_endPts > currentSeg->m_endPts)
+          remaining = (lastSeg->m_endPts - currentSeg->m_endPts) * 1000 / repr->GetTimescale();
+
+        slack = std::min(slack, remaining);
+        nextAvailTime =
+            std::min(nextAvailTime, GetNextSegmentAvailableTime(m_currentPeriod, repr.get()));
+      }
+    }
+
+    // The playback is not started yet
+    if (slack == NO_VALUE)
+      return interval;
+
+    uint64_t nextInterval = interval;
+
+    if (slack > interval * 2)
+    {
+      // Plenty of segments to be downloaded, update when the remaining ones fall to the interval
+      nextInterval = std::min(slack - interval, interval * MAX_UPDATE_INTERVAL_FACTOR);
+    }
+    else if (nextAvailTime != NO_VALUE)
+    {
+      // Near the live edge, update as soon as the next segment should be published
+      const uint64_t updateTime = nextAvailTime + CLOCK_SKEW_MARGIN;
+      const uint64_t now = GetServerTimestamp();
+      nextInterval = std::min(updateTime > now ? updateTime - now : 0, interval);
+    }
+
+    return std::max(nextInterval, MIN_UPDATE_INTERVAL);
+  }
+
   void AdaptiveTree::SaveManifest(const std::string& fileNameSuffix,
                                   const std::string& data,
                                   std::string_view info)
   {
     if (!m_pathSaveManifest.empty())
     {
+      // Can be called by concurrent downloads, e.g. the HLS playlist updates
+      std::lock_guard<std::mutex> lock(m_saveManifestMutex);
+
       // We create a filename based on current timestamp
       // to allow files to be kept in download order useful for live streams
       std::string filename = "manifest_" + std::to_string(UTILS::GetTimestamp());
@@ -276,22 +363,39 @@ namespace adaptive
   void AdaptiveTree::TreeUpdateThread::Worker()
   {
     std::unique_lock<std::mutex> updLck(m_updMutex);
+    uint64_t interval = m_tree->m_updateInterval;
 
     while (m_tree->m_updateInterval != NO_VALUE && m_tree->m_updateInterval > 0 && !m_threadStop)
     {
-      auto nowTime = std::chrono::steady_clock::now();
+      const auto startTime = std::chrono::steady_clock::now();
+
+      // Wait for the interval time, or less when an early update has been requested,
+      // the loop is used to avoid spurious wakeups and to allow exit early
+      // when notify_all is called to force stop operations
+      while (!m_threadStop)
+      {
+        const uint64_t waitMs =
+            m_isUpdateRequested ? std::min(interval, MIN_EARLY_UPDATE_INTERVAL) : interval;
+        const auto endTime = startTime + std::chrono::milliseconds(waitMs);
+        if (std::chrono::steady_clock::now() >= endTime)
+          break;
 
-      std::chrono::milliseconds intervalMs = std::chrono::milliseconds(m_tree->m_updateInterval);
-      // Wait for the interval time, the predicate method is used to avoid spurious wakeups
-      // and to allow exit early when notify_all is called to force stop operations
-      m_cvUpdInterval.wait_for(updLck, intervalMs,
-                               [&nowTime, &intervalMs, this] {
-                                 return std::chrono::steady_clock::now() - nowTime >= intervalMs ||
-                                        m_threadStop;
-                               });
+        m_cvUpdInterval.wait_until(updLck, endTime);
+      }
 
       updLck.unlock();
-      // If paused, wait until last "Resume" will be called
+      if (m_threadStop)
+        break;
+
+      const auto updStartTime = std::chrono::steady_clock::now();
+      const bool isEarlyUpdate = updStartTime - startTime < std::chrono::milliseconds(interval);
+      m_isUpdateRequested = false;
+
+      // Long operations of the update, done without locking the updates
+      m_tree->OnPrepareUpdateSegments();
+
+      // If paused, wait until last "Resume" will be called, the pauses can change the tree
+      // while the update is prepared, then OnUpdateSegments validates the prepared data
       std::unique_lock<std::mutex> lckWait(m_waitMutex);
       m_cvWait.wait(lckWait, [&] { return m_waitQueue == 0; });
       if (m_threadStop)
@@ -304,6 +408,20 @@ namespace adaptive
         m_tree->m_updateInterval = PLAYLIST::NO_VALUE;
 
       m_tree->OnUpdateSegments();
+
+      interval = m_tree->ComputeUpdateInterval();
+
+      m_updateCount++;
+      if (isEarlyUpdate)
+        m_earlyUpdateCount++;
+
+      const auto updDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - updStartTime);
+      LOG::Log(LOGDEBUG,
+               "Manifest update no. %u done in %lld ms (early updates: %u), "
+               "next update in %llu ms",
+               m_updateCount, static_cast<long long>(updDuration.count()), m_earlyUpdateCount,
+               interval);
     }
   }
 
@@ -323,6 +441,15 @@ namespace adaptive
       m_cvWait.notify_all();
   }
 
+  void AdaptiveTree::TreeUpdateThread::RequestUpdate()
+  {
+    if (m_isUpdateRequested.exchange(true))
+      return;
+    // Lock to avoid missing the notification while the worker is about to wait
+    std::lock_guard<std::mutex> updLck{m_updMutex};
+    m_cvUpdInterval.notify_all();
+  }
+
   void AdaptiveTree::TreeUpdateThread::Stop()
   {
     m_threadStop = true;
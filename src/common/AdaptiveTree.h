@@ -72,6 +72,14 @@ public:
   uint64_t stream_start_{0}; // in ms
   uint64_t available_time_{0}; // in ms
   uint64_t m_liveDelay{0}; // Apply a delay in seconds from the live edge
+  // Low latency streams only, the delay in ms from the live edge, replace m_liveDelay when set
+  uint64_t m_lowLatencyDelay{PLAYLIST::NO_VALUE};
+  uint64_t m_partDuration{PLAYLIST::NO_VALUE}; // Low latency streams only, max part duration in ms
+  // Latency range in ms and playback rates suggested by the service to keep the delay on target
+  uint64_t m_minLatency{PLAYLIST::NO_VALUE};
+  uint64_t m_maxLatency{PLAYLIST::NO_VALUE};
+  std::optional<double> m_minPlaybackRate;
+  std::optional<double> m_maxPlaybackRate;
 
   std::vector<std::string_view> m_supportedKeySystems;
   std::string location_;
@@ -98,6 +106,13 @@ public:
    */
   virtual uint64_t GetTimestamp();
 
+  /*!
+   * \brief Get the current timestamp of the server clock, that is the local clock corrected
+   *        by the offset found by the last clock synchronization (e.g. DASH UTCTiming)
+   * \return The timestamp in ms
+   */
+  uint64_t GetServerTimestamp();
+
   /*!
    * \brief Performs operations to stop running process and release resources.
    */
@@ -243,6 +258,13 @@ public:
    */
   bool IsLive() const { return m_isLive; }
 
+  /*!
+   * \brief Get the delay from the live edge applied to the playback, the low latency delay
+   *        when the stream is low latency and the add-on has not set a custom live delay.
+   * \return The delay in ms
+   */
+  uint64_t GetLiveDelayMs() const;
+
   /*!
    * \brief Determines if a live manifest needs updates when new segments are requested
    */
@@ -296,6 +318,10 @@ public:
     // \brief Stop performing new updates.
     void Stop();
 
+    // \brief Request an early update, e.g. when a stream has no more segments to download.
+    //        The update is done as soon as the min interval from the previous one has elapsed.
+    void RequestUpdate();
+
   private:
     void Worker();
     void Pause();
@@ -316,6 +342,9 @@ public:
     std::condition_variable m_cvWait;
     bool m_threadStop{false};
     bool m_resetInterval{false};
+    std::atomic<bool> m_isUpdateRequested{false};
+    uint32_t m_updateCount{0}; // Number of updates done
+    uint32_t m_earlyUpdateCount{0}; // Number of updates done before the scheduled time
   };
 
   /*!
@@ -358,6 +387,32 @@ public:
                      const PLAYLIST::CRepresentation* segRep,
                      const PLAYLIST::CSegment* segment) const;
 
+  /*!
+   * \brief Compute the time to wait before the next manifest update, based on the duration of
+   *        the segments not downloaded yet of the enabled representations and on the
+   *        availability time of their next segments. The manifest update interval is extended
+   *        when there are plenty of segments, and reduced near the live edge.
+   *        When the tree schedules the updates on its own, m_nextUpdateDelay is returned.
+   * \return The interval in ms, NO_VALUE if the manifest has no scheduled updates
+   */
+  uint64_t ComputeUpdateInterval();
+
+  /*!
+   * \brief Get the time at which a live segment not listed by the manifest, but generated
+   *        (e.g. DASH SegmentTemplate without timeline), will be available on the server.
+   * \param period The period of the segment
+   * \param repr The representation of the segment
+   * \param segment The segment
+   * \return The UTC time in ms of the server clock, otherwise NO_VALUE when the segment
+   *         can be requested at any time
+   */
+  virtual uint64_t GetSegmentAvailableTime(PLAYLIST::CPeriod* period,
+                                           PLAYLIST::CRepresentation* repr,
+                                           const PLAYLIST::CSegment& segment)
+  {
+    return PLAYLIST::NO_VALUE;
+  }
+
 protected:
   /*!
    * \brief Save manifest data to a file for debugging purpose.
@@ -381,12 +436,39 @@ protected:
    */
   virtual void OnUpdateSegments() { lastUpdated_ = std::chrono::system_clock::now(); }
 
+  /*!
+   * \brief Callback called by the TreeUpdateThread worker just before OnUpdateSegments,
+   *        without the update lock, so that long operations (e.g. blocking manifest requests)
+   *        do not block the other threads that need the lock to access the segments.
+   *        The updates can be paused in the meantime, so OnUpdateSegments must discard
+   *        the prepared data that has become outdated.
+   */
+  virtual void OnPrepareUpdateSegments() {}
+
+  /*!
+   * \brief Get the time at which the segment that follows the last one of the representation
+   *        timeline will be available on the server, used to schedule the manifest updates.
+   * \param period The period of the representation
+   * \param repr The representation
+   * \return The UTC time in ms, otherwise NO_VALUE if it cannot be determined
+   */
+  virtual uint64_t GetNextSegmentAvailableTime(PLAYLIST::CPeriod* period,
+                                               PLAYLIST::CRepresentation* repr)
+  {
+    return PLAYLIST::NO_VALUE;
+  }
+
   // Manifest update interval in ms,
   // Non-zero value: refresh interval starting from the moment mpd download was initiated
   // Value 0: refresh each time we need to make new segments
   std::atomic<uint64_t> m_updateInterval{PLAYLIST::NO_VALUE};
+  // Delay in ms of the next update, set when the tree schedules the updates on its own
+  // (e.g. HLS playlists with different intervals), otherwise NO_VALUE
+  std::atomic<uint64_t> m_nextUpdateDelay{PLAYLIST::NO_VALUE};
   TreeUpdateThread m_updThread;
   std::atomic<std::chrono::time_point<std::chrono::system_clock>> lastUpdated_{std::chrono::system_clock::now()};
+  // Offset of the server clock from the local clock, in ms
+  std::atomic<int64_t> m_clockOffset{0};
 
   // Optionals URL parameters to add to the manifest update requests
   std::string m_manifestUpdParams;
@@ -396,6 +478,7 @@ protected:
 
   // Provide the path where the manifests will be saved, if debug enabled
   std::string m_pathSaveManifest;
+  std::mutex m_saveManifestMutex; // Serialize the saving of manifests
 
   std::string m_licenseUrl;
 
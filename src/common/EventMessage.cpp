@@ -0,0 +1,176 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "EventMessage.h"
+
+#include <cstring>
+#include <utility>
+
+namespace
+{
+constexpr uint32_t BOX_TYPE_EMSG = 0x656D7367; // "emsg"
+constexpr uint32_t BOX_TYPE_MOOF = 0x6D6F6F66; // "moof"
+constexpr uint32_t BOX_TYPE_MDAT = 0x6D646174; // "mdat"
+constexpr size_t BOX_HEADER_SIZE = 8;
+// The event duration value for an unknown duration
+constexpr uint32_t EMSG_UNKNOWN_DURATION = 0xFFFFFFFF;
+
+// Big endian reader, with bounds checking
+class CBoxReader
+{
+public:
+  CBoxReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+  bool ReadU32(uint32_t& value)
+  {
+    if (m_size - m_pos < 4)
+      return false;
+    value = (static_cast<uint32_t>(m_data[m_pos]) << 24) |
+            (static_cast<uint32_t>(m_data[m_pos + 1]) << 16) |
+            (static_cast<uint32_t>(m_data[m_pos + 2]) << 8) | m_data[m_pos + 3];
+    m_pos += 4;
+    return true;
+  }
+
+  bool ReadU64(uint64_t& value)
+  {
+    uint32_t high;
+    uint32_t low;
+    if (!ReadU32(high) || !ReadU32(low))
+      return false;
+    value = (static_cast<uint64_t>(high) << 32) | low;
+    return true;
+  }
+
+  // Read a null-terminated string
+  bool ReadString(std::string& value)
+  {
+    const void* end = std::memchr(m_data + m_pos, '\0', m_size - m_pos);
+    if (!end)
+      return false;
+    const size_t length = static_cast<const uint8_t*>(end) - (m_data + m_pos);
+    value.assign(reinterpret_cast<const char*>(m_data + m_pos), length);
+    m_pos += length + 1;
+    return true;
+  }
+
+  void ReadRemaining(std::string& value)
+  {
+    value.assign(reinterpret_cast<const char*>(m_data + m_pos), m_size - m_pos);
+    m_pos = m_size;
+  }
+
+private:
+  const uint8_t* m_data;
+  size_t m_size;
+  size_t m_pos{0};
+};
+
+bool ParseEmsgBox(const uint8_t* data,
+                  size_t size,
+                  uint64_t segStartMs,
+                  PLAYLIST::CEventMessage& event)
+{
+  CBoxReader reader{data, size};
+  uint32_t versionFlags;
+  if (!reader.ReadU32(versionFlags))
+    return false;
+
+  const uint8_t version = static_cast<uint8_t>(versionFlags >> 24);
+  uint32_t duration{0};
+
+  if (version == 0)
+  {
+    uint32_t ptsDelta;
+    if (!reader.ReadString(event.m_schemeIdUri) || !reader.ReadString(event.m_value) ||
+        !reader.ReadU32(event.m_timescale) || !reader.ReadU32(ptsDelta) ||
+        !reader.ReadU32(duration) || !reader.ReadU32(event.m_id) || event.m_timescale == 0)
+    {
+      return false;
+    }
+    event.m_presentationTime = segStartMs * event.m_timescale / 1000 + ptsDelta;
+  }
+  else if (version == 1)
+  {
+    if (!reader.ReadU32(event.m_timescale) || !reader.ReadU64(event.m_presentationTime) ||
+        !reader.ReadU32(duration) || !reader.ReadU32(event.m_id) ||
+        !reader.ReadString(event.m_schemeIdUri) || !reader.ReadString(event.m_value) ||
+        event.m_timescale == 0)
+    {
+      return false;
+    }
+  }
+  else
+    return false;
+
+  event.m_duration = duration == EMSG_UNKNOWN_DURATION ? PLAYLIST::NO_VALUE : duration;
+  reader.ReadRemaining(event.m_messageData);
+  return true;
+}
+} // unnamed namespace
+
+uint64_t PLAYLIST::CEventMessage::GetPresentationTimeMs() const
+{
+  return m_presentationTime * 1000 / m_timescale;
+}
+
+bool PLAYLIST::CEventMessage::IsSameEvent(const CEventMessage& other) const
+{
+  return m_id == other.m_id && m_schemeIdUri == other.m_schemeIdUri && m_value == other.m_value;
+}
+
+bool PLAYLIST::ParseEventMessages(const uint8_t* data,
+                                  size_t dataSize,
+                                  uint64_t segStartMs,
+                                  std::vector<CEventMessage>& events)
+{
+  bool isParsed{false};
+  size_t pos{0};
+
+  // The "emsg" boxes are at top level, before the first "moof" box
+  while (dataSize - pos >= BOX_HEADER_SIZE)
+  {
+    CBoxReader reader{data + pos, dataSize - pos};
+    uint32_t size32;
+    uint32_t type;
+    reader.ReadU32(size32);
+    reader.ReadU32(type);
+
+    uint64_t boxSize = size32;
+    size_t headerSize = BOX_HEADER_SIZE;
+    if (size32 == 1) // 64 bit box size
+    {
+      if (!reader.ReadU64(boxSize))
+        break;
+      headerSize += 8;
+    }
+    else if (size32 == 0) // The box extends to the end of data
+      boxSize = dataSize - pos;
+
+    if (type == BOX_TYPE_MOOF || type == BOX_TYPE_MDAT || boxSize < headerSize ||
+        boxSize > dataSize - pos)
+    {
+      break;
+    }
+
+    if (type == BOX_TYPE_EMSG)
+    {
+      CEventMessage event;
+      if (ParseEmsgBox(data + pos + headerSize, static_cast<size_t>(boxSize) - headerSize,
+                       segStartMs, event))
+      {
+        events.emplace_back(std::move(event));
+        isParsed = true;
+      }
+    }
+
+    pos += static_cast<size_t>(boxSize);
+  }
+
+  return isParsed;
+}
@@ -0,0 +1,74 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include "AdaptiveUtils.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef INPUTSTREAM_TEST_BUILD
+#include "test/KodiStubs.h"
+#else
+#include <kodi/AddonBase.h>
+#endif
+
+namespace PLAYLIST
+{
+// Scheme of the DASH MPD events, the value "1" signals the MPD validity expiration,
+// "2" an MPD patch and "3" an inband MPD update
+constexpr std::string_view EVENT_SCHEME_MPD = "urn:mpeg:dash:event:2012";
+
+/*!
+ * \brief An event of the presentation, signalled by the MPD <EventStream> tag
+ *        or by an inband "emsg" box of the media segments (e.g. SCTE-35 markers).
+ */
+struct ATTR_DLL_LOCAL CEventMessage
+{
+  std::string m_schemeIdUri;
+  std::string m_value;
+  uint32_t m_id{0};
+  uint32_t m_timescale{1};
+  uint64_t m_presentationTime{0}; // In timescale units
+  uint64_t m_duration{NO_VALUE}; // In timescale units, NO_VALUE if unknown
+  std::string m_messageData;
+
+  /*!
+   * \brief Get the presentation time.
+   * \return The presentation time in ms
+   */
+  uint64_t GetPresentationTimeMs() const;
+
+  /*!
+   * \brief Check if the message signals the same event of another message,
+   *        the same event can be repeated in more segments or manifest updates.
+   * \param other The other message
+   * \return True if same event, otherwise false
+   */
+  bool IsSameEvent(const CEventMessage& other) const;
+};
+
+/*!
+ * \brief Parse the "emsg" boxes (version 0 and 1) that precede the first "moof" box
+ *        of an ISOBMFF media segment.
+ * \param data The segment data
+ * \param dataSize The segment data size
+ * \param segStartMs The segment presentation start time in ms, version 0 boxes
+ *                   provide the presentation time relative to it
+ * \param events [OUT] The events parsed, appended to the existing ones
+ * \return True if at least one event has been parsed, otherwise false
+ */
+bool ParseEventMessages(const uint8_t* data,
+                        size_t dataSize,
+                        uint64_t segStartMs,
+                        std::vector<CEventMessage>& events);
+
+} // namespace PLAYLIST
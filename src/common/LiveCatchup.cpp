@@ -0,0 +1,125 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "LiveCatchup.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Playback rates used when not provided by the manifest or the add-on
+constexpr double DEFAULT_MIN_RATE = 0.95;
+constexpr double DEFAULT_MAX_RATE = 1.05;
+// Limits of the playback rates, a greater change of speed is perceptible
+constexpr double LIMIT_MIN_RATE = 0.5;
+constexpr double LIMIT_MAX_RATE = 2.0;
+// Granularity of the playback rate adjustments
+constexpr double RATE_STEP = 0.01;
+// Min latency deviation from the target, in ms, smaller deviations are not corrected
+constexpr uint64_t MIN_TOLERANCE = 100;
+// Upper bound of the buffer level required to speed up the playback, in ms
+constexpr uint64_t MAX_MIN_BUFFER_LEVEL = 4000;
+
+// Round the rate change to the step, at least one step, but not greater than the max change
+double RoundRateChange(double change, double maxChange)
+{
+  return std::min(std::max(std::round(change / RATE_STEP) * RATE_STEP, RATE_STEP), maxChange);
+}
+} // unnamed namespace
+
+void adaptive::CLiveCatchup::Configure(Config config)
+{
+  m_isEnabled = config.m_targetLatency > 0;
+  if (!m_isEnabled)
+    return;
+
+  const uint64_t target = config.m_targetLatency;
+
+  if (config.m_minLatency == 0 || config.m_minLatency >= target)
+    config.m_minLatency = target * 3 / 4;
+  if (config.m_maxLatency <= target)
+    config.m_maxLatency = target * 2;
+
+  if (config.m_minRate <= 0 || config.m_minRate >= 1.0)
+    config.m_minRate = DEFAULT_MIN_RATE;
+  if (config.m_maxRate <= 1.0)
+    config.m_maxRate = DEFAULT_MAX_RATE;
+  config.m_minRate = std::max(config.m_minRate, LIMIT_MIN_RATE);
+  config.m_maxRate = std::min(config.m_maxRate, LIMIT_MAX_RATE);
+
+  m_config = config;
+  // The tolerance must leave room for rate adjustments before reaching the max latency
+  m_tolerance = std::min(std::max(target / 10, MIN_TOLERANCE), (config.m_maxLatency - target) / 2);
+  // The buffer cannot exceed the latency, so the requirement is relative to the target
+  m_minBufferLevel = std::min(target / 2, MAX_MIN_BUFFER_LEVEL);
+
+  Reset();
+}
+
+adaptive::CLiveCatchup::Action adaptive::CLiveCatchup::Update(uint64_t latency,
+                                                              uint64_t bufferLevel)
+{
+  if (!m_isEnabled)
+    return Action::NONE;
+
+  if (latency > m_config.m_maxLatency)
+  {
+    // Too far behind the live edge to catch up by the playback rate,
+    // the seek is requested once, until the latency return within the max
+    if (m_isSeekRequested)
+      return Action::NONE;
+
+    m_isSeekRequested = true;
+    m_playbackRate = 1.0;
+    return Action::SEEK;
+  }
+  m_isSeekRequested = false;
+
+  const uint64_t target = m_config.m_targetLatency;
+  const uint64_t deviation = latency > target ? latency - target : target - latency;
+  // Hysteresis, a started adjustment continue until the latency is closer to the target
+  const uint64_t tolerance = m_playbackRate == 1.0 ? m_tolerance : m_tolerance / 2;
+  double rate{1.0};
+
+  if (deviation > tolerance)
+  {
+    // The rate change is proportional to the deviation, up to the min/max rate at the
+    // min/max latency, rounded to avoid speed changes for negligible latency variations
+    if (latency > target)
+    {
+      // Speeding up with a low buffer would consume it and lead to a rebuffering
+      if (bufferLevel >= m_minBufferLevel)
+      {
+        const double factor =
+            std::min(static_cast<double>(deviation) / (m_config.m_maxLatency - target), 1.0);
+        const double maxChange = m_config.m_maxRate - 1.0;
+        rate = 1.0 + RoundRateChange(maxChange * factor, maxChange);
+      }
+    }
+    else
+    {
+      const double factor =
+          std::min(static_cast<double>(deviation) / (target - m_config.m_minLatency), 1.0);
+      const double maxChange = 1.0 - m_config.m_minRate;
+      rate = 1.0 - RoundRateChange(maxChange * factor, maxChange);
+    }
+  }
+
+  if (rate == m_playbackRate)
+    return Action::NONE;
+
+  m_playbackRate = rate;
+  return Action::ADJUST_RATE;
+}
+
+void adaptive::CLiveCatchup::Reset()
+{
+  m_playbackRate = 1.0;
+  m_isSeekRequested = false;
+}
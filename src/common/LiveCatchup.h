@@ -0,0 +1,95 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#ifdef INPUTSTREAM_TEST_BUILD
+#include "test/KodiStubs.h"
+#else
+#include <kodi/AddonBase.h>
+#endif
+
+namespace adaptive
+{
+
+/*!
+ * \brief Keep the latency (the distance of the playback from the live edge) of live streams
+ *        within a band around the target latency. A small drift is corrected by recommending
+ *        a playback rate adjustment, when the playback falls far behind the live edge
+ *        (e.g. after rebuffering) a seek to the target latency is requested.
+ */
+class ATTR_DLL_LOCAL CLiveCatchup
+{
+public:
+  enum class Action
+  {
+    NONE, // Nothing to do, the recommended playback rate is unchanged
+    ADJUST_RATE, // The recommended playback rate is changed
+    SEEK, // Seek to the target latency
+  };
+
+  struct Config
+  {
+    uint64_t m_targetLatency{0}; // The latency to be kept, in ms
+    uint64_t m_minLatency{0}; // Latency at which the min rate is reached, in ms, 0 for the default
+    uint64_t m_maxLatency{0}; // Above this latency a seek is requested, in ms, 0 for the default
+    double m_minRate{0}; // Min playback rate, 0 for the default
+    double m_maxRate{0}; // Max playback rate, 0 for the default
+  };
+
+  /*!
+   * \brief Enable the controller with the specified configuration, missing or inconsistent
+   *        values are replaced by defaults derived from the target latency.
+   * \param config The configuration, the target latency must be set
+   */
+  void Configure(Config config);
+
+  /*!
+   * \brief Check if the controller is enabled
+   * \return True if enabled, otherwise false
+   */
+  bool IsEnabled() const { return m_isEnabled; }
+
+  /*!
+   * \brief Get the configuration in use
+   * \return The configuration
+   */
+  const Config& GetConfig() const { return m_config; }
+
+  /*!
+   * \brief Update the controller with the latest measurements.
+   * \param latency The current distance of the playback from the live edge, in ms
+   * \param bufferLevel The media duration buffered ahead of the playback, in ms
+   * \return The action to be taken
+   */
+  Action Update(uint64_t latency, uint64_t bufferLevel);
+
+  /*!
+   * \brief Get the recommended playback rate
+   * \return The playback rate, 1.0 for the normal speed
+   */
+  double GetPlaybackRate() const { return m_playbackRate; }
+
+  /*!
+   * \brief Reset the recommended playback rate and the pending seek state,
+   *        e.g. after a seek requested by the user.
+   */
+  void Reset();
+
+private:
+  bool m_isEnabled{false};
+  Config m_config;
+  uint64_t m_tolerance{0}; // Max latency deviation from the target without rate adjustments
+  uint64_t m_minBufferLevel{0}; // Min buffer level to allow speeding up the playback
+  double m_playbackRate{1.0};
+  bool m_isSeekRequested{false};
+};
+
+} // namespace adaptive
@@ -12,6 +12,8 @@
 #include "Representation.h"
 #include "utils/log.h"
 
+#include <algorithm> // any_of
+
 using namespace PLAYLIST;
 
 PLAYLIST::CPeriod::CPeriod() : CCommonSegAttribs()
@@ -82,6 +84,17 @@ void PLAYLIST::CPeriod::RemovePSSHSet(uint16_t pssh_set)
   }
 }
 
+void PLAYLIST::CPeriod::IncreasePSSHSetUsageCount(uint16_t pssh_set)
+{
+  if (pssh_set >= m_psshSets.size())
+  {
+    LOG::LogF(LOGERROR, "Cannot increase PSSH usage, PSSHSet position %u exceeds the container size", pssh_set);
+    return;
+  }
+
+  m_psshSets[pssh_set].m_usageCount++;
+}
+
 void PLAYLIST::CPeriod::DecreasePSSHSetUsageCount(uint16_t pssh_set)
 {
   if (pssh_set >= m_psshSets.size())
@@ -99,3 +112,14 @@ void PLAYLIST::CPeriod::AddAdaptationSet(std::unique_ptr<CAdaptationSet>& adapta
 {
   m_adaptationSets.push_back(std::move(adaptationSet));
 }
+
+bool PLAYLIST::CPeriod::AddEventMessage(const CEventMessage& event)
+{
+  if (std::any_of(m_eventMessages.cbegin(), m_eventMessages.cend(),
+                  [&event](const CEventMessage& item) { return item.IsSameEvent(event); }))
+  {
+    return false;
+  }
+  m_eventMessages.emplace_back(event);
+  return true;
+}
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "CommonSegAttribs.h"
+#include "EventMessage.h"
 #include "SegTemplate.h"
 #include "utils/CryptoUtils.h"
 
@@ -123,9 +124,23 @@ public:
 
   uint16_t InsertPSSHSet(const PSSHSet& pssh);
   void RemovePSSHSet(uint16_t pssh_set);
+  void IncreasePSSHSetUsageCount(uint16_t pssh_set);
   void DecreasePSSHSetUsageCount(uint16_t pssh_set);
   std::vector<PSSHSet>& GetPSSHSets() { return m_psshSets; }
 
+  /*!
+   * \brief Get the events signalled by the manifest for this period.
+   * \return The event messages.
+   */
+  const std::vector<CEventMessage>& GetEventMessages() const { return m_eventMessages; }
+
+  /*!
+   * \brief Add an event message, if the same event has not already been added.
+   * \param event The event message
+   * \return True if added, otherwise false if already exists
+   */
+  bool AddEventMessage(const CEventMessage& event);
+
   // Make use of PLAYLIST::StreamType flags
   uint32_t m_includedStreamType{0}; //! @todo: part of this need a rework
 
@@ -143,6 +158,7 @@ protected:
   EncryptionState m_encryptionState{EncryptionState::UNENCRYPTED};
   std::optional<bool> m_isSecureDecoderNeeded;
   std::vector<uint32_t> m_segmentTimelineDuration;
+  std::vector<CEventMessage> m_eventMessages;
 };
 
 } // namespace adaptive
@@ -88,6 +88,7 @@ void PLAYLIST::CRepresentation::CopyHLSData(const CRepresentation* other)
   m_timescale = other->m_timescale;
   timescale_ext_ = other->timescale_ext_;
   timescale_int_ = other->timescale_int_;
+  m_updateInterval = other->m_updateInterval;
 
   m_isIncludedStream = other->m_isIncludedStream;
   m_isEnabled = other->m_isEnabled;
@@ -109,6 +109,7 @@ public:
   const CSegContainer& Timeline() const { return m_segmentTimeline; }
 
   std::optional<CSegmentBase>& GetSegmentBase() { return m_segmentBase; }
+  const std::optional<CSegmentBase>& GetSegmentBase() const { return m_segmentBase; }
   void SetSegmentBase(const CSegmentBase& segBase) { m_segmentBase = segBase; }
   bool HasSegmentBase() const { return m_segmentBase.has_value(); }
 
@@ -207,6 +208,10 @@ public:
 
   std::chrono::time_point<std::chrono::system_clock> repLastUpdated_;
 
+  // Live playlist refresh schedule, each playlist has its own interval in ms (HLS only)
+  uint64_t m_updateInterval{NO_VALUE};
+  std::chrono::steady_clock::time_point m_nextUpdate;
+
   //! @todo: to be reworked or deleted
   uint32_t assured_buffer_duration_{0};
   uint32_t max_buffer_duration_{0};
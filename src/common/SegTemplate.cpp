@@ -86,6 +86,22 @@ uint64_t PLAYLIST::CSegmentTemplate::GetPresTimeOffset() const
   return 0; // Default value
 }
 
+uint64_t PLAYLIST::CSegmentTemplate::GetAvailabilityTimeOffset() const
+{
+  if (m_availabilityTimeOffset.has_value())
+    return *m_availabilityTimeOffset;
+
+  return 0; // Default value
+}
+
+bool PLAYLIST::CSegmentTemplate::IsAvailabilityTimeComplete() const
+{
+  if (m_availabilityTimeComplete.has_value())
+    return *m_availabilityTimeComplete;
+
+  return true; // Default value
+}
+
 CSegment PLAYLIST::CSegmentTemplate::MakeInitSegment()
 {
   CSegment seg;
@@ -71,6 +71,24 @@ public:
   void SetPresTimeOffset(uint64_t ptsOffset) { m_ptsOffset = ptsOffset; }
   bool HasPresTimeOffset() const { return m_ptsOffset.has_value(); }
 
+  /*!
+   * \brief Get the availability time offset (low latency streams), the time in ms
+   *        before the end of a segment from which it can be requested, while it is
+   *        still in production. Use HasAvailabilityTimeOffset method to know if the value is set.
+   * \return The offset in ms, or the default value (0).
+   */
+  uint64_t GetAvailabilityTimeOffset() const;
+  void SetAvailabilityTimeOffset(uint64_t offset) { m_availabilityTimeOffset = offset; }
+  bool HasAvailabilityTimeOffset() const { return m_availabilityTimeOffset.has_value(); }
+
+  /*!
+   * \brief Check if the segments are complete at their availability start time,
+   *        when false the segments are delivered in chunks (e.g. chunked CMAF).
+   * \return True if complete (default value), otherwise false.
+   */
+  bool IsAvailabilityTimeComplete() const;
+  void SetAvailabilityTimeComplete(bool isComplete) { m_availabilityTimeComplete = isComplete; }
+
   // \brief Defines a <SegmentTimeline>, <S> element
   struct TimelineElement
   {
@@ -101,6 +119,8 @@ private:
   std::optional<uint64_t> m_startNumber;
   std::optional<uint64_t> m_endNumber;
   std::optional <uint64_t> m_ptsOffset;
+  std::optional<uint64_t> m_availabilityTimeOffset;
+  std::optional<bool> m_availabilityTimeComplete;
   std::vector<TimelineElement> m_timeline;
 };
 
@@ -24,6 +24,17 @@
 
 namespace PLAYLIST
 {
+// Partial segment of low latency streams (e.g. LL-HLS EXT-X-PART)
+struct CSegmentPart
+{
+  std::string m_url;
+  uint64_t m_rangeBegin{NO_VALUE}; // Byte range start
+  uint64_t m_rangeEnd{NO_VALUE}; // Byte range end, NO_VALUE for an open ended range
+  uint64_t m_duration{0}; // The duration, in ms
+  bool m_isIndependent{false}; // Can be decoded without the previous parts
+  bool m_isPreloadHint{false}; // Not yet available, the server will send it when produced
+};
+
 class ATTR_DLL_LOCAL CSegment
 {
 public:
@@ -45,6 +56,13 @@ public:
   uint64_t m_time{0}; // Timestamp
   uint64_t m_number{SEGMENT_NO_NUMBER};
 
+  // The partial segments, in playback order, available for the most recent segments only
+  std::vector<CSegmentPart> m_parts;
+  // The parts marked as gap, that are not available and not included in m_parts
+  uint32_t m_gapPartsCount{0};
+  // The segment is in production, only the parts are available and "url" is not set
+  bool m_isPartial{false};
+
   /*!
    * \brief Determines if it is an initialization segment.
    * \return True if it is an initialization segment, otherwise false for media segment.
@@ -35,8 +35,8 @@ public:
   void SetIndexRangeBegin(uint64_t value) { m_indexRangeBegin = value; }
   void SetIndexRangeEnd(uint64_t value) { m_indexRangeEnd = value; }
 
-  uint64_t GetIndexRangeBegin() { return m_indexRangeBegin; }
-  uint64_t GetIndexRangeEnd() { return m_indexRangeEnd; }
+  uint64_t GetIndexRangeBegin() const { return m_indexRangeBegin; }
+  uint64_t GetIndexRangeEnd() const { return m_indexRangeEnd; }
 
   void SetIsRangeExact(bool isRangeExact) { m_isRangeExact = isRangeExact; }
 
@@ -19,6 +19,7 @@
 #include <pugixml.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <map>
 
 using namespace pugi;
@@ -658,3 +659,49 @@ void DRM::TranslateLicenseUrlPh(std::string& url,
     STRING::ReplaceFirst(url, "{CHA-MD5}", md5.HexDigest());
   }
 }
+
+uint32_t DRM::CCdmSessionRouter::GeneratePromiseId()
+{
+  static std::atomic<uint32_t> lastPromiseId{0};
+  return ++lastPromiseId;
+}
+
+uint32_t DRM::CCdmSessionRouter::AddPromise()
+{
+  const uint32_t promiseId = GeneratePromiseId();
+  m_promises.emplace(promiseId, std::nullopt);
+  return promiseId;
+}
+
+bool DRM::CCdmSessionRouter::TakePromiseResult(uint32_t promiseId, bool& isResolved)
+{
+  auto itPromise = m_promises.find(promiseId);
+  if (itPromise == m_promises.end() || !itPromise->second.has_value())
+    return false;
+
+  isResolved = itPromise->second.value();
+  m_promises.erase(itPromise);
+  return true;
+}
+
+bool DRM::CCdmSessionRouter::Route(const CdmMessage& message)
+{
+  if (message.type == CdmMessageType::PROMISE_RESOLVED ||
+      message.type == CdmMessageType::PROMISE_REJECTED)
+  {
+    auto itPromise = m_promises.find(message.promiseId);
+    if (itPromise == m_promises.end())
+      return false; // Promise of another license session, or not awaited
+
+    const bool isResolved = message.type == CdmMessageType::PROMISE_RESOLVED;
+    itPromise->second = isResolved;
+
+    // The promise of a created or loaded session provides the session id
+    if (isResolved && !message.sessionId.empty())
+      m_sessionId = message.sessionId;
+
+    return true;
+  }
+
+  return !m_sessionId.empty() && m_sessionId == message.sessionId;
+}
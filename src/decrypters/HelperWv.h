@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -32,7 +33,10 @@ enum class CdmMessageType
   UNKNOWN,
   SESSION_MESSAGE,
   SESSION_KEY_CHANGE,
+  SESSION_EXPIRATION_CHANGE,
   EVENT_KEY_REQUIRED,
+  PROMISE_RESOLVED,
+  PROMISE_REJECTED,
 };
 
 struct CdmMessage
@@ -40,7 +44,8 @@ struct CdmMessage
   std::string sessionId;
   CdmMessageType type{CdmMessageType::UNKNOWN};
   std::vector<uint8_t> data;
-  uint32_t status{0};
+  uint32_t status{0}; // For SESSION_EXPIRATION_CHANGE, the time in seconds since the epoch
+  uint32_t promiseId{0}; // For PROMISE_RESOLVED / PROMISE_REJECTED
 };
 
 class ATTR_DLL_LOCAL IWVObserver // Observer called by IWVSubject interface
@@ -130,4 +135,58 @@ void TranslateLicenseUrlPh(std::string& url,
                            const std::vector<uint8_t>& challenge,
                            const bool isNewConfig);
 
+/*!
+ * \brief Keep track of the CDM promises and of the session id of a license session,
+ *        to select the CDM messages that belong to it, since the CDM messages are sent
+ *        to all the license sessions that share the CDM. The CDM provides the session id
+ *        by resolving the promise of the session creation, before any other message of
+ *        the session. The calls must be serialized by the owner.
+ */
+class ATTR_DLL_LOCAL CCdmSessionRouter
+{
+public:
+  /*!
+   * \brief Generate a new promise id, unique across all the license sessions.
+   * \return The promise id
+   */
+  static uint32_t GeneratePromiseId();
+
+  /*!
+   * \brief Register a new promise to be settled by the CDM.
+   * \return The promise id
+   */
+  uint32_t AddPromise();
+
+  /*!
+   * \brief Get the result of a promise registered with AddPromise, when settled
+   *        the promise is removed.
+   * \param promiseId The promise id
+   * \param isResolved [OUT] True if the promise has been resolved, false if rejected
+   * \return True if the promise has been settled, otherwise false
+   */
+  bool TakePromiseResult(uint32_t promiseId, bool& isResolved);
+
+  /*!
+   * \brief Remove a promise no longer awaited, e.g. on timeout.
+   * \param promiseId The promise id
+   */
+  void RemovePromise(uint32_t promiseId) { m_promises.erase(promiseId); }
+
+  /*!
+   * \brief Check if a CDM message belongs to the license session, the promise messages
+   *        update the state of the promises, and the session id when a session is created.
+   * \param message The CDM message
+   * \return True if the message belongs to the license session, otherwise false
+   */
+  bool Route(const CdmMessage& message);
+
+  const std::string& GetSessionId() const { return m_sessionId; }
+  void ClearSessionId() { m_sessionId.clear(); }
+
+private:
+  // The awaited promises, the value is set when settled, true if resolved
+  std::map<uint32_t, std::optional<bool>> m_promises;
+  std::string m_sessionId;
+};
+
 } // namespace DRM
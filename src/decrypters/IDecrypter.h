@@ -131,6 +131,21 @@ public:
       bool skipSessionMessage,
       CryptoMode cryptoMode) = 0;
 
+  /**
+   * \brief Set the KeyIds known for the current period, before the single sample decrypters
+   *        are created. This allow the decrypter to request the keys of all streams with
+   *        a single license request, where supported.
+   * \param keyIds The KeyIds
+   */
+  virtual void SetPeriodKeyIds(const std::vector<std::vector<uint8_t>>& keyIds) {}
+
+  /**
+   * \brief Check if CreateSingleSampleDecrypter can be called concurrently by multiple
+   *        threads, to allow the license requests of different PSSH sets in parallel.
+   * \return True if supported, otherwise false
+   */
+  virtual bool IsConcurrentSessionsSupported() { return false; }
+
   /**
    * \brief Determine the capabilities of the decrypter against the supplied media type and KeyID
    * \param decrypter The single sample decrypter to use for this check
@@ -0,0 +1,193 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "LicenseCache.h"
+
+#include "utils/Base64Utils.h"
+#include "utils/DigestMD5Utils.h"
+#include "utils/FileUtils.h"
+#include "utils/StringUtils.h"
+#include "utils/Utils.h"
+#include "utils/log.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+using namespace UTILS;
+
+namespace
+{
+constexpr std::string_view CACHE_FILENAME = "license_cache.json";
+
+std::string GetEntryKey(std::string_view keySystem,
+                        std::string_view licenseUrl,
+                        const std::vector<uint8_t>& keyId)
+{
+  // The same KID can be served by different license servers, with different licenses
+  std::string key{keySystem};
+  key += "_";
+  key += DIGEST::GenerateMD5(std::string{licenseUrl});
+  key += "_";
+  key += STRING::ToHexadecimal(keyId);
+  return key;
+}
+
+std::string GetCacheFilePath()
+{
+  return FILESYS::PathCombine(FILESYS::GetAddonUserPath(), CACHE_FILENAME);
+}
+} // unnamed namespace
+
+bool DRM::CLicenseCache::Get(std::string_view keySystem,
+                             std::string_view licenseUrl,
+                             const std::vector<uint8_t>& keyId,
+                             std::string& data)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (!m_isLoaded)
+    LoadFromDisk();
+
+  auto itEntry = m_entries.find(GetEntryKey(keySystem, licenseUrl, keyId));
+  if (itEntry == m_entries.end())
+  {
+    m_misses++;
+    return false;
+  }
+
+  if (itEntry->second.m_expireTime <= GetTimestamp())
+  {
+    LOG::Log(LOGDEBUG, "License cache: Entry for KID %s is expired",
+             STRING::ToHexadecimal(keyId).c_str());
+    const bool isPersistent = itEntry->second.m_isPersistent;
+    m_entries.erase(itEntry);
+    if (isPersistent)
+      SaveToDisk();
+
+    m_misses++;
+    return false;
+  }
+
+  data = itEntry->second.m_data;
+  m_hits++;
+  return true;
+}
+
+void DRM::CLicenseCache::Set(std::string_view keySystem,
+                             std::string_view licenseUrl,
+                             const std::vector<uint8_t>& keyId,
+                             const std::string& data,
+                             bool isPersistent,
+                             uint64_t ttl /* = LICENSE_CACHE_DEFAULT_TTL */)
+{
+  if (keyId.empty() || ttl == 0)
+    return;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (!m_isLoaded)
+    LoadFromDisk();
+
+  Entry& entry = m_entries[GetEntryKey(keySystem, licenseUrl, keyId)];
+  entry.m_data = data;
+  entry.m_expireTime = GetTimestamp() + ttl;
+  entry.m_isPersistent = isPersistent;
+
+  if (isPersistent)
+    SaveToDisk();
+}
+
+void DRM::CLicenseCache::Remove(std::string_view keySystem,
+                                std::string_view licenseUrl,
+                                const std::vector<uint8_t>& keyId)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto itEntry = m_entries.find(GetEntryKey(keySystem, licenseUrl, keyId));
+  if (itEntry == m_entries.end())
+    return;
+
+  const bool isPersistent = itEntry->second.m_isPersistent;
+  m_entries.erase(itEntry);
+  if (isPersistent)
+    SaveToDisk();
+}
+
+void DRM::CLicenseCache::ResetStats()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_hits = 0;
+  m_misses = 0;
+}
+
+void DRM::CLicenseCache::LoadFromDisk()
+{
+  m_isLoaded = true;
+
+  std::string fileData;
+  if (!FILESYS::ReadFile(GetCacheFilePath(), fileData) || fileData.empty())
+    return;
+
+  rapidjson::Document jDoc;
+  jDoc.Parse(fileData.c_str(), fileData.size());
+
+  if (!jDoc.IsObject())
+  {
+    LOG::LogF(LOGERROR, "Malformed JSON data in license cache file");
+    return;
+  }
+
+  const uint64_t now = GetTimestamp();
+
+  for (auto& jChildObj : jDoc.GetObject())
+  {
+    const rapidjson::Value& jEntry = jChildObj.value;
+    if (!jEntry.IsObject() || !jEntry.HasMember("data") || !jEntry["data"].IsString() ||
+        !jEntry.HasMember("expire") || !jEntry["expire"].IsUint64())
+      continue;
+
+    const uint64_t expireTime = jEntry["expire"].GetUint64();
+    if (expireTime <= now)
+      continue;
+
+    Entry& entry = m_entries[jChildObj.name.GetString()];
+    entry.m_data = BASE64::DecodeToStr(jEntry["data"].GetString());
+    entry.m_expireTime = expireTime;
+    entry.m_isPersistent = true;
+  }
+
+  LOG::Log(LOGDEBUG, "License cache: Loaded %zu entries from disk", m_entries.size());
+}
+
+void DRM::CLicenseCache::SaveToDisk()
+{
+  rapidjson::Document jDoc;
+  jDoc.SetObject();
+  auto& allocator = jDoc.GetAllocator();
+
+  for (const auto& [key, entry] : m_entries)
+  {
+    if (!entry.m_isPersistent)
+      continue;
+
+    const std::string b64Data = BASE64::Encode(entry.m_data);
+
+    rapidjson::Value jEntry{rapidjson::kObjectType};
+    jEntry.AddMember("data", rapidjson::Value(b64Data.c_str(), allocator), allocator);
+    jEntry.AddMember("expire", entry.m_expireTime, allocator);
+    jDoc.AddMember(rapidjson::Value(key.c_str(), allocator), jEntry, allocator);
+  }
+
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer{buffer};
+  jDoc.Accept(writer);
+
+  if (!FILESYS::SaveFile(GetCacheFilePath(), buffer.GetString(), true))
+    LOG::LogF(LOGERROR, "Cannot save the license cache file");
+}
@@ -0,0 +1,111 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace DRM
+{
+// Time to live of a cached license that has no expiration time, in seconds
+constexpr uint64_t LICENSE_CACHE_DEFAULT_TTL = 24 * 60 * 60;
+
+/*!
+ * \brief Cache of the license data obtained from the license servers, identified by
+ *        key system, license server URL and KID, to avoid the license exchange on the
+ *        next playbacks. What is stored depends on the key system, e.g. ClearKey store
+ *        the clear key, Widevine store the session id of a persistent license session.
+ *        Entries are kept in memory, and persistent entries are also saved on disk,
+ *        so persistent entries must never contain raw content keys.
+ */
+class CLicenseCache
+{
+public:
+  CLicenseCache(CLicenseCache& other) = delete; // Not clonable
+  void operator=(const CLicenseCache&) = delete; // Not assignable
+
+  static CLicenseCache& GetInstance()
+  {
+    static CLicenseCache instance;
+    return instance;
+  }
+
+  /*!
+   * \brief Get the cached license data.
+   * \param keySystem The key system
+   * \param licenseUrl The license server URL
+   * \param keyId The KID
+   * \param data [OUT] The license data
+   * \return True if found and not expired, otherwise false
+   */
+  bool Get(std::string_view keySystem,
+           std::string_view licenseUrl,
+           const std::vector<uint8_t>& keyId,
+           std::string& data);
+
+  /*!
+   * \brief Add or replace the license data.
+   * \param keySystem The key system
+   * \param licenseUrl The license server URL
+   * \param keyId The KID
+   * \param data The license data
+   * \param isPersistent If true the data will be also saved on disk
+   * \param ttl The time to live of the data, in seconds,
+   *            should be taken from the license expiration time when available
+   */
+  void Set(std::string_view keySystem,
+           std::string_view licenseUrl,
+           const std::vector<uint8_t>& keyId,
+           const std::string& data,
+           bool isPersistent,
+           uint64_t ttl = LICENSE_CACHE_DEFAULT_TTL);
+
+  /*!
+   * \brief Remove the license data, e.g. when no longer valid.
+   * \param keySystem The key system
+   * \param licenseUrl The license server URL
+   * \param keyId The KID
+   */
+  void Remove(std::string_view keySystem,
+              std::string_view licenseUrl,
+              const std::vector<uint8_t>& keyId);
+
+  /*!
+   * \brief Reset the hits/misses counters, e.g. at DRM initialization.
+   */
+  void ResetStats();
+
+  uint32_t GetHits() const { return m_hits; }
+  uint32_t GetMisses() const { return m_misses; }
+
+private:
+  CLicenseCache() = default;
+
+  void LoadFromDisk();
+  void SaveToDisk();
+
+  struct Entry
+  {
+    std::string m_data;
+    uint64_t m_expireTime{0}; // Timestamp in seconds
+    bool m_isPersistent{false};
+  };
+
+  std::mutex m_mutex;
+  std::map<std::string, Entry> m_entries; // Key: "{key system}_{URL MD5}_{hex KID}"
+  bool m_isLoaded{false};
+  uint32_t m_hits{0};
+  uint32_t m_misses{0};
+};
+
+} // namespace DRM
@@ -11,6 +11,8 @@
 #include "ClearKeyDecrypter.h"
 #include "CompSettings.h"
 #include "SrvBroker.h"
+#include "decrypters/Helpers.h"
+#include "decrypters/LicenseCache.h"
 #include "utils/Base64Utils.h"
 #include "utils/CurlUtils.h"
 #include "utils/FileUtils.h"
@@ -27,6 +29,9 @@ using namespace UTILS;
 
 namespace
 {
+// Max time to wait for the key of a new KID, before failing the decryption
+constexpr std::chrono::seconds KEY_REQUEST_TIMEOUT{10};
+
 void CkB64Encode(std::string& str)
 {
   STRING::ReplaceAll(str, "+", "-");
@@ -38,78 +43,66 @@ void CkB64Decode(std::string& str)
   STRING::ReplaceAll(str, "-", "+");
   STRING::ReplaceAll(str, "_", "/");
 }
+
+std::unique_ptr<AP4_CencSingleSampleDecrypter> CreateCipher(const std::string& key)
+{
+  AP4_CencSingleSampleDecrypter* decrypter{nullptr};
+  if (AP4_FAILED(AP4_CencSingleSampleDecrypter::Create(
+          AP4_CENC_CIPHER_AES_128_CTR, reinterpret_cast<const AP4_UI08*>(key.data()),
+          static_cast<AP4_Size>(key.size()), 0, 0, nullptr, false, decrypter)))
+  {
+    return nullptr;
+  }
+  return std::unique_ptr<AP4_CencSingleSampleDecrypter>(decrypter);
 }
+} // unnamed namespace
 
 CClearKeyCencSingleSampleDecrypter::CClearKeyCencSingleSampleDecrypter(
     std::string_view licenseUrl,
     const std::map<std::string, std::string>& licenseHeaders,
     const std::vector<uint8_t>& defaultKeyId,
+    const std::vector<std::vector<uint8_t>>& keyIds,
     CClearKeyDecrypter* host)
-  : m_host(host)
+  : m_licenseUrl(licenseUrl),
+    m_licenseHeaders(licenseHeaders),
+    m_defaultKeyId(defaultKeyId),
+    m_host(host)
 {
+  SetParentIsOwner(false);
+
   if (licenseUrl.empty())
   {
     LOG::LogF(LOGERROR, "License server URL not found");
     return;
   }
 
-  const std::string postData = CreateLicenseRequest(defaultKeyId);
-
-  if (CSrvBroker::GetSettings().IsDebugLicense())
+  std::vector<std::vector<uint8_t>> allKeyIds{defaultKeyId};
+  for (const std::vector<uint8_t>& keyId : keyIds)
   {
-    const std::string debugFilePath =
-        FILESYS::PathCombine(m_host->GetLibraryPath(), "ClearKey.init");
-    FILESYS::SaveFile(debugFilePath, postData.c_str(), true);
+    if (!keyId.empty() && std::find(allKeyIds.begin(), allKeyIds.end(), keyId) == allKeyIds.end())
+      allKeyIds.emplace_back(keyId);
   }
 
-  CURL::CUrl curl{licenseUrl, postData};
-  curl.AddHeader("Accept", "application/json");
-  curl.AddHeader("Content-Type", "application/json");
-  curl.AddHeaders(licenseHeaders);
-
-  std::string response;
-  int statusCode = curl.Open();
-  if (statusCode == -1 || statusCode >= 400)
+  // Request the keys of all known KID's not cached, with a single license request,
+  // the default KID is always the first one
+  std::vector<std::vector<uint8_t>> reqKeyIds;
+  for (const std::vector<uint8_t>& keyId : allKeyIds)
   {
-    LOG::Log(LOGERROR, "License server returned failure (HTTP error %i)", statusCode);
-    return;
+    if (!AddCachedKey(keyId))
+      reqKeyIds.emplace_back(keyId);
   }
 
-  if (curl.Read(response) != CURL::ReadStatus::IS_EOF)
+  if (reqKeyIds.empty())
   {
-    LOG::LogF(LOGERROR, "Could not read the license server response");
+    LOG::Log(LOGDEBUG, "ClearKey: All keys obtained from the license cache");
     return;
   }
 
-  if (CSrvBroker::GetSettings().IsDebugLicense())
-  {
-    const std::string debugFilePath =
-        FILESYS::PathCombine(m_host->GetLibraryPath(), "ClearKey.response");
-    FILESYS::SaveFile(debugFilePath, response, true);
-  }
-
-  if (!ParseLicenseResponse(response))
-  {
-    LOG::LogF(LOGERROR, "Could not parse the license server response");
+  if (!RequestLicense(reqKeyIds))
     return;
-  }
 
-  const std::string b64DefaultKeyId = BASE64::Encode(defaultKeyId);
-  if (!STRING::KeyExists(m_keyPairs, b64DefaultKeyId))
-  {
+  if (!HasKeyId(defaultKeyId))
     LOG::LogF(LOGERROR, "Key not found on license server response");
-    return;
-  }
-
-  const std::vector<uint8_t> keyBytes = BASE64::Decode(m_keyPairs[b64DefaultKeyId]);
-  if (AP4_FAILED(AP4_CencSingleSampleDecrypter::Create(AP4_CENC_CIPHER_AES_128_CTR, keyBytes.data(),
-                                                       static_cast<AP4_Size>(keyBytes.size()), 0, 0,
-                                                       nullptr, false, m_singleSampleDecrypter)))
-  {
-    LOG::LogF(LOGERROR, "Failed to create AP4_CencSingleSampleDecrypter");
-  }
-  SetParentIsOwner(false);
-  AddSessionKey(defaultKeyId);
 }
 
 CClearKeyCencSingleSampleDecrypter::CClearKeyCencSingleSampleDecrypter(
@@ -117,48 +110,103 @@ CClearKeyCencSingleSampleDecrypter::CClearKeyCencSingleSampleDecrypter(
     const std::vector<uint8_t>& defaultKeyId,
     const std::map<std::string, std::string>& keys,
     CClearKeyDecrypter* host)
-  : m_host(host)
+  : m_propKeys(keys), m_defaultKeyId(defaultKeyId), m_host(host)
 {
-  std::vector<uint8_t> hexKey;
+  SetParentIsOwner(false);
 
   if (keys.empty()) // Assume key is provided from the manifest
   {
-    hexKey = initData;
+    AddKey(defaultKeyId, initData);
+    return;
   }
-  else // Key provided in Kodi props
-  {
-    const std::string hexDefKid = STRING::ToHexadecimal(defaultKeyId);
 
-    if (STRING::KeyExists(keys, hexDefKid))
-      STRING::ToHexBytes(keys.at(hexDefKid), hexKey);
-    else
-      LOG::LogF(LOGERROR, "Missing KeyId \"%s\" on DRM configuration", defaultKeyId.data());
+  // Keys provided in Kodi props, add all of them to allow the use of multiple KID's
+  for (const auto& [hexKid, hexKey] : keys)
+  {
+    std::vector<uint8_t> keyId;
+    std::vector<uint8_t> key;
+    if (!STRING::ToHexBytes(hexKid, keyId) || !STRING::ToHexBytes(hexKey, key))
+    {
+      LOG::LogF(LOGERROR, "Ignored malformed KID/key pair for KID \"%s\"", hexKid.c_str());
+      continue;
+    }
+    AddKey(keyId, key);
   }
 
-  AP4_CencSingleSampleDecrypter::Create(AP4_CENC_CIPHER_AES_128_CTR, hexKey.data(),
-                                        static_cast<AP4_Size>(hexKey.size()), 0, 0, nullptr, false,
-                                        m_singleSampleDecrypter);
-  SetParentIsOwner(false);
-  AddSessionKey(defaultKeyId);
+  if (!HasKeyId(defaultKeyId))
+  {
+    LOG::LogF(LOGERROR, "Missing KeyId \"%s\" on DRM configuration",
+              STRING::ToHexadecimal(defaultKeyId).c_str());
+  }
 }
 
-void CClearKeyCencSingleSampleDecrypter::AddSessionKey(const std::vector<uint8_t>& keyId)
+CClearKeyCencSingleSampleDecrypter::~CClearKeyCencSingleSampleDecrypter()
 {
-  if (std::find(m_keyIds.begin(), m_keyIds.end(), keyId) == m_keyIds.end())
-    m_keyIds.emplace_back(keyId);
+  // Wait for the key requests in progress, they use the class members
+  m_keyRequestPool.reset();
 }
 
 bool CClearKeyCencSingleSampleDecrypter::HasKeyId(const std::vector<uint8_t>& keyid)
 {
-  if (!keyid.empty())
+  if (keyid.empty())
+    return false;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return STRING::KeyExists(m_keys, keyid);
+}
+
+bool CClearKeyCencSingleSampleDecrypter::HasKeys()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return !m_keys.empty();
+}
+
+AP4_Result CClearKeyCencSingleSampleDecrypter::SetFragmentInfo(AP4_UI32 pool_id,
+                                                               const std::vector<uint8_t>& key,
+                                                               const AP4_UI08 nal_length_size,
+                                                               AP4_DataBuffer& annexb_sps_pps,
+                                                               AP4_UI32 flags,
+                                                               CryptoInfo cryptoInfo)
+{
+  // With key rotation the fragment can use a KID not requested before
+  if (!key.empty())
+    EnsureKey(key);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (pool_id >= m_fragmentPool.size())
+    return AP4_ERROR_OUT_OF_RANGE;
+
+  m_fragmentPool[pool_id].m_keyId = key;
+  return AP4_SUCCESS;
+}
+
+AP4_UI32 CClearKeyCencSingleSampleDecrypter::AddPool()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (size_t i{0}; i < m_fragmentPool.size(); ++i)
   {
-    for (const std::vector<uint8_t>& key : m_keyIds)
+    if (!m_fragmentPool[i].m_isUsed)
     {
-      if (key == keyid)
-        return true;
+      m_fragmentPool[i].m_isUsed = true;
+      return static_cast<AP4_UI32>(i);
     }
   }
-  return false;
+  m_fragmentPool.emplace_back();
+  m_fragmentPool.back().m_isUsed = true;
+  return static_cast<AP4_UI32>(m_fragmentPool.size() - 1);
+}
+
+void CClearKeyCencSingleSampleDecrypter::RemovePool(AP4_UI32 poolId)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (poolId >= m_fragmentPool.size())
+    return;
+
+  m_fragmentPool[poolId].m_isUsed = false;
+  m_fragmentPool[poolId].m_keyId.clear();
 }
 
 AP4_Result CClearKeyCencSingleSampleDecrypter::DecryptSampleData(
@@ -170,39 +218,48 @@ AP4_Result CClearKeyCencSingleSampleDecrypter::DecryptSampleData(
     const AP4_UI16* bytes_of_cleartext_data,
     const AP4_UI32* bytes_of_encrypted_data)
 {
-  if (!m_singleSampleDecrypter)
-  {
+  std::vector<uint8_t> keyId;
+  uint32_t generation{0};
+  std::unique_ptr<AP4_CencSingleSampleDecrypter> cipher =
+      AcquireCipher(pool_id, keyId, generation);
+  if (!cipher)
     return AP4_FAILURE;
-  }
-  return (m_singleSampleDecrypter)
-      ->DecryptSampleData(data_in, data_out, iv, subsample_count, bytes_of_cleartext_data,
-                          bytes_of_encrypted_data);
+
+  const AP4_Result result = cipher->DecryptSampleData(
+      data_in, data_out, iv, subsample_count, bytes_of_cleartext_data, bytes_of_encrypted_data);
+
+  ReleaseCipher(keyId, generation, std::move(cipher));
+  return result;
 }
 
 std::string CClearKeyCencSingleSampleDecrypter::CreateLicenseRequest(
-    const std::vector<uint8_t>& defaultKeyId)
+    const std::vector<std::vector<uint8_t>>& keyIds)
 {
   // github.com/Dash-Industry-Forum/ClearKey-Content-Protection/blob/master/README.md
   /* Expected JSON structure for license request:
    * { "kids":
    *     [
-   *         "nrQFDeRLSAKTLifXUIPiZg"
+   *         "nrQFDeRLSAKTLifXUIPiZg",
+   *         "FmY0xnWCPCNaSpRG-tUuTQ"
    *     ]
    * "type":"temporary" }
    */
 
-  std::string b64Kid = BASE64::Encode(defaultKeyId, false);
-  CkB64Encode(b64Kid);
-
   rapidjson::Document jDoc;
   jDoc.SetObject();
   auto& allocator = jDoc.GetAllocator();
 
   rapidjson::Value kids{rapidjson::kArrayType};
-  rapidjson::Value jKid;
 
-  jKid.SetString(b64Kid.c_str(), allocator);
-  kids.PushBack(jKid, allocator);
+  for (const std::vector<uint8_t>& keyId : keyIds)
+  {
+    std::string b64Kid = BASE64::Encode(keyId, false);
+    CkB64Encode(b64Kid);
+
+    rapidjson::Value jKid;
+    jKid.SetString(b64Kid.c_str(), allocator);
+    kids.PushBack(jKid, allocator);
+  }
 
   jDoc.AddMember("kids", kids, allocator);
   jDoc.AddMember("type", "temporary", allocator);
@@ -213,7 +270,7 @@ std::string CClearKeyCencSingleSampleDecrypter::CreateLicenseRequest(
   return buffer.GetString();
 }
 
-bool CClearKeyCencSingleSampleDecrypter::ParseLicenseResponse(std::string data)
+bool CClearKeyCencSingleSampleDecrypter::ParseLicenseResponse(const std::string& data)
 {
   /* Expected JSON structure for license response:
    * { "keys": [
@@ -221,7 +278,9 @@ bool CClearKeyCencSingleSampleDecrypter::ParseLicenseResponse(std::string data)
    *         "k": "FmY0xnWCPCNaSpRG-tUuTQ",
    *         "kid": "nrQFDeRLSAKTLifXUIPiZg",
    *         "kty": "oct"
-   *     }
+   *     },
+   *     ...
+   * ]
    * "type": "temporary"}
    */
 
@@ -234,52 +293,257 @@ bool CClearKeyCencSingleSampleDecrypter::ParseLicenseResponse(std::string data)
     return false;
   }
 
-  for (auto& jChildObj : jDoc.GetObject())
+  if (jDoc.HasMember("Message") && jDoc["Message"].IsString())
   {
+    LOG::LogF(LOGERROR, "Error in license response: %s", jDoc["Message"].GetString());
+    return false;
+  }
+
+  if (!jDoc.HasMember("keys") || !jDoc["keys"].IsArray())
+  {
+    LOG::LogF(LOGERROR, "No keys in license response");
+    return false;
+  }
+
+  for (auto const& jArrayKey : jDoc["keys"].GetArray())
+  {
+    if (!jArrayKey.IsObject())
+      continue;
+
     std::string b64Key;
     std::string b64KeyId;
-    const std::string keyName = jChildObj.name.GetString();
-    rapidjson::Value& jDictVal = jChildObj.value;
 
-    if (keyName == "Message" && jDictVal.IsString())
-    {
-      LOG::LogF(LOGERROR, "Error in license response: %s", jDictVal.GetString());
-      return false;
-    }
+    if (jArrayKey.HasMember("k") && jArrayKey["k"].IsString())
+      b64Key = jArrayKey["k"].GetString();
 
-    if (!jDoc.HasMember("keys"))
-    {
-      LOG::LogF(LOGERROR, "No keys in license response");
-      return false;
-    }
+    if (jArrayKey.HasMember("kid") && jArrayKey["kid"].IsString())
+      b64KeyId = jArrayKey["kid"].GetString();
+
+    if (b64Key.empty() || b64KeyId.empty())
+      continue;
+
+    CkB64Decode(b64Key);
+    BASE64::AddPadding(b64Key);
+
+    CkB64Decode(b64KeyId);
+    BASE64::AddPadding(b64KeyId);
+
+    AddKey(BASE64::Decode(b64KeyId), BASE64::Decode(b64Key));
+  }
+  return true;
+}
+
+void CClearKeyCencSingleSampleDecrypter::SetDefaultKeyId(const std::vector<uint8_t>& keyId)
+{
+  m_defaultKeyId = keyId;
+}
 
-    if (keyName == "keys" && jDictVal.IsArray())
+void CClearKeyCencSingleSampleDecrypter::AddKeyId(const std::vector<uint8_t>& keyId)
+{
+  EnsureKey(keyId);
+}
+
+bool CClearKeyCencSingleSampleDecrypter::RequestLicense(
+    const std::vector<std::vector<uint8_t>>& keyIds)
+{
+  const std::string postData = CreateLicenseRequest(keyIds);
+
+  if (CSrvBroker::GetSettings().IsDebugLicense())
+  {
+    const std::string debugFilePath =
+        FILESYS::PathCombine(m_host->GetLibraryPath(), "ClearKey.init");
+    FILESYS::SaveFile(debugFilePath, postData.c_str(), true);
+  }
+
+  CURL::CUrl curl{m_licenseUrl, postData};
+  curl.AddHeader("Accept", "application/json");
+  curl.AddHeader("Content-Type", "application/json");
+  curl.AddHeaders(m_licenseHeaders);
+
+  std::string response;
+  int statusCode = curl.Open();
+  if (statusCode == -1 || statusCode >= 400)
+  {
+    LOG::Log(LOGERROR, "License server returned failure (HTTP error %i)", statusCode);
+    return false;
+  }
+
+  if (curl.Read(response) != CURL::ReadStatus::IS_EOF)
+  {
+    LOG::LogF(LOGERROR, "Could not read the license server response");
+    return false;
+  }
+
+  if (CSrvBroker::GetSettings().IsDebugLicense())
+  {
+    const std::string debugFilePath =
+        FILESYS::PathCombine(m_host->GetLibraryPath(), "ClearKey.response");
+    FILESYS::SaveFile(debugFilePath, response, true);
+  }
+
+  if (!ParseLicenseResponse(response))
+  {
+    LOG::LogF(LOGERROR, "Could not parse the license server response");
+    return false;
+  }
+
+  for (const std::vector<uint8_t>& keyId : keyIds)
+  {
+    if (!HasKeyId(keyId))
     {
-      // NOTE: for now we assume that one key only is requested and one only will come in the license response
-      for (auto const& jArrayKey : jDictVal.GetArray())
-      {
-        if (jArrayKey.IsObject())
-        {
-          if (jArrayKey.HasMember("k") && jArrayKey["k"].IsString())
-            b64Key = jArrayKey["k"].GetString();
-
-          if (jArrayKey.HasMember("kid") && jArrayKey["kid"].IsString())
-            b64KeyId = jArrayKey["kid"].GetString();
-        }
-
-        if (!b64Key.empty() && !b64KeyId.empty())
-        {
-          CkB64Decode(b64Key);
-          BASE64::AddPadding(b64Key);
-
-          CkB64Decode(b64KeyId);
-          BASE64::AddPadding(b64KeyId);
-
-          m_keyPairs.emplace(b64KeyId, b64Key);
-          break;
-        }
-      }
+      LOG::LogF(LOGWARNING, "Key for KID \"%s\" not found on license server response",
+                STRING::ToHexadecimal(keyId).c_str());
+      continue;
     }
+
+    // ClearKey licenses have no expiration time, and the raw keys must not be saved
+    // on disk, so they are cached in memory only
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DRM::CLicenseCache::GetInstance().Set(DRM::KS_CLEARKEY, m_licenseUrl, keyId,
+                                          m_keys[keyId].m_clearKey, false);
   }
   return true;
 }
+
+bool CClearKeyCencSingleSampleDecrypter::AddKey(const std::vector<uint8_t>& keyId,
+                                                const std::vector<uint8_t>& key)
+{
+  const std::string clearKey{key.begin(), key.end()};
+  std::unique_ptr<AP4_CencSingleSampleDecrypter> cipher = CreateCipher(clearKey);
+  if (!cipher)
+  {
+    LOG::LogF(LOGERROR, "Failed to create AP4_CencSingleSampleDecrypter for KID \"%s\"",
+              STRING::ToHexadecimal(keyId).c_str());
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  KeyData& keyData = m_keys[keyId];
+  // Replace the ciphers of the old key, if any, the ciphers of the old key
+  // in use by concurrent decryptions are discarded when given back
+  keyData.m_clearKey = clearKey;
+  keyData.m_generation++;
+  keyData.m_ciphers.clear();
+  keyData.m_ciphers.emplace_back(std::move(cipher));
+  return true;
+}
+
+void CClearKeyCencSingleSampleDecrypter::EnsureKey(const std::vector<uint8_t>& keyId)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (STRING::KeyExists(m_keys, keyId) || STRING::KeyExists(m_failedKeyIds, keyId) ||
+      STRING::KeyExists(m_pendingKeys, keyId))
+  {
+    return;
+  }
+
+  // The license request can take a while, so it is done in background
+  if (!m_keyRequestPool)
+    m_keyRequestPool = std::make_unique<CThreadPool>(1);
+
+  m_pendingKeys[keyId] = m_keyRequestPool->Submit([this, keyId] { ObtainKey(keyId); }).share();
+}
+
+void CClearKeyCencSingleSampleDecrypter::ObtainKey(const std::vector<uint8_t>& keyId)
+{
+  const std::string hexKid = STRING::ToHexadecimal(keyId);
+  LOG::Log(LOGDEBUG, "ClearKey: Requesting key for new KID \"%s\"", hexKid.c_str());
+
+  if (AddCachedKey(keyId))
+  {
+    LOG::Log(LOGDEBUG, "ClearKey: Key for KID \"%s\" obtained from the license cache",
+             hexKid.c_str());
+  }
+  else if (!m_licenseUrl.empty())
+  {
+    RequestLicense({keyId});
+  }
+  else if (STRING::KeyExists(m_propKeys, hexKid))
+  {
+    std::vector<uint8_t> key;
+    if (STRING::ToHexBytes(m_propKeys[hexKid], key))
+      AddKey(keyId, key);
+  }
+
+  const bool isFailed = !HasKeyId(keyId);
+  if (isFailed)
+    LOG::LogF(LOGERROR, "Cannot get the key for KID \"%s\"", hexKid.c_str());
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (isFailed)
+    m_failedKeyIds.emplace(keyId);
+  m_pendingKeys.erase(keyId);
+}
+
+void CClearKeyCencSingleSampleDecrypter::WaitPendingKey(const std::vector<uint8_t>& keyId)
+{
+  std::shared_future<void> pendingKey;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto itPending = m_pendingKeys.find(keyId);
+    if (itPending == m_pendingKeys.end())
+      return;
+    pendingKey = itPending->second;
+  }
+
+  if (pendingKey.wait_for(KEY_REQUEST_TIMEOUT) == std::future_status::timeout)
+  {
+    LOG::LogF(LOGWARNING, "Timeout waiting for the key of KID \"%s\"",
+              STRING::ToHexadecimal(keyId).c_str());
+  }
+}
+
+bool CClearKeyCencSingleSampleDecrypter::AddCachedKey(const std::vector<uint8_t>& keyId)
+{
+  std::string cachedKey;
+  if (!DRM::CLicenseCache::GetInstance().Get(DRM::KS_CLEARKEY, m_licenseUrl, keyId,
+                                             cachedKey))
+  {
+    return false;
+  }
+
+  const std::vector<uint8_t> key{cachedKey.begin(), cachedKey.end()};
+  return AddKey(keyId, key);
+}
+
+std::unique_ptr<AP4_CencSingleSampleDecrypter> CClearKeyCencSingleSampleDecrypter::AcquireCipher(
+    AP4_UI32 poolId, std::vector<uint8_t>& keyId, uint32_t& generation)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    keyId = m_defaultKeyId;
+    if (poolId < m_fragmentPool.size() && !m_fragmentPool[poolId].m_keyId.empty())
+      keyId = m_fragmentPool[poolId].m_keyId;
+  }
+
+  // The key of a rotated KID could be still in request
+  WaitPendingKey(keyId);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto itKey = m_keys.find(keyId);
+  if (itKey == m_keys.end())
+    return nullptr;
+
+  KeyData& keyData = itKey->second;
+  generation = keyData.m_generation;
+
+  if (keyData.m_ciphers.empty())
+    return CreateCipher(keyData.m_clearKey);
+
+  std::unique_ptr<AP4_CencSingleSampleDecrypter> cipher = std::move(keyData.m_ciphers.back());
+  keyData.m_ciphers.pop_back();
+  return cipher;
+}
+
+void CClearKeyCencSingleSampleDecrypter::ReleaseCipher(
+    const std::vector<uint8_t>& keyId,
+    uint32_t generation,
+    std::unique_ptr<AP4_CencSingleSampleDecrypter> cipher)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto itKey = m_keys.find(keyId);
+  // Discard the cipher of a replaced key
+  if (itKey != m_keys.end() && itKey->second.m_generation == generation)
+    itKey->second.m_ciphers.emplace_back(std::move(cipher));
+}
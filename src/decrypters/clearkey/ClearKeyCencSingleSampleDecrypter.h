@@ -8,8 +8,13 @@
 
 #include "common/AdaptiveCencSampleDecrypter.h"
 #include "decrypters/IDecrypter.h"
+#include "utils/ThreadPool.h"
 
+#include <future>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 
 class CClearKeyDecrypter;
 
@@ -19,23 +24,22 @@ public:
   CClearKeyCencSingleSampleDecrypter(std::string_view licenseUrl,
                                      const std::map<std::string, std::string>& licenseHeaders,
                                      const std::vector<uint8_t>& defaultKeyId,
+                                     const std::vector<std::vector<uint8_t>>& keyIds,
                                      CClearKeyDecrypter* host);
   CClearKeyCencSingleSampleDecrypter(const std::vector<uint8_t>& initdata,
                                      const std::vector<uint8_t>& defaultKeyId,
                                      const std::map<std::string, std::string>& keys,
                                      CClearKeyDecrypter* host);
-  virtual ~CClearKeyCencSingleSampleDecrypter(){};
-  void AddSessionKey(const std::vector<uint8_t>& keyId);
+  virtual ~CClearKeyCencSingleSampleDecrypter();
   bool HasKeyId(const std::vector<uint8_t>& keyid);
   virtual AP4_Result SetFragmentInfo(AP4_UI32 pool_id,
                                      const std::vector<uint8_t>& key,
                                      const AP4_UI08 nal_length_size,
                                      AP4_DataBuffer& annexb_sps_pps,
                                      AP4_UI32 flags,
-                                     CryptoInfo cryptoInfo) override
-  {
-    return AP4_SUCCESS;
-  }
+                                     CryptoInfo cryptoInfo) override;
+  virtual AP4_UI32 AddPool() override;
+  virtual void RemovePool(AP4_UI32 poolId) override;
   virtual AP4_Result DecryptSampleData(AP4_UI32 pool_id,
                                        AP4_DataBuffer& data_in,
                                        AP4_DataBuffer& data_out,
@@ -43,17 +47,111 @@ public:
                                        unsigned int subsample_count,
                                        const AP4_UI16* bytes_of_cleartext_data,
                                        const AP4_UI32* bytes_of_encrypted_data) override;
-  std::string CreateLicenseRequest(const std::vector<uint8_t>& defaultKeyId);
-  bool ParseLicenseResponse(std::string data);
-  void SetDefaultKeyId(const std::vector<uint8_t>& keyId) override{};
-  void AddKeyId(const std::vector<uint8_t>& keyId) override{};
-  bool HasKeys() { return !m_keyIds.empty(); }
+  std::string CreateLicenseRequest(const std::vector<std::vector<uint8_t>>& keyIds);
+  bool ParseLicenseResponse(const std::string& data);
+  void SetDefaultKeyId(const std::vector<uint8_t>& keyId) override;
+  void AddKeyId(const std::vector<uint8_t>& keyId) override;
+  bool IsConcurrentDecryptSupported() override { return true; }
+  bool HasKeys();
 
 private:
-  AP4_CencSingleSampleDecrypter* m_singleSampleDecrypter{nullptr};
-  std::string m_strSession;
-  std::string m_licenceDefaultKeyId;
-  std::vector<std::vector<uint8_t>> m_keyIds;
-  std::map<std::string, std::string> m_keyPairs;
+  /*!
+   * \brief Request the keys of the specified KID's to the license server,
+   *        with a single license request.
+   * \param keyIds The KID's
+   * \return True if has success, otherwise false
+   */
+  bool RequestLicense(const std::vector<std::vector<uint8_t>>& keyIds);
+
+  /*!
+   * \brief Create the cipher for a KID / key pair.
+   * \param keyId The KID
+   * \param key The key
+   * \return True if has success, otherwise false
+   */
+  bool AddKey(const std::vector<uint8_t>& keyId, const std::vector<uint8_t>& key);
+
+  /*!
+   * \brief Create the cipher for a KID by using the key from the license cache.
+   * \param keyId The KID
+   * \return True if the key is cached and the cipher has been created, otherwise false
+   */
+  bool AddCachedKey(const std::vector<uint8_t>& keyId);
+
+  /*!
+   * \brief Make sure that the key of the specified KID is available,
+   *        if not start to get it in background from the license configuration
+   *        (e.g. key rotation), so the caller (the demux thread) is not blocked.
+   * \param keyId The KID
+   */
+  void EnsureKey(const std::vector<uint8_t>& keyId);
+
+  /*!
+   * \brief Get the key of a KID not yet available, from the license cache,
+   *        the license server or the Kodi property keys.
+   * \param keyId The KID
+   */
+  void ObtainKey(const std::vector<uint8_t>& keyId);
+
+  /*!
+   * \brief Wait for the key request in progress of a KID, if any.
+   * \param keyId The KID
+   */
+  void WaitPendingKey(const std::vector<uint8_t>& keyId);
+
+  /*!
+   * \brief Get a cipher not in use for the KID of the specified pool,
+   *        the cipher must be given back with ReleaseCipher.
+   * \param poolId The pool id
+   * \param keyId [OUT] The KID of the cipher
+   * \param generation [OUT] The generation of the key used to create the cipher
+   * \return The cipher if found, otherwise nullptr
+   */
+  std::unique_ptr<AP4_CencSingleSampleDecrypter> AcquireCipher(AP4_UI32 poolId,
+                                                               std::vector<uint8_t>& keyId,
+                                                               uint32_t& generation);
+
+  /*!
+   * \brief Give back a cipher obtained with AcquireCipher,
+   *        the cipher is discarded when the key has been replaced in the meantime.
+   * \param keyId The KID of the cipher
+   * \param generation The generation of the key used to create the cipher
+   * \param cipher The cipher
+   */
+  void ReleaseCipher(const std::vector<uint8_t>& keyId,
+                     uint32_t generation,
+                     std::unique_ptr<AP4_CencSingleSampleDecrypter> cipher);
+
+  std::mutex m_mutex;
+  std::string m_licenseUrl;
+  std::map<std::string, std::string> m_licenseHeaders;
+  // Clear keys provided by Kodi property (hex KID / hex key pair)
+  std::map<std::string, std::string> m_propKeys;
+  std::vector<uint8_t> m_defaultKeyId;
+
+  struct KeyData
+  {
+    std::string m_clearKey;
+    // Incremented each time the key is replaced (key rotation)
+    uint32_t m_generation{0};
+    // The ciphers not in use, a cipher has a state so it cannot be shared,
+    // more ciphers are created when samples are decrypted concurrently
+    std::vector<std::unique_ptr<AP4_CencSingleSampleDecrypter>> m_ciphers;
+  };
+  // The key data for each KID, guarded by m_mutex
+  std::map<std::vector<uint8_t>, KeyData> m_keys;
+  // KID's failed to be obtained, to avoid request them again on each fragment
+  std::set<std::vector<uint8_t>> m_failedKeyIds;
+  // The key requests in progress for each KID, guarded by m_mutex
+  std::map<std::vector<uint8_t>, std::shared_future<void>> m_pendingKeys;
+  // Worker that obtains the keys of new KID's, created at first use
+  std::unique_ptr<UTILS::CThreadPool> m_keyRequestPool;
+
+  struct FINFO
+  {
+    std::vector<uint8_t> m_keyId;
+    bool m_isUsed{false};
+  };
+  std::vector<FINFO> m_fragmentPool; // Guarded by m_mutex
   CClearKeyDecrypter* m_host;
 };
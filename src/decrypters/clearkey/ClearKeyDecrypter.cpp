@@ -58,8 +58,8 @@ std::shared_ptr<Adaptive_CencSingleSampleDecrypter> CClearKeyDecrypter::CreateSi
   }
   else // Clearkey license server URL provided
   {
-    decrypter = std::make_shared<CClearKeyCencSingleSampleDecrypter>(licenseUrl, licConfig.reqHeaders,
-                                                                     defaultkeyid, this);
+    decrypter = std::make_shared<CClearKeyCencSingleSampleDecrypter>(
+        licenseUrl, licConfig.reqHeaders, defaultkeyid, m_periodKeyIds, this);
   }
 
   if (!decrypter->HasKeys())
@@ -25,6 +25,11 @@ public:
       bool skipSessionMessage,
       CryptoMode cryptoMode) override;
 
+  virtual void SetPeriodKeyIds(const std::vector<std::vector<uint8_t>>& keyIds) override
+  {
+    m_periodKeyIds = keyIds;
+  }
+
   virtual void GetCapabilities(std::shared_ptr<Adaptive_CencSingleSampleDecrypter> decrypter,
                                const std::vector<uint8_t>& keyid,
                                uint32_t media,
@@ -62,9 +67,11 @@ public:
   virtual bool GetBuffer(void* instance, VIDEOCODEC_PICTURE& picture) { return false; }
   virtual void ReleaseBuffer(void* instance, void* buffer) {}
   virtual std::string_view GetLibraryPath() const override { return m_libraryPath; }
+  const DRM::Config& GetConfig() const { return m_config; }
 
 private:
   bool m_isInitialized{false};
   DRM::Config m_config;
   std::string m_libraryPath;
+  std::vector<std::vector<uint8_t>> m_periodKeyIds;
 };
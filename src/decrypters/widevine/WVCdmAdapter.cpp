@@ -99,6 +99,12 @@ void CWVCdmAdapter::OnCDMMessage(const char* session,
     type = CdmMessageType::SESSION_MESSAGE;
   else if (msg == CDMADPMSG::kSessionKeysChange)
     type = CdmMessageType::SESSION_KEY_CHANGE;
+  else if (msg == CDMADPMSG::kSessionExpired)
+    type = CdmMessageType::SESSION_EXPIRATION_CHANGE;
+  else if (msg == CDMADPMSG::kPromiseResolved)
+    type = CdmMessageType::PROMISE_RESOLVED;
+  else if (msg == CDMADPMSG::kPromiseRejected)
+    type = CdmMessageType::PROMISE_REJECTED;
   else
     return;
 
@@ -106,7 +112,11 @@ void CWVCdmAdapter::OnCDMMessage(const char* session,
   cdmMsg.sessionId.assign(session, session + session_size);
   cdmMsg.type = type;
   cdmMsg.data.assign(data, data + data_size);
-  cdmMsg.status = status;
+
+  if (type == CdmMessageType::PROMISE_RESOLVED || type == CdmMessageType::PROMISE_REJECTED)
+    cdmMsg.promiseId = status;
+  else
+    cdmMsg.status = status;
 
   // Send the message to attached CWVCencSingleSampleDecrypter instances
   NotifyObservers(cdmMsg);
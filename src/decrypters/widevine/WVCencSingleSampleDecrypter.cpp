@@ -16,6 +16,7 @@
 #include "WVCdmAdapter.h"
 #include "cdm/media/cdm/cdm_adapter.h"
 #include "decrypters/Helpers.h"
+#include "decrypters/LicenseCache.h"
 #include "utils/Base64Utils.h"
 #include "utils/CurlUtils.h"
 #include "utils/DigestMD5Utils.h"
@@ -24,11 +25,17 @@
 #include "utils/Utils.h"
 #include "utils/log.h"
 
+#include <chrono>
 #include <mutex>
-#include <thread>
 
 using namespace UTILS;
 
+namespace
+{
+// Max time to wait for the CDM to settle a promise or send the related messages
+constexpr std::chrono::seconds CDM_PROMISE_TIMEOUT{5};
+} // unnamed namespace
+
 void CWVCencSingleSampleDecrypter::SetSession(const std::string sessionId,
                                               const uint8_t* data,
                                               const size_t dataSize)
@@ -38,6 +45,7 @@ void CWVCencSingleSampleDecrypter::SetSession(const std::string sessionId,
   m_strSession = sessionId;
   m_challenge.SetData(data, dataSize);
   LOG::LogF(LOGDEBUG, "Opened widevine session ID: %s", m_strSession.c_str());
+  m_cdmMessageCond.notify_all();
 }
 
 CWVCencSingleSampleDecrypter::CWVCencSingleSampleDecrypter(
@@ -51,7 +59,6 @@ CWVCencSingleSampleDecrypter::CWVCencSingleSampleDecrypter(
     m_hdcpVersion(99),
     m_hdcpLimit(0),
     m_resolutionLimit(0),
-    m_promiseId(1),
     m_isDrained(true),
     m_defaultKeyId(defaultKeyId),
     m_EncryptionMode(cryptoMode)
@@ -65,6 +72,7 @@ CWVCencSingleSampleDecrypter::CWVCencSingleSampleDecrypter(
     return;
   }
 
+  // The CDM messages are routed to this decrypter by promise and session id, see OnNotify
   m_cdmAdapter->AttachObserver(this);
 
   if (CSrvBroker::GetSettings().IsDebugLicense())
@@ -74,14 +82,23 @@ CWVCencSingleSampleDecrypter::CWVCencSingleSampleDecrypter(
     UTILS::FILESYS::SaveFile(debugFilePath, {m_pssh.cbegin(), m_pssh.cend()}, true);
   }
 
-  m_cdmAdapter->GetCDM()->CreateSessionAndGenerateRequest(
-      m_promiseId++, cdm::SessionType::kTemporary, cdm::InitDataType::kCenc, m_pssh.data(),
-      static_cast<uint32_t>(m_pssh.size()));
+  // Persistent license sessions allow to re-use the license of previous playbacks,
+  // depends on CDM support, when not supported will fallback to temporary sessions
+  const bool isPersistentLicense = m_cdmAdapter->GetConfig().isPersistentStorage &&
+                                   !m_defaultKeyId.empty() && !skipSessionMessage;
+
+  if (isPersistentLicense && LoadCachedSession())
+    return;
 
-  //! @todo: loop with thread sleep should be removed, use callbacks
-  int retrycount = 0;
-  while (m_strSession.empty() && ++retrycount < 100)
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  cdm::SessionType sessionType =
+      isPersistentLicense ? cdm::SessionType::kPersistentLicense : cdm::SessionType::kTemporary;
+
+  if (!CreateSession(sessionType) && sessionType == cdm::SessionType::kPersistentLicense)
+  {
+    LOG::LogF(LOGDEBUG, "Persistent license session not supported, fallback to temporary session");
+    sessionType = cdm::SessionType::kTemporary;
+    CreateSession(sessionType);
+  }
 
   if (m_strSession.empty())
   {
@@ -95,6 +112,84 @@ CWVCencSingleSampleDecrypter::CWVCencSingleSampleDecrypter(
   //! @todo: this loop is not so clear
   while (m_challenge.GetDataSize() > 0 && SendSessionMessage())
     ;
+
+  std::lock_guard<std::mutex> lock(m_renewalLock);
+  if (sessionType == cdm::SessionType::kPersistentLicense && !m_keys.empty())
+  {
+    // Keep the session until the license expires, if the license has an expiration time
+    uint64_t ttl{LICENSE_CACHE_DEFAULT_TTL};
+    if (m_expiryTime > 0)
+    {
+      const uint64_t now = GetTimestamp();
+      ttl = m_expiryTime > now ? m_expiryTime - now : 0;
+    }
+    CLicenseCache::GetInstance().Set(KS_WIDEVINE, m_cdmAdapter->GetConfig().license.serverUrl,
+                                     m_defaultKeyId, m_strSession, true, ttl);
+  }
+}
+
+bool CWVCencSingleSampleDecrypter::CreateSession(cdm::SessionType sessionType)
+{
+  // The sessions of different PSSH sets can be created concurrently, the messages
+  // of each session are selected by the session id provided with the promise
+  const uint32_t promiseId = AddPromise();
+  m_cdmAdapter->GetCDM()->CreateSessionAndGenerateRequest(
+      promiseId, sessionType, cdm::InitDataType::kCenc, m_pssh.data(),
+      static_cast<uint32_t>(m_pssh.size()));
+
+  // The promise is rejected when the session type is not supported
+  if (!WaitPromise(promiseId))
+    return false;
+
+  // The session message with the license request follows the session creation
+  std::unique_lock<std::mutex> lockSession(m_renewalLock);
+  m_cdmMessageCond.wait_for(lockSession, CDM_PROMISE_TIMEOUT,
+                            [this] { return m_challenge.GetDataSize() > 0; });
+
+  return !m_strSession.empty();
+}
+
+bool CWVCencSingleSampleDecrypter::LoadCachedSession()
+{
+  const std::string& licenseUrl = m_cdmAdapter->GetConfig().license.serverUrl;
+  std::string sessionId;
+  if (!CLicenseCache::GetInstance().Get(KS_WIDEVINE, licenseUrl, m_defaultKeyId, sessionId))
+    return false;
+
+  LOG::LogF(LOGDEBUG, "Loading persistent license session ID: %s", sessionId.c_str());
+
+  const uint32_t promiseId = AddPromise();
+  m_cdmAdapter->GetCDM()->LoadSession(promiseId, cdm::SessionType::kPersistentLicense,
+                                      sessionId.data(), static_cast<uint32_t>(sessionId.size()));
+
+  // The promise is resolved with an empty session id when the session does not exist,
+  // otherwise the keys of the loaded session are notified after the promise is resolved
+  bool isLoaded = WaitPromise(promiseId);
+  {
+    std::unique_lock<std::mutex> lock(m_renewalLock);
+    isLoaded = isLoaded && !m_strSession.empty() &&
+               m_cdmMessageCond.wait_for(lock, CDM_PROMISE_TIMEOUT,
+                                         [this] { return !m_keys.empty(); });
+    if (!isLoaded)
+    {
+      m_strSession.clear();
+      m_sessionRouter.ClearSessionId();
+    }
+  }
+
+  if (!isLoaded)
+  {
+    LOG::LogF(LOGDEBUG, "Cannot load persistent license session, a new license will be requested");
+    CLicenseCache::GetInstance().Remove(KS_WIDEVINE, licenseUrl, m_defaultKeyId);
+    return false;
+  }
+
+  // The license could be renewed by the CDM on loading
+  while (m_challenge.GetDataSize() > 0 && SendSessionMessage())
+    ;
+
+  LOG::LogF(LOGDEBUG, "Persistent license session loaded");
+  return true;
 }
 
 CWVCencSingleSampleDecrypter::~CWVCencSingleSampleDecrypter()
@@ -210,11 +305,13 @@ void CWVCencSingleSampleDecrypter::CloseSessionId()
   if (!m_strSession.empty())
   {
     LOG::LogF(LOGDEBUG, "Closing widevine session ID: %s", m_strSession.c_str());
-    m_cdmAdapter->GetCDM()->CloseSession(++m_promiseId, m_strSession.data(),
-                                                 m_strSession.size());
+    m_cdmAdapter->GetCDM()->CloseSession(CCdmSessionRouter::GeneratePromiseId(),
+                                         m_strSession.data(), m_strSession.size());
 
     LOG::LogF(LOGDEBUG, "Widevine session ID %s closed", m_strSession.c_str());
+    std::lock_guard<std::mutex> lock(m_renewalLock);
     m_strSession.clear();
+    m_sessionRouter.ClearSessionId();
   }
 }
 
@@ -352,11 +449,22 @@ bool CWVCencSingleSampleDecrypter::SendSessionMessage()
     FILESYS::SaveFile(debugFilePath, respData, true);
   }
 
-  m_cdmAdapter->GetCDM()->UpdateSession(++m_promiseId, m_strSession.data(), m_strSession.size(),
+  const uint32_t promiseId = AddPromise();
+  m_cdmAdapter->GetCDM()->UpdateSession(promiseId, m_strSession.data(), m_strSession.size(),
                                         reinterpret_cast<const uint8_t*>(respData.c_str()),
                                         respData.size());
 
-  if (m_keys.empty())
+  // The keys are notified before the promise is resolved
+  if (!WaitPromise(promiseId))
+    LOG::LogF(LOGDEBUG, "License update rejected by the CDM");
+
+  bool hasKeys;
+  {
+    std::lock_guard<std::mutex> lock(m_renewalLock);
+    hasKeys = !m_keys.empty();
+  }
+
+  if (!hasKeys)
   {
     LOG::LogF(LOGERROR, "License update not successful (no keys)");
     CloseSessionId();
@@ -367,10 +475,53 @@ bool CWVCencSingleSampleDecrypter::SendSessionMessage()
   return true;
 }
 
+uint32_t CWVCencSingleSampleDecrypter::AddPromise()
+{
+  std::lock_guard<std::mutex> lock(m_renewalLock);
+  return m_sessionRouter.AddPromise();
+}
+
+bool CWVCencSingleSampleDecrypter::WaitPromise(uint32_t promiseId)
+{
+  std::unique_lock<std::mutex> lock(m_renewalLock);
+  bool isResolved{false};
+  const bool isSettled = m_cdmMessageCond.wait_for(
+      lock, CDM_PROMISE_TIMEOUT,
+      [&] { return m_sessionRouter.TakePromiseResult(promiseId, isResolved); });
+
+  if (!isSettled)
+  {
+    m_sessionRouter.RemovePromise(promiseId);
+    LOG::LogF(LOGWARNING, "Timeout waiting for the CDM promise %u", promiseId);
+    return false;
+  }
+  return isResolved;
+}
+
 void CWVCencSingleSampleDecrypter::OnNotify(const CdmMessage& message)
 {
-  if (!m_strSession.empty() && m_strSession != message.sessionId)
-    return;
+  {
+    std::lock_guard<std::mutex> lock(m_renewalLock);
+    // Ignore the messages of the sessions of other decrypters
+    if (!m_sessionRouter.Route(message))
+      return;
+
+    if (message.type == CdmMessageType::PROMISE_RESOLVED ||
+        message.type == CdmMessageType::PROMISE_REJECTED)
+    {
+      if (!m_sessionRouter.GetSessionId().empty())
+        m_strSession = m_sessionRouter.GetSessionId();
+
+      m_cdmMessageCond.notify_all();
+      return;
+    }
+
+    if (message.type == CdmMessageType::SESSION_EXPIRATION_CHANGE)
+    {
+      m_expiryTime = message.status;
+      return;
+    }
+  }
 
   if (message.type == CdmMessageType::SESSION_MESSAGE)
   {
@@ -389,10 +540,12 @@ void CWVCencSingleSampleDecrypter::AddSessionKey(const uint8_t* data,
   WVSKEY key;
   key.m_keyId.assign(data, data + dataSize);
 
+  std::lock_guard<std::mutex> lock(m_renewalLock);
   std::vector<WVSKEY>::iterator res;
   if ((res = std::find(m_keys.begin(), m_keys.end(), key)) == m_keys.end())
     res = m_keys.insert(res, key);
   res->status = static_cast<cdm::KeyStatus>(status);
+  m_cdmMessageCond.notify_all();
 }
 
 bool CWVCencSingleSampleDecrypter::HasKeyId(const std::vector<uint8_t>& keyid)
@@ -13,6 +13,7 @@
 #include "decrypters/HelperWv.h"
 #include "decrypters/IDecrypter.h"
 
+#include <condition_variable>
 #include <list>
 #include <mutex>
 #include <optional>
@@ -87,6 +88,32 @@ public:
   void OnNotify(const CdmMessage& message) override;
 
 private:
+  /*!
+   * \brief Create a new CDM session and generate the license request.
+   * \param sessionType The CDM session type
+   * \return True if the session has been created, otherwise false
+   */
+  bool CreateSession(cdm::SessionType sessionType);
+
+  /*!
+   * \brief Load the persistent license session from the license cache, if any.
+   * \return True if the session has been loaded with the keys, otherwise false
+   */
+  bool LoadCachedSession();
+
+  /*!
+   * \brief Register a new promise to be settled by the CDM.
+   * \return The promise id to be passed to the CDM
+   */
+  uint32_t AddPromise();
+
+  /*!
+   * \brief Wait for the CDM to resolve or reject a promise registered with AddPromise.
+   * \param promiseId The promise id
+   * \return True if the promise has been resolved, false if rejected or on timeout
+   */
+  bool WaitPromise(uint32_t promiseId);
+
   void CheckLicenseRenewal();
   bool SendSessionMessage();
 
@@ -139,11 +166,13 @@ private:
                 const uint8_t* iv,
                 const FINFO& fragInfo,
                 const std::vector<cdm::SubsampleEntry>& subsamples);
-  uint32_t m_promiseId;
   bool m_isDrained;
 
   std::list<media::CdmVideoFrame> m_videoFrames;
   std::mutex m_renewalLock;
+  std::condition_variable m_cdmMessageCond; // Notified on CDM messages, with m_renewalLock
+  CCdmSessionRouter m_sessionRouter; // Guarded by m_renewalLock
+  uint32_t m_expiryTime{0}; // License expiration time in seconds since the epoch, 0 if none
   CryptoMode m_EncryptionMode;
 
   std::optional<cdm::VideoDecoderConfig_3> m_currentVideoDecConfig;
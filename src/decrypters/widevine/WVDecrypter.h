@@ -28,6 +28,8 @@ public:
       bool skipSessionMessage,
       CryptoMode cryptoMode) override;
 
+  virtual bool IsConcurrentSessionsSupported() override { return true; }
+
   virtual void GetCapabilities(std::shared_ptr<Adaptive_CencSingleSampleDecrypter> decrypter,
                                const std::vector<uint8_t>& keyId,
                                uint32_t media,
@@ -8,10 +8,13 @@
 
 #include "ADTSReader.h"
 
+#include "AdaptiveByteStream.h"
 #include "parser/CodecParser.h"
 #include "utils/log.h"
 #include "utils/Utils.h"
 
+#include <algorithm>
+#include <cstring>
 #include <stdlib.h>
 
 #include <bento4/Ap4ByteStream.h>
@@ -19,6 +22,42 @@
 using namespace adaptive;
 using namespace UTILS;
 
+namespace
+{
+// Size of the data read in bulk from the stream, many frames are parsed from a single read
+constexpr size_t READ_WINDOW_SIZE = 64 * 1024;
+
+/*!
+ * \brief Check if an AC-4 sync frame is followed by the sync word of the next frame.
+ * \param data The data, starting with the AC-4 sync word
+ * \param size The data size
+ * \return True if the next sync word is found, otherwise false
+ */
+bool IsAc4SyncConfirmed(const uint8_t* data, size_t size)
+{
+  // Sync frame: 16 bit sync word (0xAC41 when followed by a 16 bit crc) + 16 bit frame size,
+  // when the frame size is 0xFFFF the size is stored in the following 24 bits
+  if (size < 4)
+    return false;
+
+  size_t headerSize{4};
+  size_t frameSize = static_cast<size_t>(data[2]) << 8 | data[3];
+  if (frameSize == 0xFFFF)
+  {
+    headerSize = 7;
+    if (size < headerSize)
+      return false;
+    frameSize = static_cast<size_t>(data[4]) << 16 | static_cast<size_t>(data[5]) << 8 | data[6];
+  }
+  const size_t nextOffset = headerSize + frameSize + (data[1] == 0x41 ? 2 : 0);
+  if (nextOffset + ADTS_SYNC_INFO_SIZE > size)
+    return false;
+
+  return CAdaptiveAdtsHeaderParser::GetAdtsType(data + nextOffset, size - nextOffset) ==
+         AdtsType::AC4;
+}
+} // unnamed namespace
+
 uint64_t ID3TAG::getSize(const uint8_t* data, unsigned int len, unsigned int shift)
 {
   uint64_t size(0);
@@ -28,292 +67,171 @@ uint64_t ID3TAG::getSize(const uint8_t* data, unsigned int len, unsigned int shi
   return size;
 };
 
-ID3TAG::PARSECODE ID3TAG::parse(AP4_ByteStream* stream)
+size_t ID3TAG::getTagSize(const uint8_t* data, size_t size)
 {
-  uint8_t buffer[64];
-  unsigned int retCount(0);
-
-  while (!AP4_SUCCEEDED(stream->Read(buffer, HEADER_SIZE)))
-  {
-    if (retCount++)
-      return PARSE_FAIL;
-  }
-
   // ID3v2 header
   // 3 byte "ID3" + 1 byte ver + 1 byte revision + 1 byte flags + 4 byte size
-  if (memcmp(buffer, "ID3", 3) != 0)
-  {
-    AP4_Position pos;
-    stream->Tell(pos);
-    stream->Seek(pos - HEADER_SIZE);
+  if (size < HEADER_SIZE || std::memcmp(data, "ID3", 3) != 0)
+    return 0;
+
+  return HEADER_SIZE + static_cast<size_t>(getSize(data + 6, 4, 7));
+}
+
+ID3TAG::PARSECODE ID3TAG::parse(const uint8_t* data, size_t size)
+{
+  const size_t tagSize = getTagSize(data, size);
+  if (tagSize == 0)
     return PARSE_NO_ID3;
-  }
+  if (tagSize > size)
+    return PARSE_FAIL;
 
-  m_majorVer = buffer[3];
-  m_revisionVer = buffer[4];
-  m_flags = buffer[5];
-  uint32_t size = static_cast<uint32_t>(getSize(buffer + 6, 4, 7));
+  m_majorVer = data[3];
+  m_revisionVer = data[4];
+  m_flags = data[5];
 
   //iterate through frames and search timestamp
-  while (size > HEADER_SIZE)
+  const uint8_t* frame = data + HEADER_SIZE;
+  const uint8_t* tagEnd = data + tagSize;
+  while (tagEnd - frame > static_cast<ptrdiff_t>(HEADER_SIZE))
   {
-    if (!AP4_SUCCEEDED(stream->Read(buffer, HEADER_SIZE)))
+    const uint32_t frameSize = static_cast<uint32_t>(getSize(frame + 4, 4, 8));
+    const uint8_t* frameData = frame + HEADER_SIZE;
+    if (frameSize > static_cast<size_t>(tagEnd - frameData))
       return PARSE_FAIL;
 
-    uint32_t frameSize = static_cast<uint32_t>(getSize(buffer + 4, 4, 8));
-
-    if (memcmp(buffer, "PRIV", 4) == 0 && frameSize == 53)
-    {
-      if (!AP4_SUCCEEDED(stream->Read(buffer, frameSize)))
-        return PARSE_FAIL;
-
-      // HLS audio packet timestamp: https://datatracker.ietf.org/doc/html/rfc8216
-      if (strncmp(reinterpret_cast<const char*>(buffer), "com.apple.streaming.transportStreamTimestamp", 44) == 0 && buffer[44] == 0)
-      {
-        m_timestamp = getSize(buffer + 45, 8, 8);
-      }
-    }
-    else
+    // HLS audio packet timestamp: https://datatracker.ietf.org/doc/html/rfc8216
+    if (std::memcmp(frame, "PRIV", 4) == 0 && frameSize == 53 &&
+        std::memcmp(frameData, "com.apple.streaming.transportStreamTimestamp", 44) == 0 &&
+        frameData[44] == 0)
     {
-      AP4_Position curPos;
-      stream->Tell(curPos);
-      stream->Seek(curPos + frameSize);
+      m_timestamp = getSize(frameData + 45, 8, 8);
     }
-    size -= (HEADER_SIZE + frameSize);
+    frame = frameData + frameSize;
   }
   return PARSE_SUCCESS;
 }
 
-void ID3TAG::SkipID3Data(AP4_ByteStream* stream)
-{
-  uint8_t buffer[64];
-
-  if (!AP4_SUCCEEDED(stream->Read(buffer, HEADER_SIZE)))
-  {
-    // Try again
-    if (!AP4_SUCCEEDED(stream->Read(buffer, HEADER_SIZE)))
-      return;
-  }
+/**********************************************************************************************************************************/
 
-  if (std::memcmp(buffer, "ID3", 3) != 0) // No ID3 header
+ADTSFrame::FINDCODE ADTSFrame::FindFrame(const uint8_t* data,
+                                         size_t size,
+                                         size_t& offset,
+                                         ADTSFrameInfo& frameInfo)
+{
+  for (offset = 0; offset + 1 < size; ++offset)
   {
-    AP4_Position currentPos;
-    stream->Tell(currentPos);
-    stream->Seek(currentPos - HEADER_SIZE);
-    return;
-  }
+    // Quick check of the first sync word byte of AAC (0xFF), AC-3/E-AC-3 (0x0B) and AC-4 (0xAC)
+    const uint8_t firstByte = data[offset];
+    if (firstByte != 0xFF && firstByte != 0x0B && firstByte != 0xAC)
+      continue;
 
-  // Get ID3v2 data size
-  uint32_t headerSize = static_cast<uint32_t>(getSize(buffer + 6, 4, 7));
+    if (size - offset < ADTS_SYNC_INFO_SIZE)
+      return FINDCODE::NEED_DATA;
 
-  AP4_Position currentPos;
-  stream->Tell(currentPos);
-  stream->Seek(currentPos + headerSize);
-}
+    const AdtsType adtsType = CAdaptiveAdtsHeaderParser::GetAdtsType(data + offset, size - offset);
+    if (adtsType == AdtsType::NONE)
+      continue;
+    if (adtsType == AdtsType::AC4)
+    {
+      // The sync word could be part of other data, report the unsupported codec only
+      // when the frame is aligned to the previous one or followed by another sync word
+      if (offset == 0 || IsAc4SyncConfirmed(data + offset, size - offset))
+        return FINDCODE::UNSUPPORTED;
+      continue;
+    }
 
-/**********************************************************************************************************************************/
+    if (size - offset < CAdaptiveAdtsHeaderParser::GetHeaderSize(adtsType))
+      return FINDCODE::NEED_DATA;
 
-void ADTSFrame::AdjustStreamForPadding(AP4_ByteStream* stream)
-{
-  AP4_Position currentPos;
-  AP4_Position newPos;
-  stream->Tell(currentPos);
-  stream->Seek(currentPos + 16);
-  stream->Tell(newPos);
-  if (newPos - currentPos == 16)
-    stream->Seek(currentPos);
+    frameInfo.m_codecType = adtsType;
+    if (ParseHeader(data + offset, frameInfo))
+      return FINDCODE::FOUND;
+  }
+  return FINDCODE::NEED_DATA;
 }
 
-ADTSFrame::ADTSFrameInfo ADTSFrame::GetFrameInfo(AP4_ByteStream* stream)
+bool ADTSFrame::ParseHeader(const uint8_t* data, ADTSFrameInfo& frameInfo)
 {
-  ADTSFrameInfo frameInfo;
-  frameInfo.m_codecType = CAdaptiveAdtsHeaderParser::GetAdtsType(stream);
-
   switch (frameInfo.m_codecType)
   {
     case AdtsType::AAC:
-      ParseAacHeader(stream, frameInfo);
-      break;
-    case AdtsType::AC3:
-      ParseAc3Header(stream, frameInfo);
-      break;
-    case AdtsType::EAC3:
-      ParseEc3Header(stream, frameInfo);
-      break;
-    case AdtsType::AC4:
-      break;
-    default:
-      break;
-  }
-  return frameInfo;
-}
+    {
+      AP4_AdtsHeader header(data);
+      if (AP4_FAILED(header.Check()) || header.m_FrameLength < AP4_ADTS_HEADER_SIZE)
+        return false;
 
-bool ADTSFrame::parse(AP4_ByteStream* stream)
-{
-  m_frameInfo.m_codecType = CAdaptiveAdtsHeaderParser::GetAdtsType(stream);
-  switch (m_frameInfo.m_codecType)
-  {
-    case AdtsType::AAC:
-      return ParseAac(stream);
+      switch (header.m_ProfileObjectType)
+      {
+        case 0:
+          frameInfo.m_codecProfile = AP4_AAC_PROFILE_MAIN;
+          break;
+        case 1:
+          frameInfo.m_codecProfile = AP4_AAC_PROFILE_LC;
+          break;
+        case 2:
+          frameInfo.m_codecProfile = AP4_AAC_PROFILE_SSR;
+          break;
+        case 3:
+          frameInfo.m_codecProfile = AP4_AAC_PROFILE_LTP;
+          break;
+      }
+      frameInfo.m_frameSize = header.m_FrameLength;
+      frameInfo.m_frameCount = 1024;
+      frameInfo.m_sampleRate = AP4_AdtsSamplingFrequencyTable[header.m_SamplingFrequencyIndex];
+      frameInfo.m_channels = header.m_ChannelConfiguration;
+      return true;
+    }
     case AdtsType::AC3:
-      return ParseAc3(stream);
+    {
+      AP4_Ac3Header header(data);
+      if (AP4_FAILED(header.Check()) || header.m_FrameSize == 0)
+        return false;
+
+      frameInfo.m_frameSize = header.m_FrameSize;
+      frameInfo.m_frameCount = 256u * header.m_ChannelCount;
+      frameInfo.m_sampleRate = FSCOD_AC3[header.m_Fscod];
+      frameInfo.m_channels = header.m_ChannelCount;
+      return true;
+    }
     case AdtsType::EAC3:
-      return ParseEc3(stream);
-    case AdtsType::AC4:
-      return false;
+    {
+      AP4_Eac3Header header(data);
+      if (AP4_FAILED(header.Check()) || header.m_FrameSize == 0)
+        return false;
+
+      frameInfo.m_frameSize = header.m_FrameSize;
+      frameInfo.m_frameCount = 256u * header.m_ChannelCount;
+      frameInfo.m_sampleRate = EAC3_SAMPLE_RATE_ARY[header.m_Fscod];
+      if (header.m_Addbsie && header.m_Addbsil == 1 && header.m_Addbsi[0] == 0x1)
+      {
+        // The channels value should match the value of the complexity_index_type_a field
+        frameInfo.m_channels = header.m_Addbsi[1];
+        frameInfo.m_codecFlags |= CODEC_FLAG_ATMOS;
+      }
+      else
+      {
+        frameInfo.m_channels = header.m_ChannelCount;
+        frameInfo.m_codecFlags &= ~CODEC_FLAG_ATMOS;
+      }
+      return true;
+    }
     default:
       return false;
   }
 }
 
-bool ADTSFrame::ParseAac(AP4_ByteStream* stream)
+void ADTSFrame::SetFrame(const ADTSFrameInfo& frameInfo, const uint8_t* data)
 {
-  if (!ParseAacHeader(stream, m_frameInfo))
-    return false;
-
+  m_frameInfo = frameInfo;
   m_summedFrameCount += m_frameInfo.m_frameCount;
-
-  // rewind stream to beginning of syncframe
-  AP4_Position currentPos;
-  stream->Tell(currentPos);
-  stream->Seek(currentPos - (AP4_ADTS_HEADER_SIZE));
-
-  m_dataBuffer.SetDataSize(m_frameInfo.m_frameSize);
-  if (!AP4_SUCCEEDED(stream->Read(m_dataBuffer.UseData(), m_dataBuffer.GetDataSize())))
-    return false;
-
-  AdjustStreamForPadding(stream);
-  return true;
-}
-
-bool ADTSFrame::ParseAacHeader(AP4_ByteStream* stream, ADTSFrameInfo& frameInfo)
-{
-  AP4_DataBuffer buffer;
-  buffer.SetDataSize(16);
-
-  if (!AP4_SUCCEEDED(stream->Read(buffer.UseData(), AP4_ADTS_HEADER_SIZE)))
-    return false;
-
-  CAdaptiveAdtsParser parser;
-  AP4_Size sz = buffer.GetDataSize();
-  parser.Feed(buffer.GetData(), &sz);
-
-  AP4_AacFrame frame;
-  AP4_Result result = parser.FindFrameHeader(frame);
-  if (!AP4_SUCCEEDED(result))
-    return false;
-
-  frameInfo.m_codecProfile = frame.m_Info.m_Profile;
-  frameInfo.m_frameSize = frame.m_Info.m_FrameLength + AP4_ADTS_HEADER_SIZE;
-  frameInfo.m_frameCount = 1024;
-  frameInfo.m_sampleRate = frame.m_Info.m_SamplingFrequency;
-  frameInfo.m_channels = frame.m_Info.m_ChannelConfiguration;
-  return true;
-}
-
-bool ADTSFrame::ParseAc3(AP4_ByteStream* stream)
-{
-  if (!ParseAc3Header(stream, m_frameInfo))
-    return false;
-
-  m_summedFrameCount += m_frameInfo.m_frameCount;
-
-  // rewind stream to beginning of syncframe
-  AP4_Position currentPos;
-  stream->Tell(currentPos);
-  stream->Seek(currentPos - (AP4_AC3_HEADER_SIZE));
-
-  m_dataBuffer.SetDataSize(m_frameInfo.m_frameSize);
-  if (!AP4_SUCCEEDED(stream->Read(m_dataBuffer.UseData(), m_dataBuffer.GetDataSize())))
-    return false;
-
-  AdjustStreamForPadding(stream);
-  return true;
-}
-
-bool ADTSFrame::ParseAc3Header(AP4_ByteStream* stream, ADTSFrameInfo& frameInfo)
-{
-  AP4_DataBuffer buffer;
-  buffer.SetDataSize(AP4_AC3_HEADER_SIZE);
-
-  if (!AP4_SUCCEEDED(stream->Read(buffer.UseData(), AP4_AC3_HEADER_SIZE)))
-    return false;
-
-  CAdaptiveAc3Parser parser;
-  AP4_Size sz = buffer.GetDataSize();
-  parser.Feed(buffer.GetData(), &sz);
-
-  AP4_Ac3Frame frame;
-  AP4_Result result = parser.FindFrameHeader(frame);
-  if (!AP4_SUCCEEDED(result))
-    return false;
-
-  frameInfo.m_frameSize = frame.m_Info.m_FrameSize;
-  frameInfo.m_frameCount = 256u * frame.m_Info.m_ChannelCount;
-  frameInfo.m_sampleRate = frame.m_Info.m_SampleRate;
-  frameInfo.m_channels = frame.m_Info.m_ChannelCount;
-  return true;
-}
-
-bool ADTSFrame::ParseEc3(AP4_ByteStream* stream)
-{
-  if (!ParseEc3Header(stream, m_frameInfo))
-    return false;
-
-  m_summedFrameCount += m_frameInfo.m_frameCount;
-
-  // rewind stream to beginning of syncframe
-  AP4_Position currentPos;
-  stream->Tell(currentPos);
-  stream->Seek(currentPos - (AP4_EAC3_HEADER_SIZE));
-
-  m_dataBuffer.SetDataSize(m_frameInfo.m_frameSize);
-  if (!AP4_SUCCEEDED(stream->Read(m_dataBuffer.UseData(), m_dataBuffer.GetDataSize())))
-    return false;
-
-  AdjustStreamForPadding(stream);
-  return true;
-}
-
-bool ADTSFrame::ParseEc3Header(AP4_ByteStream* stream, ADTSFrameInfo& frameInfo)
-{
-  AP4_DataBuffer buffer;
-  buffer.SetDataSize(AP4_EAC3_HEADER_SIZE);
-
-  if (!AP4_SUCCEEDED(stream->Read(buffer.UseData(), AP4_EAC3_HEADER_SIZE)))
-    return false;
-
-  CAdaptiveEac3Parser parser;
-  AP4_Size sz = buffer.GetDataSize();
-  parser.Feed(buffer.GetData(), &sz);
-
-  AP4_Eac3Frame frame;
-  AP4_Result result = parser.FindFrameHeader(frame);
-  if (!AP4_SUCCEEDED(result))
-    return false;
-
-  frameInfo.m_frameSize = frame.m_Info.m_FrameSize;
-  frameInfo.m_frameCount = 256u * frame.m_Info.m_ChannelCount;
-  frameInfo.m_sampleRate = frame.m_Info.m_SampleRate;
-  if (frame.m_Info.complexity_index_type_a > 0)
-  {
-    // The channels value should match the value of the complexity_index_type_a field
-    frameInfo.m_channels = frame.m_Info.complexity_index_type_a;
-    frameInfo.m_codecFlags |= CODEC_FLAG_ATMOS;
-  }
-  else
-  {
-    frameInfo.m_channels = frame.m_Info.m_ChannelCount;
-    frameInfo.m_codecFlags &= ~CODEC_FLAG_ATMOS;
-  }
-  return true;
+  m_data = data;
 }
 
 void ADTSFrame::reset()
 {
   m_summedFrameCount = 0;
   m_frameInfo.m_frameCount = 0;
-  m_dataBuffer.SetDataSize(0);
+  m_data = nullptr;
 }
 
 uint64_t ADTSFrame::getPtsOffset() const
@@ -336,8 +254,10 @@ uint64_t ADTSFrame::getDuration() const
 
 
 ADTSReader::ADTSReader(AP4_ByteStream *stream)
-  : m_stream(stream)
+  : m_stream(stream),
+    m_adByteStream(dynamic_cast<CAdaptiveByteStream*>(stream))
 {
+  m_window.resize(READ_WINDOW_SIZE);
 }
 
 ADTSReader::~ADTSReader()
@@ -348,16 +268,129 @@ void ADTSReader::Reset()
 {
   m_pts = ADTS_PTS_UNSET;
   m_frameParser.reset();
+  // The stream has been repositioned
+  m_windowPos = 0;
+  m_windowSize = 0;
+  m_isSegmentStart = true;
 }
 
-bool ADTSReader::GetInformation(kodi::addon::InputstreamInfo& info)
+bool ADTSReader::FillWindow(size_t minBytes)
+{
+  while (m_windowSize - m_windowPos < minBytes)
+  {
+    // Move the remaining data to the begin of the window
+    const size_t remaining = m_windowSize - m_windowPos;
+    if (m_windowPos > 0)
+    {
+      std::memmove(m_window.data(), m_window.data() + m_windowPos, remaining);
+      m_windowPos = 0;
+      m_windowSize = remaining;
+    }
+    if (m_window.size() < minBytes)
+      m_window.resize(minBytes);
+
+    uint8_t* readData = m_window.data() + m_windowSize;
+    const size_t readSize = m_window.size() - m_windowSize;
+    AP4_Size bytesRead{0};
+
+    if (m_adByteStream)
+    {
+      if (AP4_FAILED(m_adByteStream->ReadAvailable(readData,
+                                                   static_cast<AP4_Size>(minBytes - remaining),
+                                                   static_cast<AP4_Size>(readSize), bytesRead)))
+      {
+        return false;
+      }
+
+      // The data read is always from a single segment, when it is a new segment
+      // the incomplete data remaining from the previous one is discarded
+      std::string repId;
+      uint64_t segmentNumber{0};
+      uint64_t startPos{0};
+      if (m_adByteStream->GetCurrentSegmentInfo(repId, segmentNumber, startPos) &&
+          (repId != m_segmentRepId || segmentNumber != m_segmentNumber))
+      {
+        m_segmentRepId = repId;
+        m_segmentNumber = segmentNumber;
+        m_isSegmentStart = true;
+        std::memmove(m_window.data(), readData, bytesRead);
+        m_windowSize = 0;
+      }
+    }
+    else if (AP4_FAILED(m_stream->ReadPartial(readData, static_cast<AP4_Size>(readSize),
+                                              bytesRead)) ||
+             bytesRead == 0)
+    {
+      return false;
+    }
+    m_windowSize += bytesRead;
+  }
+  return true;
+}
+
+bool ADTSReader::FindNextFrame(ADTSFrame::ADTSFrameInfo& frameInfo)
 {
-  m_id3TagParser.SkipID3Data(m_stream);
-  ADTSFrame::ADTSFrameInfo frameInfo = m_frameParser.GetFrameInfo(m_stream);
+  frameInfo = m_frameParser.GetFrameInfo();
+
+  while (FillWindow(ID3TAG::HEADER_SIZE))
+  {
+    const uint8_t* data = m_window.data() + m_windowPos;
+    const size_t size = m_windowSize - m_windowPos;
+
+    // ID3 tags are expected at segment start, elsewhere they are checked only
+    // when the data is not a frame, so the sync words are not searched in the tag data
+    size_t tagSize{0};
+    if (m_isSegmentStart ||
+        CAdaptiveAdtsHeaderParser::GetAdtsType(data, size) == AdtsType::NONE)
+    {
+      tagSize = ID3TAG::getTagSize(data, size);
+    }
+    m_isSegmentStart = false;
 
-  m_stream->Seek(0); // Seek back because data has been consumed
+    if (tagSize > 0)
+    {
+      if (!FillWindow(tagSize))
+        return false;
+      // Tag incomplete at the end of the segment, restart from the new segment
+      if (m_isSegmentStart)
+        continue;
+      if (m_id3TagParser.parse(m_window.data() + m_windowPos, tagSize) == ID3TAG::PARSE_FAIL)
+        return false;
+      m_windowPos += tagSize;
+      continue;
+    }
+
+    size_t offset{0};
+    const ADTSFrame::FINDCODE findCode = ADTSFrame::FindFrame(data, size, offset, frameInfo);
+    if (findCode == ADTSFrame::FINDCODE::UNSUPPORTED)
+      return false;
+
+    // Discard the data before the frame
+    m_windowPos += offset;
+
+    if (findCode == ADTSFrame::FINDCODE::FOUND)
+    {
+      if (!FillWindow(frameInfo.m_frameSize))
+        return false;
+      // Frame incomplete at the end of the segment, restart from the new segment
+      if (!m_isSegmentStart)
+        return true;
+      continue;
+    }
+
+    // More data is needed to find the frame
+    if (!FillWindow(size - offset + 1))
+      return false;
+  }
+  return false;
+}
+
+bool ADTSReader::GetInformation(kodi::addon::InputstreamInfo& info)
+{
+  ADTSFrame::ADTSFrameInfo frameInfo = m_frameParser.GetFrameInfo();
 
-  if (frameInfo.m_codecType == AdtsType::NONE)
+  // No frame read yet, get the info from the next frame without consume it
+  if (frameInfo.m_codecType == AdtsType::NONE && !FindNextFrame(frameInfo))
     return false;
 
   std::string codecName;
@@ -423,20 +456,17 @@ bool ADTSReader::SeekTime(uint64_t timeInTs, bool preceeding)
 
 bool ADTSReader::ReadPacket()
 {
-  ID3TAG::PARSECODE id3Ret;
-  while (true)
-  {
-    if ((id3Ret = m_id3TagParser.parse(m_stream)) == ID3TAG::PARSE_SUCCESS)
-      continue;
-    else if (id3Ret == ID3TAG::PARSE_FAIL)
-      return false;
+  ADTSFrame::ADTSFrameInfo frameInfo;
+  if (!FindNextFrame(frameInfo))
+    return false;
 
-    if (m_id3TagParser.getPts(m_basePts))
-      m_frameParser.resetFrameCount();
+  if (m_id3TagParser.getPts(m_basePts))
+    m_frameParser.resetFrameCount();
 
-    m_pts = m_basePts + m_frameParser.getPtsOffset();
+  m_pts = m_basePts + m_frameParser.getPtsOffset();
 
-    return m_frameParser.parse(m_stream);
-  }
+  // The frame data remains valid in the read window until the next read
+  m_frameParser.SetFrame(frameInfo, m_window.data() + m_windowPos);
+  m_windowPos += frameInfo.m_frameSize;
   return true;
 }
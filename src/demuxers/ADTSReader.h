@@ -9,12 +9,14 @@
 #pragma once
 
 #include <stdint.h>
+#include <string>
+#include <vector>
 #include <bento4/Ap4Types.h>
-#include <bento4/Ap4DataBuffer.h>
 #include <kodi/addon-instance/Inputstream.h>
 
 // Forwards
 class AP4_ByteStream;
+class CAdaptiveByteStream;
 
 namespace adaptive
 {
@@ -32,19 +34,32 @@ public:
     PARSE_NO_ID3
   };
 
-  PARSECODE parse(AP4_ByteStream* stream);
-  void SkipID3Data(AP4_ByteStream* stream);
+  /*!
+   * \brief Get the full size of the ID3v2 tag at the begin of the data.
+   * \param data The data
+   * \param size The data size, at least HEADER_SIZE bytes are needed
+   * \return The tag size, or 0 if there is no ID3 tag
+   */
+  static size_t getTagSize(const uint8_t* data, size_t size);
+
+  /*!
+   * \brief Parse the ID3v2 tag to search the HLS timestamp.
+   * \param data The data, must contain the full tag (see getTagSize)
+   * \param size The data size
+   * \return The parse result
+   */
+  PARSECODE parse(const uint8_t* data, size_t size);
   bool getPts(uint64_t &pts) { if (m_timestamp) { pts = m_timestamp; m_timestamp = 0; return true; } return false; }
 
+  static const unsigned int HEADER_SIZE = 10;
+
 private:
   static uint64_t getSize(const uint8_t *data, unsigned int size, unsigned int shift);
 
-  static const unsigned int HEADER_SIZE = 10;
-
   uint8_t m_majorVer;
   uint8_t m_revisionVer;
   uint8_t m_flags;
-  uint64_t m_timestamp;
+  uint64_t m_timestamp{0};
 };
 
 
@@ -69,30 +84,53 @@ public:
     uint32_t m_channels{0};
   };
 
+  enum class FINDCODE
+  {
+    FOUND, // Frame header found and parsed
+    NEED_DATA, // More data is needed to identify or parse a frame header
+    UNSUPPORTED // Frame of a codec type not supported
+  };
+
   /*!
-   * \brief Adjust the stream position to advance over padding if neccessary (end of file)
-   * \param stream The stream to check
+   * \brief Find the next frame in the data, by scanning for a sync word and
+   *        parsing the header fields directly from the data.
+   * \param data The data
+   * \param size The data size
+   * \param offset [OUT] The frame position, with NEED_DATA the data before it can be discarded
+   * \param frameInfo [OUT] The frame info, when found
+   * \return The find result
    */
-  void AdjustStreamForPadding(AP4_ByteStream* stream);
-  ADTSFrameInfo GetFrameInfo(AP4_ByteStream* stream);
-  bool parse(AP4_ByteStream *stream);
-  bool ParseAac(AP4_ByteStream* stream);
-  bool ParseAacHeader(AP4_ByteStream* stream, ADTSFrameInfo& frameInfo);
-  bool ParseAc3(AP4_ByteStream* stream);
-  bool ParseAc3Header(AP4_ByteStream* stream, ADTSFrameInfo& frameInfo);
-  bool ParseEc3(AP4_ByteStream* stream);
-  bool ParseEc3Header(AP4_ByteStream* stream, ADTSFrameInfo& frameInfo);
+  static FINDCODE FindFrame(const uint8_t* data,
+                            size_t size,
+                            size_t& offset,
+                            ADTSFrameInfo& frameInfo);
+
+  /*!
+   * \brief Parse the frame header fields.
+   * \param data The frame data, must have the header size of the frame type
+   * \param frameInfo [IN/OUT] The frame info, the codec type must be set
+   * \return True if the header is valid, otherwise false
+   */
+  static bool ParseHeader(const uint8_t* data, ADTSFrameInfo& frameInfo);
+
+  /*!
+   * \brief Set the frame read, the frame data must remain valid until the next frame
+   * \param frameInfo The frame info
+   * \param data The frame data, of frameInfo.m_frameSize bytes
+   */
+  void SetFrame(const ADTSFrameInfo& frameInfo, const uint8_t* data);
+  const ADTSFrameInfo& GetFrameInfo() const { return m_frameInfo; }
   void reset();
   void resetFrameCount() { m_summedFrameCount = 0; }
   uint64_t getPtsOffset() const;
   uint64_t getDuration() const;
-  const AP4_Byte *getData() const { return m_dataBuffer.GetData(); }
-  AP4_Size getDataSize() const { return m_dataBuffer.GetDataSize(); }
+  const AP4_Byte* getData() const { return m_data; }
+  AP4_Size getDataSize() const { return m_data ? m_frameInfo.m_frameSize : 0; }
 
 private:
   uint64_t m_summedFrameCount{0};
   ADTSFrameInfo m_frameInfo;
-  AP4_DataBuffer m_dataBuffer;
+  const AP4_Byte* m_data{nullptr};
 };
 
 class ATTR_DLL_LOCAL ADTSReader
@@ -115,7 +153,35 @@ public:
   static const uint64_t ADTS_PTS_UNSET = 0x1ffffffffULL;
 
 private:
+  /*!
+   * \brief Make sure that the read window contains the specified amount of data
+   *        from the read position, by reading more data from the stream.
+   * \param minBytes The bytes needed
+   * \return True if success, otherwise false
+   */
+  bool FillWindow(size_t minBytes);
+
+  /*!
+   * \brief Move the read position to the next frame, and make sure that its data
+   *        is fully contained in the read window. ID3 tags are parsed at segment start.
+   * \param frameInfo [OUT] The frame info
+   * \return True if success, otherwise false
+   */
+  bool FindNextFrame(ADTSFrame::ADTSFrameInfo& frameInfo);
+
   AP4_ByteStream *m_stream;
+  CAdaptiveByteStream* m_adByteStream;
+
+  // Window of the stream data read in bulk, where the frames are parsed from,
+  // since a frame never span over two segments the data of a segment are never mixed
+  std::vector<uint8_t> m_window;
+  size_t m_windowPos{0}; // The read position
+  size_t m_windowSize{0};
+  // True when the read position is at the start of a segment, where an ID3 tag can be
+  bool m_isSegmentStart{true};
+  std::string m_segmentRepId;
+  uint64_t m_segmentNumber{0};
+
   ID3TAG m_id3TagParser;
   ADTSFrame m_frameParser;
   uint64_t m_basePts{0};
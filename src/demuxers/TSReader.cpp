@@ -8,11 +8,13 @@
 
 #include "TSReader.h"
 
+#include "AdaptiveByteStream.h"
 #include "mpegts/ES_AAC.h"
 #include "mpegts/debug.h"
 #include "utils/Utils.h"
 #include "utils/log.h"
 
+#include <cstring>
 #include <stdlib.h>
 
 #include <bento4/Ap4ByteStream.h>
@@ -21,6 +23,11 @@ using namespace UTILS;
 
 namespace
 {
+// Size of the data read in bulk from the stream, as multiple of the common TS packet size
+constexpr size_t READ_WINDOW_SIZE = 348 * FLUTS_NORMAL_TS_PACKETSIZE; // ~64KB
+// Maximum number of segment indexes kept for seek operations
+constexpr size_t MAX_SEGMENT_INDEXES = 16;
+
 void DebugLog(int level, char* msg)
 {
   if (msg[std::strlen(msg) - 1] == '\n')
@@ -49,8 +56,14 @@ void DebugLog(int level, char* msg)
 } // unnamed namespace
 
 TSReader::TSReader(AP4_ByteStream* stream, uint32_t requiredMask)
-  : m_stream(stream), m_requiredMask(requiredMask), m_typeMask(0)
+  : m_stream(stream),
+    m_adByteStream(dynamic_cast<CAdaptiveByteStream*>(stream)),
+    m_requiredMask(requiredMask),
+    m_typeMask(0)
 {
+  if (m_adByteStream)
+    m_readBuffer.resize(READ_WINDOW_SIZE);
+
   // Uncomment to debug TSDemux library
   // TSDemux::DBGAll();
   // TSDemux::SetDBGMsgCallback(DebugLog);
@@ -77,14 +90,43 @@ TSReader::~TSReader()
 
 bool TSReader::ReadAV(uint64_t pos, unsigned char * data, size_t len)
 {
-  m_stream->Seek(pos);
-  return AP4_SUCCEEDED(m_stream->Read(data, static_cast<AP4_Size>(len)));
+  if (!m_adByteStream || len > m_readBuffer.size())
+  {
+    m_stream->Seek(pos);
+    return AP4_SUCCEEDED(m_stream->Read(data, static_cast<AP4_Size>(len)));
+  }
+
+  // Read the stream only when the requested data is outside the window,
+  // this also allows TSResync and GoPosition to move freely inside the window
+  if (pos < m_readBufferPos || pos + len > m_readBufferPos + m_readBufferSize)
+  {
+    m_readBufferSize = 0;
+    m_adByteStream->Seek(pos);
+
+    AP4_Size bytesRead{0};
+    if (AP4_FAILED(m_adByteStream->ReadAvailable(m_readBuffer.data(), static_cast<AP4_Size>(len),
+                                                 static_cast<AP4_Size>(m_readBuffer.size()),
+                                                 bytesRead)))
+    {
+      return false;
+    }
+    m_readBufferPos = pos;
+    m_readBufferSize = bytesRead;
+  }
+
+  std::memcpy(data, m_readBuffer.data() + (pos - m_readBufferPos), len);
+  return true;
 }
 
 void TSReader::Reset(bool resetPackets)
 {
+  // The stream has been repositioned, the data of the window could be no longer valid
+  m_readBufferSize = 0;
   m_stream->Tell(m_startPos);
   m_AVContext->GoPosition(m_startPos, resetPackets);
+  // Without the packets reset the demuxing continues on the next segment
+  if (resetPackets)
+    StopIndexing();
   //mark invalid for Seek operations
   m_pkt.pts = PTS_UNSET;
 }
@@ -208,16 +250,45 @@ bool TSReader::GetInformation(kodi::addon::InputstreamInfo& info)
 // We assume that m_startpos is the current I-Frame position
 bool TSReader::SeekTime(uint64_t timeInTs, bool preceeding)
 {
-  bool hasVideo(false);
-  //look if we have video
-  for (auto &tsInfo : m_streamInfos)
-    if (tsInfo.m_enabled && tsInfo.m_streamType == INPUTSTREAM_TYPE_VIDEO)
+  const bool hasVideo{HasVideo()};
+  uint64_t lastRecovery(static_cast<uint64_t>(m_startPos));
+
+  // The random access points indexed while the segment has been read allow to go straight to
+  // the nearest recovery point, or to resume demuxing from the last one indexed
+  std::string repId;
+  uint64_t segNumber{0};
+  uint64_t segStartPos{0};
+
+  if (m_adByteStream && m_adByteStream->GetCurrentSegmentInfo(repId, segNumber, segStartPos))
+  {
+    SegmentIndex* segIndex{FindSegmentIndex(repId, segNumber, hasVideo)};
+
+    uint64_t offset{0};
+    if (segIndex && FindRecoveryPoint(*segIndex, timeInTs, preceeding, offset))
     {
-      hasVideo = true;
-      break;
+      LOG::Log(LOGDEBUG, "TS seek: found recovery point at offset %llu of segment %llu", offset,
+               segNumber);
+      StopIndexing();
+      m_AVContext->GoPosition(segStartPos + offset, true);
+      return true;
     }
 
-  uint64_t lastRecovery(static_cast<uint64_t>(m_startPos));
+    // An index that is being filled is already demuxed up to the current position
+    if (segIndex && segIndex != m_fillIndex && !segIndex->m_isComplete &&
+        !segIndex->m_points.empty())
+    {
+      lastRecovery = segStartPos + segIndex->m_points.back().m_offset;
+      m_AVContext->GoPosition(lastRecovery, true);
+      m_pkt.pts = PTS_UNSET;
+      // The demuxing continues from an indexed point, so the index can be filled
+      m_fillIndex = segIndex;
+      m_fillStartPos = segStartPos;
+      m_readRepId = repId;
+      m_readSegmentNumber = segNumber;
+      m_isReadContinuous = true;
+    }
+  }
+
   while (m_pkt.pts == PTS_UNSET || !preceeding || static_cast<uint64_t>(m_pkt.pts) < timeInTs)
   {
     uint64_t thisFrameStart(m_AVContext->GetRecoveryPos());
@@ -232,18 +303,185 @@ bool TSReader::SeekTime(uint64_t timeInTs, bool preceeding)
   }
   m_AVContext->GoPosition(lastRecovery, true);
 
+  // Demuxing again the indexed frames does not change the index, unless the recovery point
+  // is in a previous segment
+  if (m_fillIndex && lastRecovery < m_fillStartPos)
+    StopIndexing();
+
   return true;
 }
 
+bool TSReader::FindRecoveryPoint(const SegmentIndex& index,
+                                 uint64_t pts,
+                                 bool preceeding,
+                                 uint64_t& offset) const
+{
+  if (index.m_points.empty())
+    return false;
+
+  if (preceeding)
+  {
+    // The nearest preceding point is known only when the PTS has been reached
+    if (!index.m_isComplete && index.m_maxPts < pts)
+      return false;
+
+    offset = index.m_points.front().m_offset;
+    for (const auto& point : index.m_points)
+    {
+      if (point.m_pts <= pts)
+        offset = point.m_offset;
+    }
+    return true;
+  }
+
+  // Points are in stream order, the first one that follows the PTS is the nearest
+  for (const auto& point : index.m_points)
+  {
+    if (point.m_pts >= pts)
+    {
+      offset = point.m_offset;
+      return true;
+    }
+  }
+  return false;
+}
+
+TSReader::SegmentIndex* TSReader::FindSegmentIndex(const std::string& repId,
+                                                   uint64_t segmentNumber,
+                                                   bool hasVideo)
+{
+  for (auto it = m_segmentIndexes.begin(); it != m_segmentIndexes.end(); ++it)
+  {
+    if (it->m_repId == repId && it->m_segmentNumber == segmentNumber)
+    {
+      if (it->m_hasVideo == hasVideo)
+        return &(*it);
+
+      // The recovery points depend on the enabled streams
+      if (m_fillIndex == &(*it))
+        m_fillIndex = nullptr;
+      m_segmentIndexes.erase(it);
+      break;
+    }
+  }
+  return nullptr;
+}
+
+void TSReader::StartIndexing(const std::string& repId,
+                             uint64_t segmentNumber,
+                             uint64_t segmentStartPos,
+                             bool hasVideo)
+{
+  SegmentIndex* index{FindSegmentIndex(repId, segmentNumber, hasVideo)};
+  if (index && index->m_isComplete)
+    return;
+
+  if (index)
+  {
+    index->m_points.clear();
+    index->m_maxPts = 0;
+  }
+  else
+  {
+    if (m_segmentIndexes.size() >= MAX_SEGMENT_INDEXES)
+      m_segmentIndexes.pop_front();
+
+    index = &m_segmentIndexes.emplace_back();
+    index->m_repId = repId;
+    index->m_segmentNumber = segmentNumber;
+    index->m_hasVideo = hasVideo;
+  }
+  m_fillIndex = index;
+  m_fillStartPos = segmentStartPos;
+}
+
+void TSReader::StopIndexing()
+{
+  m_fillIndex = nullptr;
+  m_isReadContinuous = false;
+}
+
+void TSReader::IndexPacket(uint64_t frameStart)
+{
+  std::string repId;
+  uint64_t segNumber{0};
+  uint64_t segStartPos{0};
+
+  if (!m_adByteStream || !m_adByteStream->GetCurrentSegmentInfo(repId, segNumber, segStartPos))
+  {
+    StopIndexing();
+    return;
+  }
+
+  const bool hasVideo{HasVideo()};
+  const bool isSegmentChanged{repId != m_readRepId || segNumber != m_readSegmentNumber};
+
+  // A frame that begins in the indexed segment can be output after the next segment is read
+  if (m_fillIndex && frameStart >= m_fillStartPos &&
+      (!isSegmentChanged || frameStart < segStartPos))
+  {
+    AddRecoveryPoint(*m_fillIndex, frameStart - m_fillStartPos, hasVideo);
+  }
+
+  if (isSegmentChanged)
+  {
+    if (m_fillIndex)
+      m_fillIndex->m_isComplete = true;
+    m_fillIndex = nullptr;
+    m_readRepId = repId;
+    m_readSegmentNumber = segNumber;
+
+    // The segment can be indexed only when it is demuxed from its start
+    if (m_isReadContinuous || static_cast<uint64_t>(m_startPos) == segStartPos)
+    {
+      StartIndexing(repId, segNumber, segStartPos, hasVideo);
+      if (m_fillIndex && frameStart >= segStartPos)
+        AddRecoveryPoint(*m_fillIndex, frameStart - segStartPos, hasVideo);
+    }
+  }
+  m_isReadContinuous = true;
+}
+
+void TSReader::AddRecoveryPoint(SegmentIndex& index, uint64_t offset, bool hasVideo)
+{
+  if (m_pkt.pts == PTS_UNSET)
+    return;
+
+  const uint64_t pts{static_cast<uint64_t>(m_pkt.pts)};
+  if ((!hasVideo || m_pkt.recoveryPoint || offset == 0) &&
+      (index.m_points.empty() || offset > index.m_points.back().m_offset))
+  {
+    index.m_points.push_back({pts, offset});
+  }
+  if (pts > index.m_maxPts)
+    index.m_maxPts = pts;
+}
+
+bool TSReader::HasVideo() const
+{
+  for (const auto& tsInfo : m_streamInfos)
+  {
+    if (tsInfo.m_enabled && tsInfo.m_streamType == INPUTSTREAM_TYPE_VIDEO)
+      return true;
+  }
+  return false;
+}
+
 bool TSReader::ReadPacket(bool scanStreamInfo)
 {
   if (!m_AVContext)
     return false;
 
   bool ret(false);
+  // Where the frame of the next packet begins
+  const uint64_t frameStart{m_AVContext->GetRecoveryPos()};
 
   if (GetPacket())
+  {
+    if (!scanStreamInfo)
+      IndexPacket(frameStart);
     return true;
+  }
 
   while (!ret)
   {
@@ -278,6 +516,7 @@ bool TSReader::ReadPacket(bool scanStreamInfo)
       {
         if (m_pkt.streamChange)
           HandleStreamChange(m_pkt.pid);
+        IndexPacket(frameStart);
         return true;
       }
     }
@@ -10,13 +10,16 @@
 
 #include "mpegts/tsDemuxer.h"
 
+#include <list>
 #include <stdint.h>
+#include <string>
 #include <vector>
 
 #include <bento4/Ap4Types.h>
 #include <kodi/addon-instance/Inputstream.h>
 
 class AP4_ByteStream;
+class CAdaptiveByteStream;
 
 class ATTR_DLL_LOCAL TSReader : public TSDemux::TSDemuxer
 {
@@ -47,9 +50,91 @@ private:
   bool HandleProgramChange();
   bool HandleStreamChange(uint16_t pid);
 
+  // Random access points of a segment, collected while its data is demuxed
+  struct SegmentIndex
+  {
+    struct RecoveryPoint
+    {
+      uint64_t m_pts;
+      uint64_t m_offset; // Position relative to the segment start
+    };
+
+    std::string m_repId;
+    uint64_t m_segmentNumber{0};
+    bool m_hasVideo{false};
+    std::vector<RecoveryPoint> m_points;
+    uint64_t m_maxPts{0}; // The highest PTS demuxed from the segment start
+    bool m_isComplete{false}; // All the segment data has been demuxed
+  };
+
+  /*!
+   * \brief Find the recovery point where to start demuxing to reach the specified PTS.
+   * \param index The segment index
+   * \param pts The PTS to reach
+   * \param preceeding If true the recovery point must precede the PTS, otherwise follow it
+   * \param offset [OUT] The recovery point position relative to the segment start
+   * \return True if the index covers the PTS and a recovery point is found, otherwise false
+   */
+  bool FindRecoveryPoint(const SegmentIndex& index,
+                         uint64_t pts,
+                         bool preceeding,
+                         uint64_t& offset) const;
+
+  /*!
+   * \brief Get the index of a segment.
+   * \param repId The representation id
+   * \param segmentNumber The segment number
+   * \param hasVideo If the enabled streams include a video stream
+   * \return The index if found, otherwise nullptr. An index created
+   *         with other enabled streams is deleted.
+   */
+  SegmentIndex* FindSegmentIndex(const std::string& repId, uint64_t segmentNumber, bool hasVideo);
+
+  /*!
+   * \brief Begin to fill the index of the segment being demuxed from its start,
+   *        the index is not filled again when it is already complete.
+   */
+  void StartIndexing(const std::string& repId,
+                     uint64_t segmentNumber,
+                     uint64_t segmentStartPos,
+                     bool hasVideo);
+
+  // Stop filling the segment index, when the demuxing jumps to another position
+  void StopIndexing();
+
+  /*!
+   * \brief Add the packet just read to the index of the segment being demuxed.
+   * \param frameStart The stream position where the packet frame begins
+   */
+  void IndexPacket(uint64_t frameStart);
+
+  // Add the packet just read as recovery point, when its frame is one
+  void AddRecoveryPoint(SegmentIndex& index, uint64_t offset, bool hasVideo);
+
+  bool HasVideo() const;
+
   TSDemux::AVContext* m_AVContext;
 
   AP4_ByteStream *m_stream;
+  CAdaptiveByteStream* m_adByteStream;
+
+  // Window of the stream data read in bulk, where the TS packets are read from,
+  // to avoid a seek and read on the stream for each TS packet
+  std::vector<uint8_t> m_readBuffer;
+  uint64_t m_readBufferPos{0};
+  size_t m_readBufferSize{0};
+
+  // Indexes of the last segments read, the oldest is at front
+  std::list<SegmentIndex> m_segmentIndexes;
+  // The index filled while its segment is demuxed, nullptr when the demuxing did not
+  // begin at the segment start
+  SegmentIndex* m_fillIndex{nullptr};
+  uint64_t m_fillStartPos{0}; // The stream position where the segment of m_fillIndex begins
+  // The segment of the last packet read
+  std::string m_readRepId;
+  uint64_t m_readSegmentNumber{0};
+  // The packets are demuxed without jumps since the last packet read
+  bool m_isReadContinuous{false};
 
   TSDemux::STREAM_PKT m_pkt;
   AP4_Position m_startPos;
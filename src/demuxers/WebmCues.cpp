@@ -0,0 +1,192 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "WebmCues.h"
+
+namespace
+{
+// EBML element ID's, with the length marker bits included
+constexpr uint32_t ID_SEGMENT = 0x18538067;
+constexpr uint32_t ID_CUES = 0x1C53BB6B;
+constexpr uint32_t ID_CUE_POINT = 0xBB;
+constexpr uint32_t ID_CUE_TIME = 0xB3;
+constexpr uint32_t ID_CUE_TRACK_POSITIONS = 0xB7;
+constexpr uint32_t ID_CUE_CLUSTER_POSITION = 0xF1;
+
+constexpr uint64_t UNKNOWN_SIZE = ~0ULL;
+
+struct ElementHeader
+{
+  uint32_t id{0};
+  uint64_t size{0}; // Body size, or UNKNOWN_SIZE
+  size_t bodyPos{0};
+};
+
+// Get the length of a variable size integer from its first byte, 0 if invalid
+size_t GetVintLength(uint8_t firstByte, size_t maxLength)
+{
+  for (size_t length = 1; length <= maxLength; ++length)
+  {
+    if (firstByte & (0x80 >> (length - 1)))
+      return length;
+  }
+  return 0;
+}
+
+bool ReadElementHeader(const uint8_t* data, size_t pos, size_t end, ElementHeader& header)
+{
+  if (pos >= end)
+    return false;
+
+  const size_t idLength = GetVintLength(data[pos], 4);
+  if (idLength == 0 || pos + idLength > end)
+    return false;
+
+  header.id = 0;
+  for (size_t i = 0; i < idLength; ++i)
+    header.id = (header.id << 8) | data[pos + i];
+  pos += idLength;
+
+  if (pos >= end)
+    return false;
+
+  const size_t sizeLength = GetVintLength(data[pos], 8);
+  if (sizeLength == 0 || pos + sizeLength > end)
+    return false;
+
+  // Remove the length marker, a value with all bits set means unknown size
+  uint64_t size = data[pos] & (0xFF >> sizeLength);
+  bool isUnknown = size == (0xFFU >> sizeLength);
+  for (size_t i = 1; i < sizeLength; ++i)
+  {
+    size = (size << 8) | data[pos + i];
+    isUnknown = isUnknown && data[pos + i] == 0xFF;
+  }
+  header.size = isUnknown ? UNKNOWN_SIZE : size;
+  header.bodyPos = pos + sizeLength;
+  return true;
+}
+
+// Get the end position of the element body, or 0 if it exceeds the data
+size_t GetBodyEnd(const ElementHeader& header, size_t end)
+{
+  if (header.size == UNKNOWN_SIZE || header.size > end - header.bodyPos)
+    return 0;
+  return header.bodyPos + static_cast<size_t>(header.size);
+}
+
+uint64_t ReadUnsigned(const uint8_t* data, size_t pos, size_t end)
+{
+  uint64_t value{0};
+  for (; pos < end; ++pos)
+    value = (value << 8) | data[pos];
+  return value;
+}
+
+// Parse a CuePoint body, only the cluster position of the first track is used
+bool ParseCuePoint(const uint8_t* data, size_t pos, size_t end, WEBM::CuePoint& cue)
+{
+  bool hasTime{false};
+  bool hasTrackPositions{false};
+  ElementHeader header;
+
+  while (ReadElementHeader(data, pos, end, header))
+  {
+    const size_t bodyEnd = GetBodyEnd(header, end);
+    if (bodyEnd == 0)
+      return false;
+
+    if (header.id == ID_CUE_TIME)
+    {
+      cue.pts = ReadUnsigned(data, header.bodyPos, bodyEnd);
+      hasTime = true;
+    }
+    else if (header.id == ID_CUE_TRACK_POSITIONS && !hasTrackPositions)
+    {
+      cue.pos_start = 0;
+      ElementHeader posHeader;
+      size_t posPos = header.bodyPos;
+      while (ReadElementHeader(data, posPos, bodyEnd, posHeader))
+      {
+        const size_t posBodyEnd = GetBodyEnd(posHeader, bodyEnd);
+        if (posBodyEnd == 0)
+          break;
+        if (posHeader.id == ID_CUE_CLUSTER_POSITION)
+          cue.pos_start = ReadUnsigned(data, posHeader.bodyPos, posBodyEnd);
+        posPos = posBodyEnd;
+      }
+      hasTrackPositions = true;
+    }
+    pos = bodyEnd;
+  }
+  return hasTime && hasTrackPositions;
+}
+} // unnamed namespace
+
+bool WEBM::ParseCuePoints(const uint8_t* data, size_t size, std::vector<CuePoint>& cuePoints)
+{
+  size_t pos{0};
+  size_t end{size};
+  bool isCuesFound{false};
+  ElementHeader header;
+
+  // Find the Cues element, by entering in the Segment and skipping all other elements
+  while (ReadElementHeader(data, pos, end, header))
+  {
+    if (header.id == ID_SEGMENT)
+    {
+      const size_t bodyEnd = GetBodyEnd(header, end);
+      if (bodyEnd != 0)
+        end = bodyEnd;
+      pos = header.bodyPos;
+    }
+    else if (header.id == ID_CUES)
+    {
+      isCuesFound = true;
+      break;
+    }
+    else
+    {
+      const size_t bodyEnd = GetBodyEnd(header, end);
+      if (bodyEnd == 0)
+        return false;
+      pos = bodyEnd;
+    }
+  }
+  if (!isCuesFound)
+    return false;
+
+  // A truncated Cues element is parsed up to the last complete CuePoint
+  const size_t cuesEnd = GetBodyEnd(header, end);
+  end = cuesEnd != 0 ? cuesEnd : end;
+  pos = header.bodyPos;
+
+  while (ReadElementHeader(data, pos, end, header))
+  {
+    const size_t bodyEnd = GetBodyEnd(header, end);
+    if (bodyEnd == 0)
+      break;
+
+    CuePoint cue;
+    if (header.id == ID_CUE_POINT && ParseCuePoint(data, header.bodyPos, bodyEnd, cue))
+    {
+      cue.duration = 0;
+      cue.pos_end = ~0ULL;
+
+      if (!cuePoints.empty())
+      {
+        CuePoint& backCue = cuePoints.back();
+        backCue.duration = cue.pts - backCue.pts;
+        backCue.pos_end = cue.pos_start - 1;
+      }
+      cuePoints.emplace_back(cue);
+    }
+    pos = bodyEnd;
+  }
+  return !cuePoints.empty();
+}
@@ -0,0 +1,39 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace WEBM
+{
+
+struct CuePoint
+{
+  uint64_t pts;
+  uint64_t duration;
+  uint64_t pos_start;
+  uint64_t pos_end;
+};
+
+/*!
+ * \brief Parse the cue points from the data of a WebM index range, by scanning
+ *        the EBML elements for the "Cues" element only, all other elements are skipped.
+ *        The data can start with the "Cues" element or from the begin of the file.
+ *        The cluster positions are relative to the Segment body start,
+ *        the last cue point has no duration and an open end position (~0ULL).
+ * \param data The index range data
+ * \param size The data size
+ * \param cuePoints [OUT] The cue points
+ * \return True if at least one cue point has been found, otherwise false
+ */
+bool ParseCuePoints(const uint8_t* data, size_t size, std::vector<CuePoint>& cuePoints);
+
+} // namespace WEBM
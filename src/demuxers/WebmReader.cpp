@@ -11,12 +11,20 @@
 #include "utils/StringUtils.h"
 #include "utils/Utils.h"
 
+#include <algorithm>
+
 #include <bento4/Ap4ByteStream.h>
 #include <webm/reader.h>
 #include <webm/webm_parser.h>
 
 using namespace UTILS;
 
+namespace
+{
+// Size of the chunks read to skip data that cannot be skipped by seeking
+constexpr size_t SKIP_READ_SIZE = 4096;
+} // unnamed namespace
+
 class ATTR_DLL_LOCAL WebmAP4Reader : public webm::Reader
 {
 public:
@@ -52,12 +60,38 @@ public:
   webm::Status Skip(std::uint64_t num_to_skip,
     std::uint64_t* num_actually_skipped) override
   {
+    *num_actually_skipped = 0;
     AP4_Position pos;
-    if (AP4_FAILED(m_stream->Tell(pos) || m_stream->Seek(pos + num_to_skip)))
+    if (AP4_FAILED(m_stream->Tell(pos)))
       return webm::Status(webm::Status::kEndOfFile);
 
-    *num_actually_skipped = num_to_skip;
-    return webm::Status(webm::Status::kOkCompleted);
+    if (AP4_SUCCEEDED(m_stream->Seek(pos + num_to_skip)))
+    {
+      *num_actually_skipped = num_to_skip;
+      return webm::Status(webm::Status::kOkCompleted);
+    }
+
+    // The adaptive stream seeks only inside the current segment,
+    // a block that continues in the next segment is skipped by reading it
+    if (AP4_FAILED(m_stream->Seek(pos)))
+      return webm::Status(webm::Status::kEndOfFile);
+
+    std::uint8_t buffer[SKIP_READ_SIZE];
+    while (*num_actually_skipped < num_to_skip)
+    {
+      const AP4_Size num_to_read = static_cast<AP4_Size>(
+          std::min<std::uint64_t>(num_to_skip - *num_actually_skipped, SKIP_READ_SIZE));
+      AP4_Size num_read{0};
+      if (AP4_FAILED(m_stream->ReadPartial(buffer, num_to_read, num_read)) || num_read == 0)
+        break;
+      *num_actually_skipped += num_read;
+    }
+
+    if (*num_actually_skipped == num_to_skip)
+      return webm::Status(webm::Status::kOkCompleted);
+    else if (*num_actually_skipped > 0)
+      return webm::Status(webm::Status::kOkPartial);
+    return webm::Status(webm::Status::kEndOfFile);
   }
 
   std::uint64_t Position() const override
@@ -80,13 +114,6 @@ WebmReader::WebmReader(AP4_ByteStream *stream)
 {
 }
 
-void WebmReader::GetCuePoints(std::vector<CUEPOINT> &cuepoints)
-{
-  m_cuePoints = &cuepoints;
-  m_reader->Reset();
-  m_reader->Run(this);
-}
-
 bool WebmReader::Initialize()
 {
   webm::Status status = m_reader->Run(this);
@@ -199,10 +226,6 @@ webm::Status WebmReader::OnSegmentBegin(const webm::ElementMetadata& metadata, w
 webm::Status WebmReader::OnElementBegin(const webm::ElementMetadata& metadata, webm::Action* action)
 {
   switch (metadata.id) {
-  case webm::Id::kCues:
-    if (m_cuePoints)
-      *action = webm::Action::kRead;
-    break;
   case webm::Id::kCluster:
     *action = webm::Action::kRead;
     break;
@@ -215,30 +238,6 @@ webm::Status WebmReader::OnElementBegin(const webm::ElementMetadata& metadata, w
   return webm::Status(webm::Status::kOkCompleted);
 }
 
-webm::Status WebmReader::OnCuePoint(const webm::ElementMetadata& metadata, const webm::CuePoint& cue_point)
-{
-  if (m_cuePoints && cue_point.time.is_present()
-    && !cue_point.cue_track_positions.empty())
-  {
-    CUEPOINT cue;
-    cue.pts = cue_point.time.value();
-    cue.duration = 0;
-    //Attention these byte values are relative to Segment body start!
-    cue.pos_start = cue_point.cue_track_positions[0].value().cluster_position.value();
-    cue.pos_end = ~0ULL;
-
-    if (!m_cuePoints->empty())
-    {
-      CUEPOINT &backcue = m_cuePoints->back();
-      backcue.duration = cue.pts - backcue.pts;
-      backcue.pos_end = cue.pos_start - 1;
-    }
-    m_cuePoints->push_back(cue);
-  }
-
-  return webm::Status(webm::Status::kOkCompleted);
-}
-
 webm::Status WebmReader::OnClusterBegin(const webm::ElementMetadata& metadata, const webm::Cluster& cluster, webm::Action* action)
 {
   m_ptsOffset = cluster.timecode.is_present() ? cluster.timecode.value() : 0;
@@ -269,9 +268,9 @@ webm::Status WebmReader::OnFrame(const webm::FrameMetadata& metadata, webm::Read
     return webm::Status(webm::Status::kOkCompleted);
 
   webm::Status status;
+  std::uint64_t num_read = 0;
   do {
     std::uint64_t num_actually_read;
-    std::uint64_t num_read = 0;
     status = reader->Read(static_cast<size_t>(*bytes_remaining), m_frameBuffer.UseData() + num_read, &num_actually_read);
     *bytes_remaining -= num_actually_read;
     num_read += num_actually_read;
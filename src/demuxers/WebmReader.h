@@ -25,19 +25,9 @@ class WebmAP4Reader;
 class ATTR_DLL_LOCAL WebmReader : public webm::Callback
 {
 public:
-
-  struct CUEPOINT
-  {
-    uint64_t pts;
-    uint64_t duration;
-    uint64_t pos_start;
-    uint64_t pos_end;
-  };
-
   WebmReader(AP4_ByteStream *stream);
   virtual ~WebmReader();
 
-  void GetCuePoints(std::vector<CUEPOINT> &cuepoints);
   bool Initialize();
 
   void Reset();
@@ -49,7 +39,6 @@ public:
   webm::Status OnSegmentBegin(const webm::ElementMetadata& metadata, webm::Action* action) override;
 
   webm::Status OnElementBegin(const webm::ElementMetadata& metadata, webm::Action* action) override;
-  webm::Status OnCuePoint(const webm::ElementMetadata& metadata, const webm::CuePoint& cue_point) override;
 
   webm::Status OnClusterBegin(const webm::ElementMetadata& metadata, const webm::Cluster& cluster, webm::Action* action) override;
   webm::Status OnSimpleBlockBegin(const webm::ElementMetadata& metadata, const webm::SimpleBlock& simple_block, webm::Action* action) override;
@@ -70,7 +59,6 @@ private:
   uint64_t m_pts = STREAM_NOPTS_VALUE;
   uint64_t m_ptsOffset = 0;
   uint64_t m_duration = 0;
-  std::vector<CUEPOINT> *m_cuePoints = nullptr;
   AP4_DataBuffer m_frameBuffer, m_codecPrivate;
 
   //Video section
@@ -259,6 +259,7 @@ bool CInputStreamAdaptive::OpenStream(int streamid)
   uint16_t psshSetPos = stream->m_adStream.getRepresentation()->m_psshSetPos;
   reader->SetDecrypter(m_session->GetSingleSampleDecryptor(psshSetPos),
                        m_session->GetDecrypterCaps(psshSetPos));
+  reader->SetDecryptAheadPool(m_session->GetDecryptAheadPool());
 
   stream->SetReader(std::move(reader));
 
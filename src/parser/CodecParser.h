@@ -20,6 +20,8 @@ constexpr AP4_UI32 AP4_ADTS_SYNC_PATTERN = 0xFFF0;
 constexpr AP4_UI32 AP4_AC3_SYNC_PATTERN = 0x0B77;
 constexpr AP4_UI32 AP4_AC4_SYNC_MASK = 0xFFF0;
 constexpr AP4_UI32 AP4_AC4_SYNC_PATTERN = 0x0AC40;
+// Bytes needed to identify the frame type, the AC-3 bsid field is in the 6th byte
+constexpr size_t ADTS_SYNC_INFO_SIZE = 6;
 
 enum class AdtsType
 {
@@ -30,31 +32,23 @@ enum class AdtsType
   AC4
 };
 
-class ATTR_DLL_LOCAL CAdaptiveAdtsParser : public AP4_AdtsParser
-{
-public:
-  CAdaptiveAdtsParser() {}
-  AP4_Result FindFrameHeader(AP4_AacFrame& frame);
-};
-
-class ATTR_DLL_LOCAL CAdaptiveAc3Parser : public AP4_Ac3Parser
-{
-public:
-  CAdaptiveAc3Parser() {}
-  AP4_Result FindFrameHeader(AP4_Ac3Frame& frame);
-};
-
-class ATTR_DLL_LOCAL CAdaptiveEac3Parser : public AP4_Eac3Parser
-{
-public:
-  CAdaptiveEac3Parser() {}
-  AP4_Result FindFrameHeader(AP4_Eac3Frame& frame);
-};
-
 class ATTR_DLL_LOCAL CAdaptiveAdtsHeaderParser
 {
 public:
-  static AdtsType GetAdtsType(AP4_ByteStream* stream);
+  /*!
+   * \brief Get the type of the audio frame, from the sync word at the begin of the data.
+   * \param data The data
+   * \param size The data size, at least ADTS_SYNC_INFO_SIZE bytes are needed
+   * \return The type, or AdtsType::NONE if there is no sync word
+   */
+  static AdtsType GetAdtsType(const uint8_t* data, size_t size);
+
+  /*!
+   * \brief Get the number of bytes needed to parse the header of a frame.
+   * \param adtsType The frame type
+   * \return The header size, 0 if the type is not supported
+   */
+  static size_t GetHeaderSize(AdtsType adtsType);
 };
 
 } // namespace adaptive
@@ -25,6 +25,7 @@
 #include <cmath>
 #include <cstdio> // sscanf
 #include <numeric> // accumulate
+#include <sstream>
 #include <string>
 #include <thread>
 
@@ -46,6 +47,14 @@ using namespace UTILS;
 
 namespace
 {
+// UTCTiming schemes supported to synchronize the clock with the server
+constexpr std::string_view UTC_SCHEME_HTTP_HEAD = "urn:mpeg:dash:utc:http-head:2014";
+constexpr std::string_view UTC_SCHEME_HTTP_XSDATE = "urn:mpeg:dash:utc:http-xsdate:2014";
+constexpr std::string_view UTC_SCHEME_HTTP_ISO = "urn:mpeg:dash:utc:http-iso:2014";
+constexpr std::string_view UTC_SCHEME_DIRECT = "urn:mpeg:dash:utc:direct:2014";
+// Interval to resynchronize the clock with the server on manifest updates, in ms
+constexpr uint64_t CLOCK_RESYNC_INTERVAL = 300000;
+
 std::string ReplacePlaceHolders(std::string str, const std::string_view id, uint32_t bandwidth)
 {
   STRING::ReplaceAll(str, "$RepresentationID$", id);
@@ -97,12 +106,190 @@ std::string DetectCodecFromMimeType(std::string_view mimeType)
   return "";
 }
 
+// Get the local name of a node, without the namespace prefix
+std::string_view GetLocalName(const xml_node& node)
+{
+  std::string_view name = node.name();
+  const size_t prefixPos = name.find(':');
+  if (prefixPos != std::string_view::npos)
+    name.remove_prefix(prefixPos + 1);
+  return name;
+}
+
+/*!
+ * \brief Apply an operation of a MPD patch document, as defined by RFC 5261 (add, replace, remove),
+ *        the "sel" XPath selector must identify a single node.
+ *        Namespace operations are not supported.
+ * \param doc The MPD document to be patched
+ * \param nodeOp The operation node of the patch document
+ * \return True if the operation has been applied, otherwise false
+ */
+bool ApplyPatchOperation(xml_document& doc, xml_node nodeOp)
+{
+  const std::string_view opName = GetLocalName(nodeOp);
+  const std::string sel{XML::GetAttrib(nodeOp, "sel")};
+  if (sel.empty())
+    return false;
+
+  xpath_node target;
+  try
+  {
+    target = doc.select_node(sel.c_str());
+  }
+  catch (const std::exception& e)
+  {
+    LOG::LogF(LOGERROR, "MPD patch - Invalid selector \"%s\": %s", sel.c_str(), e.what());
+    return false;
+  }
+
+  if (!target)
+  {
+    LOG::LogF(LOGDEBUG, "MPD patch - No node found for selector \"%s\"", sel.c_str());
+    return false;
+  }
+
+  xml_node node = target.node();
+  xml_attribute attrib = target.attribute();
+
+  if (opName == "add")
+  {
+    if (!node || node.type() != node_element)
+      return false;
+
+    // Add an attribute e.g. type="@name", the text is the value
+    const std::string_view type = XML::GetAttrib(nodeOp, "type");
+    if (!type.empty())
+    {
+      if (type.front() != '@')
+        return false;
+
+      const std::string attribName{type.substr(1)};
+      xml_attribute newAttrib = node.attribute(attribName.c_str());
+      if (!newAttrib)
+        newAttrib = node.append_attribute(attribName.c_str());
+      return newAttrib.set_value(nodeOp.child_value());
+    }
+
+    // Add the child elements of the operation, by keeping their order
+    const std::string_view pos = XML::GetAttrib(nodeOp, "pos");
+    if ((pos == "before" || pos == "after") && !node.parent())
+      return false;
+
+    xml_node prevNode;
+    for (xml_node child : nodeOp.children())
+    {
+      if (child.type() != node_element)
+        continue;
+
+      if (pos == "before")
+        prevNode = node.parent().insert_copy_before(child, node);
+      else if (pos == "after")
+        prevNode = node.parent().insert_copy_after(child, prevNode ? prevNode : node);
+      else if (pos == "prepend")
+        prevNode = prevNode ? node.insert_copy_after(child, prevNode) : node.prepend_copy(child);
+      else
+        prevNode = node.append_copy(child);
+
+      if (!prevNode)
+        return false;
+    }
+    return true;
+  }
+  else if (opName == "replace")
+  {
+    if (attrib)
+      return attrib.set_value(nodeOp.child_value());
+
+    if (node.type() == node_pcdata)
+      return node.set_value(nodeOp.child_value());
+
+    xml_node newNode = nodeOp.find_child([](const xml_node& child)
+                                         { return child.type() == node_element; });
+    xml_node parent = node.parent();
+    if (!newNode || !parent || !parent.insert_copy_before(newNode, node))
+      return false;
+
+    return parent.remove_child(node);
+  }
+  else if (opName == "remove")
+  {
+    if (attrib)
+      return target.parent().remove_attribute(attrib);
+
+    return node.parent() && node.parent().remove_child(node);
+  }
+
+  LOG::LogF(LOGERROR, "MPD patch - Unsupported operation \"%s\"", nodeOp.name());
+  return false;
+}
+
+/*!
+ * \brief Apply a MPD patch document to a MPD document.
+ * \param patchData The MPD patch document
+ * \param manifestData [IN/OUT] The MPD document to be patched
+ * \return True if the patch has been applied, otherwise false
+ */
+bool ApplyManifestPatch(const std::string& patchData, std::string& manifestData)
+{
+  xml_document docPatch;
+  if (docPatch.load_buffer(patchData.c_str(), patchData.size()).status != status_ok)
+  {
+    LOG::LogF(LOGERROR, "MPD patch - Failed to parse the patch document");
+    return false;
+  }
+
+  xml_node nodePatch = docPatch.document_element();
+  if (GetLocalName(nodePatch) != "Patch")
+  {
+    LOG::LogF(LOGERROR, "MPD patch - Failed to get the <Patch> tag element");
+    return false;
+  }
+
+  xml_document doc;
+  if (doc.load_buffer(manifestData.c_str(), manifestData.size()).status != status_ok)
+    return false;
+
+  xml_node nodeMPD = doc.child("MPD");
+
+  // The patch can be applied only to the MPD having the same id and publish time
+  if (XML::GetAttrib(nodePatch, "mpdId") != XML::GetAttrib(nodeMPD, "id") ||
+      XML::GetAttrib(nodePatch, "originalPublishTime") != XML::GetAttrib(nodeMPD, "publishTime"))
+  {
+    LOG::LogF(LOGDEBUG, "MPD patch - The patch does not match the current MPD");
+    return false;
+  }
+
+  for (xml_node nodeOp : nodePatch.children())
+  {
+    if (nodeOp.type() != node_element)
+      continue;
+
+    if (!ApplyPatchOperation(doc, nodeOp))
+    {
+      LOG::LogF(LOGWARNING, "MPD patch - Failed to apply \"%s\" operation with selector \"%s\"",
+                nodeOp.name(), XML::GetAttrib(nodeOp, "sel").data());
+      return false;
+    }
+  }
+
+  // The publish time must be updated to allow the next patch to be applied
+  std::string_view publishTime = XML::GetAttrib(nodePatch, "publishTime");
+  if (!publishTime.empty() && XML::GetAttrib(nodeMPD, "publishTime") != publishTime)
+    nodeMPD.attribute("publishTime").set_value(std::string(publishTime).c_str());
+
+  std::ostringstream oss;
+  doc.save(oss, "", format_raw);
+  manifestData = oss.str();
+  return true;
+}
+
 } // unnamed namespace
 
 
 adaptive::CDashTree::CDashTree(const CDashTree& left) : AdaptiveTree(left)
 {
   m_isCustomInitPssh = left.m_isCustomInitPssh;
+  m_clockSyncTime = left.m_clockSyncTime;
 }
 
 void adaptive::CDashTree::Configure(CHOOSER::IRepresentationChooser* reprChooser,
@@ -126,6 +313,13 @@ bool adaptive::CDashTree::Open(std::string_view url,
   if (!ParseManifest(data))
     return false;
 
+  // Keep the MPD document to apply the patches of the next manifest updates
+  if (!m_patchLocation.empty())
+  {
+    m_manifestData = data;
+    m_manifestDataUrl = url;
+  }
+
   if (m_periods.empty())
   {
     LOG::Log(LOGWARNING, "No periods in the manifest");
@@ -179,6 +373,11 @@ bool adaptive::CDashTree::ParseManifest(const std::string& data)
     return false;
   }
 
+  // Parse <MPD> <UTCTiming> tags, the clock must be synchronized before the live segments
+  // are generated from the current time
+  if (XML::GetAttrib(nodeMPD, "type") == "dynamic" && nodeMPD.child("UTCTiming"))
+    SyncServerClock(nodeMPD);
+
   // Parse <MPD> tag attributes
   ParseTagMPDAttribs(nodeMPD);
 
@@ -192,10 +391,49 @@ bool adaptive::CDashTree::ParseManifest(const std::string& data)
       location_ = locationUrl;
   }
 
-  // Parse <MPD> <UTCTiming> tags
-  //! @todo: needed implementation
-  if (nodeMPD.child("UTCTiming"))
-    LOG::LogF(LOGWARNING, "The <UTCTiming> tag element is not supported so playback problems may occur.");
+  // Parse <MPD> <PatchLocation> tag,
+  // the patches can be used only when the MPD has id and publish time
+  xml_node nodePatchLocation = nodeMPD.child("PatchLocation");
+  std::string_view patchLocationUrl = nodePatchLocation.child_value();
+  std::string publishTime;
+  if (m_isLive && !patchLocationUrl.empty() && !XML::GetAttrib(nodeMPD, "id").empty() &&
+      XML::QueryAttrib(nodeMPD, "publishTime", publishTime))
+  {
+    if (URL::IsUrlAbsolute(patchLocationUrl))
+      m_patchLocation = patchLocationUrl;
+    else
+      m_patchLocation = URL::Join(base_url_, std::string(patchLocationUrl));
+
+    // The time to live of the patch location is relative to the MPD publish time
+    const double ttl = STRING::ToDouble(XML::GetAttrib(nodePatchLocation, "ttl"));
+    const double publishTimeSecs = XML::ParseDate(publishTime, 0);
+    if (ttl > 0 && publishTimeSecs > 0)
+      m_patchLocationExpiry = static_cast<uint64_t>((publishTimeSecs + ttl) * 1000);
+  }
+
+  // Parse <MPD> <ServiceDescription> tag, the latency target of low latency streams
+  // and the latency range / playback rates that can be used to keep the latency on target
+  xml_node nodeServiceDesc = nodeMPD.child("ServiceDescription");
+  xml_node nodeLatency = nodeServiceDesc.child("Latency");
+  if (m_isLive && nodeLatency)
+  {
+    uint64_t latencyTarget;
+    if (XML::QueryAttrib(nodeLatency, "target", latencyTarget))
+      m_lowLatencyDelay = latencyTarget;
+
+    XML::QueryAttrib(nodeLatency, "min", m_minLatency);
+    XML::QueryAttrib(nodeLatency, "max", m_maxLatency);
+  }
+  xml_node nodePlaybackRate = nodeServiceDesc.child("PlaybackRate");
+  if (m_isLive && nodePlaybackRate)
+  {
+    const double minRate = STRING::ToDouble(XML::GetAttrib(nodePlaybackRate, "min"));
+    const double maxRate = STRING::ToDouble(XML::GetAttrib(nodePlaybackRate, "max"));
+    if (minRate > 0)
+      m_minPlaybackRate = minRate;
+    if (maxRate > 0)
+      m_maxPlaybackRate = maxRate;
+  }
 
   // Parse <MPD> <BaseURL> tag (just first, multi BaseURL not supported yet)
   std::string mpdUrl = base_url_;
@@ -342,6 +580,79 @@ void adaptive::CDashTree::ParseTagMPDAttribs(pugi::xml_node nodeMPD)
   }
 }
 
+void adaptive::CDashTree::SyncServerClock(pugi::xml_node nodeMPD)
+{
+  if (m_clockSyncTime != NO_VALUE && GetTimestamp() - m_clockSyncTime < CLOCK_RESYNC_INTERVAL)
+    return;
+
+  m_clockSyncTime = GetTimestamp();
+
+  // Try the schemes in the order they are provided, until the synchronization succeeds
+  for (xml_node node : nodeMPD.children("UTCTiming"))
+  {
+    std::string_view schemeIdUri = XML::GetAttrib(node, "schemeIdUri");
+    // The value can have multiple whitespace separated urls, use the first one
+    std::string value = STRING::Trim(std::string(XML::GetAttrib(node, "value")));
+    value = value.substr(0, value.find_first_of(" \t\r\n"));
+
+    if (value.empty())
+      continue;
+
+    const uint64_t reqStartTime = GetTimestamp();
+    uint64_t serverTime{0};
+
+    if (schemeIdUri == UTC_SCHEME_DIRECT)
+    {
+      serverTime = static_cast<uint64_t>(XML::ParseDate(value, 0) * 1000);
+    }
+    else if (schemeIdUri == UTC_SCHEME_HTTP_HEAD || schemeIdUri == UTC_SCHEME_HTTP_XSDATE ||
+             schemeIdUri == UTC_SCHEME_HTTP_ISO)
+    {
+      if (URL::IsUrlRelative(value))
+        value = URL::Join(base_url_, value);
+
+      CURL::HTTPResponse resp;
+      if (!DownloadServerTime(value, resp))
+      {
+        LOG::LogF(LOGWARNING, "Cannot download the server time from \"%s\"", value.c_str());
+        continue;
+      }
+
+      if (schemeIdUri == UTC_SCHEME_HTTP_HEAD)
+        serverTime = ParseHttpDate(resp.headers["date"]);
+      else
+        serverTime = static_cast<uint64_t>(XML::ParseDate(STRING::Trim(resp.data), 0) * 1000);
+    }
+    else
+    {
+      LOG::LogF(LOGDEBUG, "UTCTiming scheme \"%s\" not supported", schemeIdUri.data());
+      continue;
+    }
+
+    if (serverTime == 0)
+    {
+      LOG::LogF(LOGWARNING, "Cannot parse the server time of UTCTiming scheme \"%s\"",
+                schemeIdUri.data());
+      continue;
+    }
+
+    // Compensate the request round trip, assuming the server time taken at half of it
+    const uint64_t localTime = reqStartTime + (GetTimestamp() - reqStartTime) / 2;
+    const int64_t clockOffset = static_cast<int64_t>(serverTime) - static_cast<int64_t>(localTime);
+
+    // The stream start time is the reference to generate the live segments
+    stream_start_ += clockOffset - m_clockOffset;
+    m_clockOffset = clockOffset;
+
+    LOG::Log(LOGDEBUG, "Clock synchronized with the server by UTCTiming \"%s\", offset: %lli ms",
+             schemeIdUri.data(), static_cast<long long>(clockOffset));
+    return;
+  }
+
+  LOG::Log(LOGWARNING, "Cannot synchronize the clock with the server by UTCTiming, "
+                       "playback problems may occur.");
+}
+
 void adaptive::CDashTree::ParseTagPeriod(pugi::xml_node nodePeriod, std::string_view mpdUrl)
 {
   std::unique_ptr<CPeriod> period = CPeriod::MakeUniquePtr();
@@ -424,6 +735,12 @@ void adaptive::CDashTree::ParseTagPeriod(pugi::xml_node nodePeriod, std::string_
     period->SetSegmentList(segList);
   }
 
+  // Parse <EventStream> tags
+  for (xml_node node : nodePeriod.children("EventStream"))
+  {
+    ParseTagEventStream(node, period.get());
+  }
+
   // Parse <AdaptationSet> tags
   for (xml_node node : nodePeriod.children("AdaptationSet"))
   {
@@ -433,6 +750,64 @@ void adaptive::CDashTree::ParseTagPeriod(pugi::xml_node nodePeriod, std::string_
   m_periods.push_back(std::move(period));
 }
 
+void adaptive::CDashTree::ParseTagEventStream(pugi::xml_node nodeEventStream,
+                                              PLAYLIST::CPeriod* period)
+{
+  std::string_view schemeIdUri = XML::GetAttrib(nodeEventStream, "schemeIdUri");
+  if (schemeIdUri.empty())
+  {
+    LOG::LogF(LOGWARNING, "Skipped <EventStream> tag without schemeIdUri attribute");
+    return;
+  }
+
+  uint32_t timescale{1};
+  XML::QueryAttrib(nodeEventStream, "timescale", timescale);
+  if (timescale == 0)
+    timescale = 1;
+
+  uint64_t pto{0};
+  XML::QueryAttrib(nodeEventStream, "presentationTimeOffset", pto);
+
+  // Event times are relative to the period start
+  const uint64_t periodStart = period->GetStart() == NO_VALUE ? 0 : period->GetStart();
+
+  for (xml_node node : nodeEventStream.children("Event"))
+  {
+    CEventMessage event;
+    event.m_schemeIdUri = schemeIdUri;
+    event.m_value = XML::GetAttrib(nodeEventStream, "value");
+    event.m_timescale = timescale;
+
+    uint64_t presentationTime{0};
+    XML::QueryAttrib(node, "presentationTime", presentationTime);
+    event.m_presentationTime = periodStart * timescale / 1000;
+    if (presentationTime > pto)
+      event.m_presentationTime += presentationTime - pto;
+
+    XML::QueryAttrib(node, "duration", event.m_duration);
+    XML::QueryAttrib(node, "id", event.m_id);
+
+    // The message can be provided by the attribute or as content of the tag,
+    // that can be text (e.g. base64 data) or XML elements (e.g. SCTE-35 signal)
+    if (!XML::QueryAttrib(node, "messageData", event.m_messageData))
+    {
+      if (node.first_child().type() == pugi::node_element)
+      {
+        std::ostringstream oss;
+        for (xml_node nodeChild : node.children())
+        {
+          nodeChild.print(oss, "", format_raw);
+        }
+        event.m_messageData = oss.str();
+      }
+      else
+        event.m_messageData = node.child_value();
+    }
+
+    period->AddEventMessage(event);
+  }
+}
+
 void adaptive::CDashTree::ParseTagAdaptationSet(pugi::xml_node nodeAdp, PLAYLIST::CPeriod* period)
 {
   std::unique_ptr<CAdaptationSet> adpSet = CAdaptationSet::MakeUniquePtr(period);
@@ -1070,6 +1445,25 @@ void adaptive::CDashTree::ParseTagRepresentation(pugi::xml_node nodeRepr,
         }
 
         repr->SetTimescale(segTimescale);
+
+        // Low latency streams, the segment in production that follows the last one listed
+        // can be requested in advance of its availability time, with the same duration
+        if (m_isLive && segTemplate->HasAvailabilityTimeOffset() && !repr->Timeline().IsEmpty())
+        {
+          const CSegment* lastSeg = repr->Timeline().GetBack();
+          const uint64_t duration = lastSeg->m_endPts - lastSeg->startPTS_;
+
+          CSegment seg;
+          seg.startPTS_ = lastSeg->m_endPts;
+          seg.m_endPts = seg.startPTS_ + duration;
+          if (hasMediaNumber)
+            seg.m_number = segNumber;
+          seg.m_time = time;
+
+          const uint64_t availTime = ComputeSegmentAvailableTime(period, repr.get(), seg);
+          if (duration > 0 && availTime != NO_VALUE && availTime <= stream_start_)
+            repr->Timeline().Add(seg);
+        }
       }
       else // Generate segments by using template
       {
@@ -1102,6 +1496,15 @@ void adaptive::CDashTree::ParseTagRepresentation(pugi::xml_node nodeRepr,
 
           segmentsCount = std::max<size_t>(durationMs / segDurMs, 1);
 
+          // Low latency streams, the segment in production can be requested in advance
+          // of its availability time, its data will be delivered in chunks while it is produced
+          if (segTemplate->HasAvailabilityTimeOffset())
+          {
+            const uint64_t offset = std::min(segTemplate->GetAvailabilityTimeOffset(), segDurMs);
+            segmentsCount = std::max<size_t>(
+                static_cast<size_t>((tsbEnd + offset) / segDurMs - tsbStart / segDurMs), 1);
+          }
+
           if (available_time_ == 0)
           {
             time = tsbStart * segTemplate->GetTimescale() / 1000;
@@ -1224,6 +1627,19 @@ void adaptive::CDashTree::ParseSegmentTemplate(pugi::xml_node node, CSegmentTemp
   if (XML::QueryAttrib(node, "presentationTimeOffset", pto))
     segTpl.SetPresTimeOffset(pto);
 
+  // Low latency streams, "INF" value (segments always available) is ignored
+  std::string availabilityTimeOffset;
+  if (XML::QueryAttrib(node, "availabilityTimeOffset", availabilityTimeOffset) &&
+      availabilityTimeOffset != "INF")
+  {
+    segTpl.SetAvailabilityTimeOffset(
+        static_cast<uint64_t>(STRING::ToDouble(availabilityTimeOffset) * 1000));
+  }
+
+  std::string availabilityTimeComplete;
+  if (XML::QueryAttrib(node, "availabilityTimeComplete", availabilityTimeComplete))
+    segTpl.SetAvailabilityTimeComplete(availabilityTimeComplete != "false");
+
   // Parse <SegmentTemplate> <SegmentTimeline> child
   xml_node nodeSegTL = node.child("SegmentTimeline");
   if (nodeSegTL)
@@ -1573,6 +1989,11 @@ bool adaptive::CDashTree::DownloadManifestUpd(std::string_view url,
   return CURL::DownloadFile(url, reqHeaders, respHeaders, resp);
 }
 
+bool adaptive::CDashTree::DownloadServerTime(std::string_view url, UTILS::CURL::HTTPResponse& resp)
+{
+  return CURL::DownloadFile(url, m_manifestHeaders, {"date"}, resp);
+}
+
 void adaptive::CDashTree::OnRequestSegments(PLAYLIST::CPeriod* period,
                                             PLAYLIST::CAdaptationSet* adp,
                                             PLAYLIST::CRepresentation* rep)
@@ -1610,26 +2031,45 @@ void adaptive::CDashTree::OnUpdateSegments()
               "The $START_NUMBER$ placeholder in the manifest parameters is no longer supported.");
   }
 
-  // Set header data based from previous manifest request
-  if (!m_manifestRespHeaders["etag"].empty())
-    m_manifestHeaders["If-None-Match"] = "\"" + m_manifestRespHeaders["etag"] + "\"";
+  CURL::HTTPResponse resp;
+  // Try to update the MPD with a patch, on failure fallback to the full MPD download
+  bool isPatched = DownloadManifestPatch(resp);
+  if (isPatched && !updateTree->Open(resp.effectiveUrl, resp.headers, resp.data))
+  {
+    isPatched = false;
+    resp = {};
+    updateTree.reset(Clone());
+  }
 
-  if (!m_manifestRespHeaders["last-modified"].empty())
-    m_manifestHeaders["If-Modified-Since"] = m_manifestRespHeaders["last-modified"];
+  if (!isPatched)
+  {
+    // Set header data based from previous manifest request
+    if (!m_manifestRespHeaders["etag"].empty())
+      m_manifestHeaders["If-None-Match"] = "\"" + m_manifestRespHeaders["etag"] + "\"";
 
-  URL::AppendParameters(manifestUrl, manifestParams);
+    if (!m_manifestRespHeaders["last-modified"].empty())
+      m_manifestHeaders["If-Modified-Since"] = m_manifestRespHeaders["last-modified"];
 
-  // Download and open the manifest update
-  CURL::HTTPResponse resp;
-  if (!DownloadManifestUpd(manifestUrl, m_manifestHeaders, {"etag", "last-modified"}, resp) ||
-      !updateTree->Open(resp.effectiveUrl, resp.headers, resp.data))
-  {
-    return;
+    URL::AppendParameters(manifestUrl, manifestParams);
+
+    // Download and open the manifest update
+    if (!DownloadManifestUpd(manifestUrl, m_manifestHeaders, {"etag", "last-modified"}, resp) ||
+        !updateTree->Open(resp.effectiveUrl, resp.headers, resp.data))
+    {
+      return;
+    }
+    m_manifestRespHeaders = resp.headers;
   }
 
   // Update local members for the next manifest update
-  m_manifestRespHeaders = resp.headers;
   location_ = updateTree->location_;
+  m_patchLocation = updateTree->m_patchLocation;
+  m_patchLocationExpiry = updateTree->m_patchLocationExpiry;
+  m_manifestData = std::move(updateTree->m_manifestData);
+  m_manifestDataUrl = updateTree->m_manifestDataUrl;
+  stream_start_ = updateTree->stream_start_;
+  m_clockOffset = updateTree->m_clockOffset.load();
+  m_clockSyncTime = updateTree->m_clockSyncTime;
 
   for (size_t index{0}; index < updateTree->m_periods.size(); index++)
   {
@@ -1675,6 +2115,15 @@ void adaptive::CDashTree::OnUpdateSegments()
     {
       if (updPeriod->GetDuration() > 0)
         period->SetDuration(updPeriod->GetDuration());
+
+      for (const CEventMessage& event : updPeriod->GetEventMessages())
+      {
+        if (period->AddEventMessage(event))
+        {
+          LOG::Log(LOGDEBUG, "New MPD event (scheme: %s, value: %s, id: %u)",
+                   event.m_schemeIdUri.c_str(), event.m_value.c_str(), event.m_id);
+        }
+      }
     }
 
     for (auto& updAdpSet : updPeriod->GetAdaptationSets())
@@ -1789,6 +2238,123 @@ void adaptive::CDashTree::OnUpdateSegments()
   }
 }
 
+uint64_t adaptive::CDashTree::GetNextSegmentAvailableTime(PLAYLIST::CPeriod* period,
+                                                          PLAYLIST::CRepresentation* repr)
+{
+  // Only the segments of SegmentTimeline are added by the manifest updates,
+  // SegmentTemplate without timeline generate the segments by InsertLiveSegment
+  if (!repr->HasSegmentTemplate() || !repr->GetSegmentTemplate()->HasTimeline())
+    return NO_VALUE;
+
+  const CSegment* lastSeg = repr->Timeline().GetBack();
+  if (!lastSeg)
+    return NO_VALUE;
+
+  // Assume that the next segment has the same duration of the last one
+  CSegment nextSeg;
+  nextSeg.startPTS_ = lastSeg->m_endPts;
+  nextSeg.m_endPts = nextSeg.startPTS_ + (lastSeg->m_endPts - lastSeg->startPTS_);
+
+  return ComputeSegmentAvailableTime(period, repr, nextSeg);
+}
+
+uint64_t adaptive::CDashTree::GetSegmentAvailableTime(PLAYLIST::CPeriod* period,
+                                                      PLAYLIST::CRepresentation* repr,
+                                                      const PLAYLIST::CSegment& segment)
+{
+  // The SegmentTimeline segments are published by the manifest when available
+  if (!repr->HasSegmentTemplate() || repr->GetSegmentTemplate()->HasTimeline())
+    return NO_VALUE;
+
+  return ComputeSegmentAvailableTime(period, repr, segment);
+}
+
+uint64_t adaptive::CDashTree::ComputeSegmentAvailableTime(PLAYLIST::CPeriod* period,
+                                                          PLAYLIST::CRepresentation* repr,
+                                                          const PLAYLIST::CSegment& segment)
+{
+  if (!m_isLive || available_time_ == 0 || !repr->HasSegmentTemplate() ||
+      repr->GetTimescale() == 0)
+    return NO_VALUE;
+
+  auto& segTemplate = repr->GetSegmentTemplate();
+  const uint32_t timescale = repr->GetTimescale();
+  const uint64_t periodStartMs = period->GetStart() == NO_VALUE ? 0 : period->GetStart();
+  const uint64_t segDurMs = (segment.m_endPts - segment.startPTS_) * 1000 / timescale;
+  uint64_t segEndMs{0}; // The segment end time from the availability start time
+
+  if (segTemplate->HasTimeline())
+  {
+    // Without PTO the segments PTS include the period start (see ParseTagRepresentation)
+    if (segTemplate->HasPresTimeOffset())
+    {
+      const uint64_t pto = segTemplate->GetPresTimeOffset();
+      const uint64_t endPts = segment.m_endPts > pto ? segment.m_endPts - pto : 0;
+      segEndMs = periodStartMs + endPts * 1000 / timescale;
+    }
+    else
+      segEndMs = segment.m_endPts * 1000 / timescale;
+  }
+  else if (segTemplate->HasMediaNumber() && segment.m_number != SEGMENT_NO_NUMBER &&
+           segment.m_number >= segTemplate->GetStartNumber() && segTemplate->GetDuration() > 0)
+  {
+    // The generated segments PTS are not aligned to the segments duration,
+    // the number identify exactly the segment time, the division is made last
+    // to not accumulate the rounding error of the duration in ms
+    segEndMs = periodStartMs + (segment.m_number - segTemplate->GetStartNumber() + 1) *
+                                   segTemplate->GetDuration() * 1000 /
+                                   segTemplate->GetTimescale();
+  }
+  else
+    segEndMs = segment.m_endPts * 1000 / timescale;
+
+  uint64_t availTime = available_time_ + segEndMs;
+
+  // Low latency streams, the segment in production can be requested in advance
+  if (segTemplate->HasAvailabilityTimeOffset())
+    availTime -= std::min(segTemplate->GetAvailabilityTimeOffset(), segDurMs);
+
+  return availTime;
+}
+
+bool adaptive::CDashTree::DownloadManifestPatch(UTILS::CURL::HTTPResponse& resp)
+{
+  if (m_patchLocation.empty() || m_manifestData.empty())
+    return false;
+
+  if (m_patchLocationExpiry != NO_VALUE && GetServerTimestamp() >= m_patchLocationExpiry)
+  {
+    LOG::LogF(LOGDEBUG, "MPD patch - The patch location is expired");
+    return false;
+  }
+
+  // The conditional headers are related to the full MPD requests
+  std::map<std::string, std::string> headers = m_manifestHeaders;
+  headers.erase("If-None-Match");
+  headers.erase("If-Modified-Since");
+
+  std::string patchUrl = m_patchLocation;
+  URL::AppendParameters(patchUrl, m_manifestUpdParams);
+
+  CURL::HTTPResponse patchResp;
+  if (!DownloadManifestUpd(patchUrl, headers, {}, patchResp))
+  {
+    LOG::LogF(LOGWARNING, "MPD patch - Cannot download the patch, fallback to the full MPD");
+    return false;
+  }
+
+  std::string manifestData = m_manifestData;
+  if (!ApplyManifestPatch(patchResp.data, manifestData))
+  {
+    LOG::LogF(LOGWARNING, "MPD patch - Cannot apply the patch, fallback to the full MPD");
+    return false;
+  }
+
+  resp.effectiveUrl = m_manifestDataUrl;
+  resp.data = std::move(manifestData);
+  return true;
+}
+
 bool adaptive::CDashTree::InsertLiveSegment(PLAYLIST::CPeriod* period,
                                             PLAYLIST::CAdaptationSet* adpSet,
                                             PLAYLIST::CRepresentation* repr,
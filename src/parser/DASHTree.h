@@ -13,6 +13,7 @@
 #include "common/SegTemplate.h"
 #include "utils/CurlUtils.h"
 
+#include <string>
 #include <string_view>
 
 // Forward
@@ -49,6 +50,10 @@ public:
                                  PLAYLIST::CRepresentation* repr,
                                  size_t pos) override;
 
+  virtual uint64_t GetSegmentAvailableTime(PLAYLIST::CPeriod* period,
+                                           PLAYLIST::CRepresentation* repr,
+                                           const PLAYLIST::CSegment& segment) override;
+
   virtual bool InsertLiveFragment(PLAYLIST::CAdaptationSet* adpSet,
                                   PLAYLIST::CRepresentation* repr,
                                   uint64_t fTimestamp,
@@ -67,6 +72,14 @@ protected:
                               PLAYLIST::CAdaptationSet* adpSet,
                               PLAYLIST::CPeriod* period);
 
+  /*!
+   * \brief Parse the <Event> tags of an <EventStream> tag and add them to the period,
+   *        the presentation time of the events is converted to the presentation timeline.
+   * \param nodeEventStream The <EventStream> node
+   * \param period The period of the events
+   */
+  void ParseTagEventStream(pugi::xml_node nodeEventStream, PLAYLIST::CPeriod* period);
+
   void ParseTagSegmentTimeline(pugi::xml_node parentNode,
                                std::vector<uint32_t>& SCTimeline);
 
@@ -96,6 +109,18 @@ protected:
 
   void MergeAdpSets();
 
+  /*!
+   * \brief Synchronize the clock with the server by using the <UTCTiming> schemes,
+   *        resynchronize periodically when called on manifest updates.
+   * \param nodeMPD The <MPD> node
+   */
+  void SyncServerClock(pugi::xml_node nodeMPD);
+
+  /*!
+   * \brief Download the server time for UTCTiming, overridable method for test project
+   */
+  virtual bool DownloadServerTime(std::string_view url, UTILS::CURL::HTTPResponse& resp);
+
   /*!
    * \brief Download manifest update, overridable method for test project
    */
@@ -110,6 +135,28 @@ protected:
 
   virtual void OnUpdateSegments() override;
 
+  virtual uint64_t GetNextSegmentAvailableTime(PLAYLIST::CPeriod* period,
+                                               PLAYLIST::CRepresentation* repr) override;
+
+  /*!
+   * \brief Compute the availability start time of a live SegmentTemplate segment, that is when
+   *        the segment is completed, or in advance by the availabilityTimeOffset.
+   * \param period The period of the segment
+   * \param repr The representation of the segment
+   * \param segment The segment
+   * \return The UTC time in ms, otherwise NO_VALUE if it cannot be determined
+   */
+  uint64_t ComputeSegmentAvailableTime(PLAYLIST::CPeriod* period,
+                                       PLAYLIST::CRepresentation* repr,
+                                       const PLAYLIST::CSegment& segment);
+
+  /*!
+   * \brief Download the MPD patch from the patch location and apply it to the last MPD document.
+   * \param resp [OUT] The patched MPD document, with the url of the MPD
+   * \return True if the patch has been applied, otherwise false (the full MPD must be downloaded)
+   */
+  bool DownloadManifestPatch(UTILS::CURL::HTTPResponse& resp);
+
   // The lower start number of segments
   uint64_t m_segmentsLowerStartNumber{0};
 
@@ -123,6 +170,13 @@ protected:
 
   uint64_t m_minimumUpdatePeriod{PLAYLIST::NO_VALUE}; // in seconds, NO_VALUE if not set
 
+  std::string m_patchLocation; // MPD patch url, empty if the MPD cannot be updated with patches
+  uint64_t m_patchLocationExpiry{PLAYLIST::NO_VALUE}; // Patch url expiry timestamp, in ms
+  std::string m_manifestData; // The last MPD document, kept to apply the patches only
+  std::string m_manifestDataUrl; // The url of the last MPD document
+
+  uint64_t m_clockSyncTime{PLAYLIST::NO_VALUE}; // Last UTCTiming clock sync timestamp, in ms
+
   // Determines if a custom PSSH initialization license data is provided
   bool m_isCustomInitPssh{false};
 };
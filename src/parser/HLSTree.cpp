@@ -22,6 +22,7 @@
 #include "utils/log.h"
 
 #include <algorithm>
+#include <future>
 #include <optional>
 #include <sstream>
 
@@ -34,6 +35,11 @@ namespace
 // Timescale for ms
 constexpr uint64_t TIMESCALE = 1000;
 
+// Maximum number of playlists downloaded at same time by the update thread
+constexpr size_t MAX_CONCURRENT_PLAYLIST_UPDATES = 4;
+// Minimum time in ms to wait between two updates, also when a playlist update is expired
+constexpr uint64_t MIN_PLAYLIST_UPDATE_INTERVAL = 50;
+
 // \brief Parse a tag (e.g. #EXT-X-VERSION:1) to extract name and value
 void ParseTagNameValue(const std::string& line, std::string& tagName, std::string& tagValue)
 {
@@ -200,7 +206,8 @@ bool adaptive::CHLSTree::PrepareRepresentation(PLAYLIST::CPeriod* period,
 
 bool adaptive::CHLSTree::DownloadChildManifest(PLAYLIST::CAdaptationSet* adp,
                                                PLAYLIST::CRepresentation* rep,
-                                               UTILS::CURL::HTTPResponse& resp)
+                                               UTILS::CURL::HTTPResponse& resp,
+                                               std::string_view deliveryDirectives /* = "" */)
 {
   if (rep->GetSourceUrl().empty())
   {
@@ -211,6 +218,8 @@ bool adaptive::CHLSTree::DownloadChildManifest(PLAYLIST::CAdaptationSet* adp,
 
   std::string manifestUrl = rep->GetSourceUrl();
   URL::AppendParameters(manifestUrl, m_manifestParams);
+  // The delivery directives must be the last parameters
+  URL::AppendParameters(manifestUrl, deliveryDirectives);
 
   if (!DownloadManifestChild(manifestUrl, m_manifestHeaders, {}, resp))
     return false;
@@ -219,6 +228,66 @@ bool adaptive::CHLSTree::DownloadChildManifest(PLAYLIST::CAdaptationSet* adp,
   return true;
 }
 
+std::string adaptive::CHLSTree::GetDeliveryDirectives(PLAYLIST::CPeriod* period,
+                                                     PLAYLIST::CAdaptationSet* adp,
+                                                     PLAYLIST::CRepresentation* rep,
+                                                     bool isBlockingAllowed,
+                                                     bool isDeltaAllowed) const
+{
+  std::string directives;
+
+  if (!m_isLive || rep->Timeline().IsEmpty())
+    return directives;
+
+  if (isBlockingAllowed && m_canBlockReload)
+  {
+    // The most recent segments are on the representation of the last period
+    const CRepresentation* lastRep = rep;
+    const size_t adpSetPos = GetPtrPosition(period->GetAdaptationSets(), adp);
+    const size_t reprPos = GetPtrPosition(adp->GetRepresentations(), rep);
+    const auto& lastAdpSets = m_periods.back()->GetAdaptationSets();
+
+    if (adpSetPos < lastAdpSets.size() &&
+        reprPos < lastAdpSets[adpSetPos]->GetRepresentations().size())
+    {
+      const CRepresentation* lastPeriodRep =
+          lastAdpSets[adpSetPos]->GetRepresentations()[reprPos].get();
+      if (!lastPeriodRep->Timeline().IsEmpty())
+        lastRep = lastPeriodRep;
+    }
+
+    // Request the segment that follow the last one, or the next part of the segment in production
+    const CSegment* lastSeg = lastRep->Timeline().GetBack();
+    uint64_t msn = lastSeg->m_number + 1;
+    size_t partIndex{0};
+
+    if (lastSeg->m_isPartial)
+    {
+      msn = lastSeg->m_number;
+      // The part index counts all the parts listed, also the gap ones
+      partIndex = std::count_if(lastSeg->m_parts.cbegin(), lastSeg->m_parts.cend(),
+                                [](const CSegmentPart& part) { return !part.m_isPreloadHint; });
+      partIndex += lastSeg->m_gapPartsCount;
+    }
+
+    directives = "_HLS_msn=" + std::to_string(msn);
+    if (m_partDuration != NO_VALUE)
+      directives += "&_HLS_part=" + std::to_string(partIndex);
+  }
+
+  // A delta update can be requested only if the playlist is not older than half the skip boundary
+  if (isDeltaAllowed && m_canSkipUntil > 0 &&
+      std::chrono::system_clock::now() - rep->repLastUpdated_ <
+          std::chrono::milliseconds(m_canSkipUntil / 2))
+  {
+    if (!directives.empty())
+      directives += '&';
+    directives += "_HLS_skip=YES";
+  }
+
+  return directives;
+}
+
 void adaptive::CHLSTree::FixMediaSequence(std::stringstream& streamData,
                                           uint64_t& mediaSeqNumber,
                                           size_t adpSetPos,
@@ -407,26 +476,61 @@ void adaptive::CHLSTree::FixDiscSequence(std::stringstream& streamData, uint32_t
 bool adaptive::CHLSTree::ProcessChildManifest(PLAYLIST::CPeriod* period,
                                               PLAYLIST::CAdaptationSet* adp,
                                               PLAYLIST::CRepresentation* rep,
-                                              uint64_t currentSegNumber)
+                                              uint64_t currentSegNumber,
+                                              UTILS::CURL::HTTPResponse* response /* = nullptr */)
 {
   ParseStatus status = ParseStatus::INVALID;
   size_t maxInvalidStatus = 3;
+  bool isDeltaAllowed{true};
+  // The playlist downloaded by the update thread is not downloaded again on failure,
+  // the update thread will retry it with its own schedule, without lock the tree
+  const bool isRetryAllowed = response == nullptr;
 
-  while (status == ParseStatus::INVALID && maxInvalidStatus > 0)
+  while ((status == ParseStatus::INVALID || status == ParseStatus::DELTA_MISMATCH) &&
+         maxInvalidStatus > 0)
   {
     UTILS::CURL::HTTPResponse resp;
 
-    if (!DownloadChildManifest(adp, rep, resp))
+    if (response)
+    {
+      resp = std::move(*response);
+      response = nullptr;
+    }
+    else if (!DownloadChildManifest(adp, rep, resp,
+                                    GetDeliveryDirectives(period, adp, rep, false, isDeltaAllowed)))
+    {
       return false;
+    }
 
     status = ParseChildManifest(resp.data, URL::GetUrlPath(resp.effectiveUrl), period, adp, rep);
 
     if (status == ParseStatus::SUCCESS)
     {
+      rep->repLastUpdated_ = std::chrono::system_clock::now();
+      if (rep->m_updateInterval != NO_VALUE)
+      {
+        rep->m_nextUpdate =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(rep->m_updateInterval);
+      }
       PrepareSegments(period, adp, rep, currentSegNumber);
     }
+    else if (status == ParseStatus::DELTA_MISMATCH)
+    {
+      // Request the full playlist
+      isDeltaAllowed = false;
+      maxInvalidStatus--;
+      if (!isRetryAllowed)
+      {
+        // Make the playlist outdated, so that the next update request the full playlist
+        rep->repLastUpdated_ = {};
+        break;
+      }
+    }
     else if (status == ParseStatus::INVALID)
     {
+      if (!isRetryAllowed)
+        break;
+
       // Give the provider a minimum amount of time before trying to download it again
       std::this_thread::sleep_for(std::chrono::seconds(1));
       maxInvalidStatus--;
@@ -466,6 +570,15 @@ bool adaptive::CHLSTree::ProcessChildManifest(PLAYLIST::CPeriod* period,
   CSegContainer newSegments;
   std::optional<CSegment> newSegment;
 
+  // Low latency partial segments, the parts are listed before the segment they belong to
+  std::vector<CSegmentPart> newParts;
+  uint32_t newGapPartsCount{0};
+  uint64_t nextPartRangeBegin{0}; // Byte range start of a part without the offset value
+  uint64_t partTarget{NO_VALUE}; // EXT-X-PART-INF PART-TARGET in ms
+  uint64_t partHoldBack{NO_VALUE}; // EXT-X-SERVER-CONTROL PART-HOLD-BACK in ms
+  uint64_t targetDuration{NO_VALUE}; // EXT-X-TARGETDURATION in ms
+  bool hasParts{false};
+
   // Pssh set used between segments
   uint16_t psshSetPos = PSSHSET_POS_DEFAULT;
 
@@ -600,12 +713,102 @@ bool adaptive::CHLSTree::ProcessChildManifest(PLAYLIST::CPeriod* period,
     }
     else if (tagName == "#EXT-X-TARGETDURATION")
     {
-      // Use segment max duration as interval time to do a manifest update
-      // see: Reloading the Media Playlist file
-      // https://datatracker.ietf.org/doc/html/draft-pantos-http-live-streaming-16#section-6.3.4
-      uint64_t newInterval = STRING::ToUint64(tagValue) * 1000;
-      if (newInterval < m_updateInterval)
-        m_updateInterval = newInterval;
+      targetDuration = STRING::ToUint64(tagValue) * 1000;
+    }
+    else if (tagName == "#EXT-X-SERVER-CONTROL")
+    {
+      auto attribs = ParseTagAttributes(tagValue);
+      if (STRING::KeyExists(attribs, "PART-HOLD-BACK"))
+        partHoldBack = static_cast<uint64_t>(STRING::ToFloat(attribs["PART-HOLD-BACK"]) * 1000);
+
+      m_canBlockReload = attribs["CAN-BLOCK-RELOAD"] == "YES";
+      m_canSkipUntil = static_cast<uint64_t>(STRING::ToFloat(attribs["CAN-SKIP-UNTIL"]) * 1000);
+    }
+    else if (tagName == "#EXT-X-SKIP" && !isSkipUntilDiscont)
+    {
+      // Delta update, the oldest segments are skipped, copy them from the current timeline
+      auto attribs = ParseTagAttributes(tagValue);
+      const uint64_t skippedSegments = STRING::ToUint64(attribs["SKIPPED-SEGMENTS"]);
+      const uint64_t startNumber = rep->GetStartNumber();
+      const CSegContainer& timeline = rep->Timeline();
+
+      const uint64_t firstPos = currentSegNumber - startNumber;
+
+      // The skipped segments must be found on the current timeline
+      if (skippedSegments == 0 || currentSegNumber < startNumber ||
+          firstPos + skippedSegments > timeline.GetSize() ||
+          timeline.Get(static_cast<size_t>(firstPos))->m_number != currentSegNumber ||
+          timeline.Get(static_cast<size_t>(firstPos + skippedSegments - 1))->m_number !=
+              currentSegNumber + skippedSegments - 1)
+      {
+        LOG::Log(LOGDEBUG, "Cannot merge the playlist delta update, skipped segments not found");
+        return ParseStatus::DELTA_MISMATCH;
+      }
+
+      for (uint64_t pos = firstPos; pos < firstPos + skippedSegments; ++pos)
+      {
+        const CSegment* segment = timeline.Get(static_cast<size_t>(pos));
+        newSegments.Add(*segment);
+        // The PSSH set usage is decreased when the current segments are freed
+        period->IncreasePSSHSetUsageCount(segment->pssh_set_);
+      }
+      currentSegNumber += skippedSegments;
+    }
+    else if (tagName == "#EXT-X-PART-INF")
+    {
+      auto attribs = ParseTagAttributes(tagValue);
+      if (STRING::KeyExists(attribs, "PART-TARGET"))
+        partTarget = static_cast<uint64_t>(STRING::ToFloat(attribs["PART-TARGET"]) * 1000);
+    }
+    else if (tagName == "#EXT-X-PART" && !isSkipUntilDiscont)
+    {
+      auto attribs = ParseTagAttributes(tagValue);
+      CSegmentPart part;
+      part.m_url = attribs["URI"];
+      part.m_duration = static_cast<uint64_t>(STRING::ToFloat(attribs["DURATION"]) * 1000);
+      part.m_isIndependent = attribs["INDEPENDENT"] == "YES";
+
+      if (STRING::KeyExists(attribs, "BYTERANGE") &&
+          ParseRangeValues(attribs["BYTERANGE"], part.m_rangeEnd, part.m_rangeBegin))
+      {
+        // Without offset, the range follows the one of the previous part of the same resource
+        if (part.m_rangeBegin == NO_VALUE)
+          part.m_rangeBegin = nextPartRangeBegin;
+        part.m_rangeEnd += part.m_rangeBegin - 1;
+        nextPartRangeBegin = part.m_rangeEnd + 1;
+      }
+      else
+      {
+        part.m_rangeEnd = NO_VALUE;
+        nextPartRangeBegin = 0;
+      }
+
+      // A part marked as gap is not available, it cannot be downloaded
+      if (attribs["GAP"] == "YES")
+        newGapPartsCount++;
+      else if (!part.m_url.empty())
+        newParts.emplace_back(part);
+    }
+    else if (tagName == "#EXT-X-PRELOAD-HINT" && !isSkipUntilDiscont)
+    {
+      // Only the hint of the next part is used, a part hint can be requested
+      // in advance and the server send it when its produced
+      auto attribs = ParseTagAttributes(tagValue);
+      if (attribs["TYPE"] == "PART" && STRING::KeyExists(attribs, "URI"))
+      {
+        CSegmentPart part;
+        part.m_url = attribs["URI"];
+        part.m_isPreloadHint = true;
+
+        if (STRING::KeyExists(attribs, "BYTERANGE-START") ||
+            STRING::KeyExists(attribs, "BYTERANGE-LENGTH"))
+        {
+          part.m_rangeBegin = STRING::ToUint64(attribs["BYTERANGE-START"]);
+          if (STRING::KeyExists(attribs, "BYTERANGE-LENGTH"))
+            part.m_rangeEnd = part.m_rangeBegin + STRING::ToUint64(attribs["BYTERANGE-LENGTH"]) - 1;
+        }
+        newParts.emplace_back(part);
+      }
     }
     else if (tagName == "#EXTINF" && !isSkipUntilDiscont)
     {
@@ -713,6 +916,17 @@ bool adaptive::CHLSTree::ProcessChildManifest(PLAYLIST::CPeriod* period,
       }
       newSegment->pssh_set_ = psshSetPos;
 
+      // The parts of AES-128 encrypted segments are not supported, the decrypter
+      // needs the data of the whole segment, so they are downloaded as before
+      if (!newParts.empty() && currentEncryptionType != EncryptionType::AES128)
+      {
+        newSegment->m_parts = std::move(newParts);
+        newSegment->m_gapPartsCount = newGapPartsCount;
+        hasParts = true;
+      }
+      newParts.clear();
+      newGapPartsCount = 0;
+
       newSegments.Add(*newSegment);
       newSegment.reset();
     }
@@ -876,6 +1090,57 @@ bool adaptive::CHLSTree::ProcessChildManifest(PLAYLIST::CPeriod* period,
     }
   }
 
+  // The parts that follow the last segment belong to the segment in production,
+  // add it as partial segment, so it can be downloaded while it is produced
+  if (m_isLive && !newParts.empty() && !newSegments.IsEmpty() && !isSkipUntilDiscont &&
+      currentEncryptionType != EncryptionType::AES128 &&
+      rep->GetContainerType() != ContainerType::INVALID)
+  {
+    CSegment partialSegment;
+    partialSegment.m_isPartial = true;
+    partialSegment.startPTS_ = newSegments.GetBack()->m_endPts;
+    partialSegment.m_endPts = partialSegment.startPTS_;
+    for (const CSegmentPart& part : newParts)
+    {
+      partialSegment.m_endPts += part.m_duration;
+    }
+    partialSegment.m_number = currentSegNumber;
+    partialSegment.pssh_set_ = psshSetPos;
+    partialSegment.m_parts = std::move(newParts);
+    partialSegment.m_gapPartsCount = newGapPartsCount;
+    newSegments.Add(partialSegment);
+    hasParts = true;
+  }
+
+  if (m_isLive)
+  {
+    // Use segment max duration as interval time to do a manifest update
+    // see: Reloading the Media Playlist file
+    // https://datatracker.ietf.org/doc/html/draft-pantos-http-live-streaming-16#section-6.3.4
+    uint64_t playlistInterval = targetDuration;
+
+    if (hasParts && partTarget != NO_VALUE)
+    {
+      // Reload the playlist at each part, to get the new parts as soon as they are listed
+      m_partDuration = partTarget;
+      playlistInterval = partTarget;
+
+      // PART-HOLD-BACK must be at least two times the part target, three times is recommended
+      m_lowLatencyDelay = partHoldBack != NO_VALUE ? partHoldBack : partTarget * 3;
+    }
+
+    // The server hold the reload request until the next segment (or part) is available,
+    // so the reload can be requested in advance to get the update as soon as possible
+    if (m_canBlockReload && playlistInterval != NO_VALUE && playlistInterval / 2 > 0)
+      playlistInterval /= 2;
+
+    // Each playlist is refreshed with its own schedule, the update thread
+    // is woken up by the shortest interval
+    rep->m_updateInterval = playlistInterval;
+    if (playlistInterval < m_updateInterval)
+      m_updateInterval = playlistInterval;
+  }
+
   if (m_isLive && m_updateInterval == NO_VALUE)
     m_updateInterval = 0; // Refresh at each segment
 
@@ -1103,45 +1368,126 @@ bool adaptive::CHLSTree::DownloadManifestChild(std::string_view url,
   return CURL::DownloadFile(url, reqHeaders, respHeaders, resp);
 }
 
-//! @todo: check updated variables that are not thread safe
-void adaptive::CHLSTree::OnUpdateSegments()
+void adaptive::CHLSTree::OnPrepareUpdateSegments()
 {
-  lastUpdated_ = std::chrono::system_clock::now();
+  m_playlistUpdates.clear();
+  {
+    std::lock_guard<TreeUpdateThread> lckUpdTree(GetTreeUpdMutex());
+    const auto now = std::chrono::steady_clock::now();
+
+    for (auto& adpSet : m_currentPeriod->GetAdaptationSets())
+    {
+      for (auto& repr : adpSet->GetRepresentations())
+      {
+        // Refresh only the playlists where their own schedule is expired
+        if (!repr->IsEnabled() || repr->m_nextUpdate > now)
+          continue;
+
+        PlaylistUpdate& update = m_playlistUpdates.emplace_back();
+        update.m_period = m_currentPeriod;
+        update.m_adpSet = adpSet.get();
+        update.m_repr = repr.get();
+        update.m_reprLastUpdated = repr->repLastUpdated_;
+        update.m_directives =
+            GetDeliveryDirectives(m_currentPeriod, adpSet.get(), repr.get(), true, true);
+      }
+    }
+  }
 
-  std::vector<std::tuple<CAdaptationSet*, CRepresentation*>> refreshList;
+  // With blocking reload the server can hold the requests up to a segment duration,
+  // so the playlists are downloaded without lock the tree, and concurrently,
+  // so that a slow playlist does not delay the update of the others
+  auto downloadPlaylist = [this](PlaylistUpdate& update)
+  {
+    update.m_isDownloaded = DownloadChildManifest(update.m_adpSet, update.m_repr,
+                                                  update.m_response, update.m_directives);
+  };
 
-  for (auto& adpSet : m_currentPeriod->GetAdaptationSets())
+  if (m_playlistUpdates.size() == 1)
   {
-    for (auto& repr : adpSet->GetRepresentations())
+    downloadPlaylist(m_playlistUpdates.front());
+  }
+  else if (m_playlistUpdates.size() > 1)
+  {
+    if (!m_playlistUpdatePool)
+      m_playlistUpdatePool = std::make_unique<CThreadPool>(MAX_CONCURRENT_PLAYLIST_UPDATES);
+
+    std::vector<std::future<void>> results;
+    for (PlaylistUpdate& update : m_playlistUpdates)
     {
-      if (repr->IsEnabled())
-        refreshList.emplace_back(adpSet.get(), repr.get());
+      results.emplace_back(
+          m_playlistUpdatePool->Submit([&downloadPlaylist, &update] { downloadPlaylist(update); }));
+    }
+    for (std::future<void>& result : results)
+    {
+      result.wait();
     }
   }
+}
 
-  bool isInvalidUpdate = false;
+//! @todo: check updated variables that are not thread safe
+void adaptive::CHLSTree::OnUpdateSegments()
+{
+  lastUpdated_ = std::chrono::system_clock::now();
 
-  for (auto& [adpSet, repr] : refreshList)
+  for (PlaylistUpdate& update : m_playlistUpdates)
   {
+    // The period could be changed, or the stream disabled, while the playlist was downloaded
+    if (update.m_period != m_currentPeriod || !update.m_repr->IsEnabled())
+      continue;
+
+    // The playlist could be refreshed while the updates were paused (e.g. by OnRequestSegments
+    // on a seek), then the downloaded one is older and must not be applied
+    if (update.m_repr->repLastUpdated_ != update.m_reprLastUpdated)
+    {
+      LOG::Log(LOGDEBUG, "Playlist update discarded, refreshed in the meantime (repr. id \"%s\")",
+               update.m_repr->GetId().data());
+      continue;
+    }
+
     // Save the current segment position before parsing the manifest
     // to allow find the right segment on updated playlist segments
-    const uint64_t segNumber = repr->GetCurrentSegNumber();
+    const uint64_t segNumber = update.m_repr->GetCurrentSegNumber();
 
-    if (!ProcessChildManifest(m_currentPeriod, adpSet, repr, segNumber))
+    if (!update.m_isDownloaded ||
+        !ProcessChildManifest(m_currentPeriod, update.m_adpSet, update.m_repr, segNumber,
+                              &update.m_response))
     {
-      isInvalidUpdate = true;
+      // Faulty live services could send malformed manifest updates
+      // so avoid requesting updates too quickly but you also need to make sure
+      // that we have segments to mitigate a buffering problem
+      // so try again the playlist update at the half of its interval time
+      const uint64_t retryInterval =
+          update.m_repr->m_updateInterval != NO_VALUE ? update.m_repr->m_updateInterval / 2 : 0;
+      update.m_repr->m_nextUpdate =
+          std::chrono::steady_clock::now() + std::chrono::milliseconds(retryInterval);
+    }
+  }
+  m_playlistUpdates.clear();
+
+  // Wake up the update thread when the first playlist need to be refreshed
+  std::optional<std::chrono::steady_clock::time_point> nextUpdate;
+
+  for (auto& adpSet : m_currentPeriod->GetAdaptationSets())
+  {
+    for (auto& repr : adpSet->GetRepresentations())
+    {
+      if (repr->IsEnabled() && repr->m_updateInterval != NO_VALUE &&
+          (!nextUpdate.has_value() || repr->m_nextUpdate < *nextUpdate))
+      {
+        nextUpdate = repr->m_nextUpdate;
+      }
     }
   }
 
-  if (isInvalidUpdate)
+  // The wake up delay is kept apart, m_updateInterval must remain the min playlist interval
+  m_nextUpdateDelay = NO_VALUE;
+  if (nextUpdate.has_value() && m_updateInterval != NO_VALUE && m_updateInterval > 0)
   {
-    // Faulty live services could send malformed manifest updates
-    // so avoid requesting updates too quickly but you also need to make sure
-    // that we have segments to mitigate a buffering problem
-    // so try halve the interval time in a temporary way
-    m_updateInterval = m_updateInterval / 2;
-    // Reset the interval on the next update, to restore the original value
-    m_updThread.ResetInterval();
+    const auto interval = std::chrono::duration_cast<std::chrono::milliseconds>(
+        *nextUpdate - std::chrono::steady_clock::now());
+    m_nextUpdateDelay = std::max(static_cast<uint64_t>(std::max(interval.count(), int64_t{0})),
+                                 MIN_PLAYLIST_UPDATE_INTERVAL);
   }
 }
 
@@ -12,6 +12,9 @@
 #include "common/AdaptiveTree.h"
 #include "common/AdaptiveUtils.h"
 #include "utils/CurlUtils.h"
+#include "utils/ThreadPool.h"
+
+#include <memory>
 
 namespace adaptive
 {
@@ -24,6 +27,7 @@ public:
     SUCCESS,
     ERROR,
     INVALID, // Invalid manifest e.g. without segments
+    DELTA_MISMATCH, // Delta update that cannot be merged to the current segments
   };
 
   CHLSTree();
@@ -127,7 +131,27 @@ protected:
 
   bool DownloadChildManifest(PLAYLIST::CAdaptationSet* adp,
                              PLAYLIST::CRepresentation* rep,
-                             UTILS::CURL::HTTPResponse& resp);
+                             UTILS::CURL::HTTPResponse& resp,
+                             std::string_view deliveryDirectives = "");
+
+  /*!
+   * \brief Get the delivery directives to request a live playlist update,
+   *        as supported by the server (EXT-X-SERVER-CONTROL tag). With blocking reload
+   *        the server hold the request until the segment (or part) that follow the last
+   *        one is available, with delta update the oldest segments are skipped.
+   * \param period The period
+   * \param adp The adaptation set
+   * \param rep The representation
+   * \param isBlockingAllowed Set true to request a blocking reload, can block the request up
+   *                          to a segment duration, so it must be used by the update thread only
+   * \param isDeltaAllowed Set true to request a delta update, false for the full playlist
+   * \return The query string parameters, or empty string if not supported
+   */
+  std::string GetDeliveryDirectives(PLAYLIST::CPeriod* period,
+                                    PLAYLIST::CAdaptationSet* adp,
+                                    PLAYLIST::CRepresentation* rep,
+                                    bool isBlockingAllowed,
+                                    bool isDeltaAllowed) const;
 
   /*
    * \brief Check for inconsistent EXT-X-MEDIA-SEQUENCE value on manifest update,
@@ -149,10 +173,21 @@ protected:
    */
   void FixDiscSequence(std::stringstream& streamData, uint32_t& discSeqNumber);
 
+  /*!
+   * \brief Download and parse a media playlist, then align the current segment.
+   * \param period The period
+   * \param adp The adaptation set
+   * \param rep The representation
+   * \param currentSegNumber The number of the current segment to be aligned
+   * \param response [OPT] The playlist already downloaded, it will be downloaded again
+   *                 only if it cannot be parsed
+   * \return True if success, otherwise false
+   */
   bool ProcessChildManifest(PLAYLIST::CPeriod* period,
                             PLAYLIST::CAdaptationSet* adp,
                             PLAYLIST::CRepresentation* rep,
-                            uint64_t currentSegNumber);
+                            uint64_t currentSegNumber,
+                            UTILS::CURL::HTTPResponse* response = nullptr);
 
   ParseStatus ParseChildManifest(const std::string& data,
                                  std::string_view sourceUrl,
@@ -165,6 +200,7 @@ protected:
                        PLAYLIST::CRepresentation* rep,
                        uint64_t segNumber);
 
+  virtual void OnPrepareUpdateSegments() override;
   virtual void OnUpdateSegments() override;
 
   virtual bool ParseManifest(const std::string& stream);
@@ -237,6 +273,25 @@ private:
   bool m_hasDiscontSeq = false;
   uint32_t m_discontSeq = 0;
 
+  // Playlist delivery features supported by the server, from EXT-X-SERVER-CONTROL
+  bool m_canBlockReload{false};
+  uint64_t m_canSkipUntil{0}; // Skip boundary of delta updates in ms, 0 when not supported
+
+  // Live playlist update, downloaded by OnPrepareUpdateSegments, parsed by OnUpdateSegments
+  struct PlaylistUpdate
+  {
+    PLAYLIST::CPeriod* m_period{nullptr};
+    PLAYLIST::CAdaptationSet* m_adpSet{nullptr};
+    PLAYLIST::CRepresentation* m_repr{nullptr};
+    std::string m_directives;
+    // The last update of the representation when the playlist has been requested
+    std::chrono::time_point<std::chrono::system_clock> m_reprLastUpdated;
+    UTILS::CURL::HTTPResponse m_response;
+    bool m_isDownloaded{false};
+  };
+  std::vector<PlaylistUpdate> m_playlistUpdates; // Accessed by the update thread only
+  std::unique_ptr<UTILS::CThreadPool> m_playlistUpdatePool; // Concurrent playlist downloads
+
   std::vector<uint8_t> m_currentPssh; // Last processed encryption PSSH from URI
   std::string m_currentDefaultKID; // Last processed encryption KID
   std::string m_currentKidUrl; // Last processed encryption KID URI
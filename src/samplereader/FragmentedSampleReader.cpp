@@ -19,10 +19,17 @@
 #include "codechandler/WebVTTCodecHandler.h"
 #include "common/AdaptiveCencSampleDecrypter.h"
 #include "utils/CharArrayParser.h"
+#include "utils/ThreadPool.h"
 #include "utils/Utils.h"
 #include "utils/log.h"
 
+#include <algorithm>
+#include <future>
+#include <limits>
+
+#include <bento4/Ap4SbgpAtom.h>
 #include <bento4/Ap4SencAtom.h>
+#include <bento4/Ap4SgpdAtom.h>
 
 using namespace UTILS;
 
@@ -30,8 +37,187 @@ namespace
 {
 constexpr uint8_t MP4_TFRFBOX_UUID[] = {0xd4, 0x80, 0x7e, 0xf2, 0xca, 0x39, 0x46, 0x95,
                                         0x8e, 0x54, 0x26, 0xcb, 0x9e, 0x46, 0xa7, 0x9f};
+
+// Max number of samples that can be read and decrypted ahead
+constexpr size_t DECRYPT_AHEAD_MAX_SAMPLES = 64;
+
+constexpr AP4_UI32 GROUPING_TYPE_SEIG = AP4_ATOM_TYPE('s', 'e', 'i', 'g');
+// The group description indexes greater than this value refer to the entries
+// of the track fragment, otherwise to the entries of the track sample table
+constexpr AP4_UI32 SBGP_FRAGMENT_LOCAL_INDEX = 0x10000;
+
+AP4_SgpdAtom* FindSeigSgpd(AP4_ContainerAtom* container)
+{
+  AP4_Atom* atom{nullptr};
+  unsigned int atomPos{0};
+
+  while ((atom = container->GetChild(AP4_ATOM_TYPE_SGPD, atomPos++)) != nullptr)
+  {
+    AP4_SgpdAtom* sgpd{AP4_DYNAMIC_CAST(AP4_SgpdAtom, atom)};
+    if (sgpd && sgpd->GetGroupingType() == GROUPING_TYPE_SEIG)
+      return sgpd;
+  }
+  return nullptr;
+}
+
+AP4_SbgpAtom* FindSeigSbgp(AP4_ContainerAtom* traf)
+{
+  AP4_Atom* atom{nullptr};
+  unsigned int atomPos{0};
+
+  while ((atom = traf->GetChild(AP4_ATOM_TYPE_SBGP, atomPos++)) != nullptr)
+  {
+    AP4_SbgpAtom* sbgp{AP4_DYNAMIC_CAST(AP4_SbgpAtom, atom)};
+    if (sbgp && sbgp->GetGroupingType() == GROUPING_TYPE_SEIG)
+      return sbgp;
+  }
+  return nullptr;
+}
+
+/*!
+ * \brief Get the KID of an entry of a "seig" sample group description.
+ * \param sgpd The "seig" sample group description atom, can be nullptr
+ * \param index The entry index, 0-based
+ * \param keyId[OUT] The KID found
+ * \return True if the entry exists and the samples are protected, otherwise false
+ */
+bool GetSeigEntryKeyId(AP4_SgpdAtom* sgpd, AP4_UI32 index, std::vector<uint8_t>& keyId)
+{
+  if (!sgpd)
+    return false;
+
+  AP4_List<AP4_DataBuffer>::Item* entry{sgpd->GetEntries().FirstItem()};
+  for (; entry && index > 0; --index)
+  {
+    entry = entry->GetNext();
+  }
+  if (!entry)
+    return false;
+
+  // CencSampleEncryptionInformationGroupEntry: reserved (8 bits), crypt/skip blocks (8 bits),
+  // isProtected (8 bits), Per_Sample_IV_Size (8 bits), KID (16 bytes), ...
+  const AP4_DataBuffer* data{entry->GetData()};
+  if (data->GetDataSize() < 20 || data->GetData()[2] == 0)
+    return false;
+
+  keyId.assign(data->GetData() + 4, data->GetData() + 20);
+  return true;
+}
+
+/*!
+ * \brief Get the track ids of the track fragments contained in a moof atom.
+ *        Unlike AP4_MovieFragment::GetTrackIds, does not require a copy of the moof atom.
+ * \param moof The movie fragment atom
+ * \param ids [OUT] The track ids
+ */
+void GetMoofTrackIds(AP4_ContainerAtom* moof, AP4_Array<AP4_UI32>& ids)
+{
+  AP4_Atom* atom{nullptr};
+  unsigned int atomPos{0};
+
+  while ((atom = moof->GetChild(AP4_ATOM_TYPE_TRAF, atomPos++)) != nullptr)
+  {
+    AP4_ContainerAtom* traf{AP4_DYNAMIC_CAST(AP4_ContainerAtom, atom)};
+    if (!traf)
+      continue;
+
+    AP4_TfhdAtom* tfhd{AP4_DYNAMIC_CAST(AP4_TfhdAtom, traf->GetChild(AP4_ATOM_TYPE_TFHD, 0))};
+    if (tfhd)
+      ids.Append(tfhd->GetTrackId());
+  }
+}
 } // unnamed namespace
 
+void CFragmentedSampleReader::GetSeigKeyIds(AP4_ContainerAtom* traf)
+{
+  m_keyIdRuns.clear();
+
+  AP4_SgpdAtom* trafSgpd = FindSeigSgpd(traf);
+  AP4_SbgpAtom* sbgp = FindSeigSbgp(traf);
+
+  if (!sbgp)
+  {
+    // No sample mapping, assume that all samples use the first group description
+    std::vector<uint8_t> keyId;
+    if (GetSeigEntryKeyId(trafSgpd, 0, keyId))
+      m_keyIdRuns.push_back({std::numeric_limits<AP4_UI32>::max(), keyId});
+    return;
+  }
+
+  AP4_SgpdAtom* stblSgpd{nullptr};
+  bool isStblSgpdSearched{false};
+
+  const AP4_Array<AP4_SbgpAtom::Entry>& entries = sbgp->GetEntries();
+  for (AP4_Cardinal i = 0; i < entries.ItemCount(); ++i)
+  {
+    const AP4_UI32 index = entries[i].group_description_index;
+    std::vector<uint8_t> keyId;
+
+    if (index > SBGP_FRAGMENT_LOCAL_INDEX)
+    {
+      GetSeigEntryKeyId(trafSgpd, index - SBGP_FRAGMENT_LOCAL_INDEX - 1, keyId);
+    }
+    else if (index > 0)
+    {
+      if (!isStblSgpdSearched)
+      {
+        isStblSgpdSearched = true;
+        AP4_ContainerAtom* stbl = AP4_DYNAMIC_CAST(
+            AP4_ContainerAtom, m_track->GetTrakAtom()->FindChild("mdia/minf/stbl"));
+        if (stbl)
+          stblSgpd = FindSeigSgpd(stbl);
+      }
+      GetSeigEntryKeyId(stblSgpd, index - 1, keyId);
+    }
+    // The samples not in a group (index 0) or without KID use the default KID
+    if (keyId.empty())
+      keyId = m_defaultKey;
+
+    if (!m_keyIdRuns.empty() && m_keyIdRuns.back().m_keyId == keyId)
+      m_keyIdRuns.back().m_sampleCount += entries[i].sample_count;
+    else
+      m_keyIdRuns.push_back({entries[i].sample_count, keyId});
+  }
+}
+
+void CFragmentedSampleReader::UpdateSampleKeyId()
+{
+  Tracker* tracker = FindTracker(m_track->GetId());
+  if (!tracker || tracker->m_NextSampleIndex == 0)
+    return;
+
+  // The sample just read
+  AP4_Ordinal sampleIndex = tracker->m_NextSampleIndex - 1;
+
+  const std::vector<uint8_t>* keyId{&m_defaultKey};
+  for (const KeyIdRun& run : m_keyIdRuns)
+  {
+    if (sampleIndex < run.m_sampleCount)
+    {
+      keyId = &run.m_keyId;
+      break;
+    }
+    sampleIndex -= run.m_sampleCount;
+  }
+
+  if (*keyId != m_fragmentInfoKey)
+  {
+    m_singleSampleDecryptor->SetFragmentInfo(m_poolId, *keyId, m_codecHandler->m_naluLengthSize,
+                                             m_codecHandler->m_extraData, m_decrypterCaps.flags,
+                                             m_readerCryptoInfo);
+    m_fragmentInfoKey = *keyId;
+  }
+}
+
+struct DecryptAheadSample
+{
+  AP4_Sample m_sample;
+  AP4_DataBuffer m_encrypted;
+  AP4_DataBuffer m_decrypted;
+  CencSampleCryptoData m_cryptoData;
+  std::future<AP4_Result> m_result;
+};
+
 
 CFragmentedSampleReader::CFragmentedSampleReader(AP4_ByteStream* input,
                                                  AP4_Movie* movie,
@@ -45,9 +231,10 @@ CFragmentedSampleReader::CFragmentedSampleReader(AP4_ByteStream* input,
 
 CFragmentedSampleReader::~CFragmentedSampleReader()
 {
+  ClearDecryptAhead();
   if (m_singleSampleDecryptor)
     m_singleSampleDecryptor->RemovePool(m_poolId);
-  delete m_decrypter;
+  delete m_cencDecrypter;
   delete m_codecHandler;
 }
 
@@ -76,6 +263,7 @@ bool CFragmentedSampleReader::Initialize(SESSION::CStream* stream)
       }
     }
   }
+  m_fragmentKey = m_defaultKey;
 
   m_timeBaseExt = STREAM_TIME_BASE;
   m_timeBaseInt = m_track->GetMediaTimeScale();
@@ -138,9 +326,15 @@ AP4_Result CFragmentedSampleReader::ReadSample()
         m_protectedDesc &&
         (m_decrypterCaps.flags & DRM::DecrypterCapabilites::SSD_SECURE_PATH) != 0;
     bool decrypterPresent{m_decrypter != nullptr};
-    if (AP4_FAILED(result = ReadNextSample(m_track->GetId(), m_sample,
-                                           (m_decrypter || useDecryptingDecoder) ? m_encrypted
-                                                                                 : m_sampleData)))
+    if (!m_decryptAheadSamples.empty())
+    {
+      // The sample has been already read and its decryption is in progress
+      result = GetDecryptedAheadSample();
+    }
+    else if (AP4_FAILED(result = ReadNextSample(m_track->GetId(), m_sample,
+                                                (m_decrypter || useDecryptingDecoder)
+                                                    ? m_encrypted
+                                                    : m_sampleData)))
     {
       if (result == AP4_ERROR_EOS)
       {
@@ -164,21 +358,40 @@ AP4_Result CFragmentedSampleReader::ReadSample()
       }
       return result;
     }
+    else
+    {
+      //Protection could have changed in ProcessMoof
+      if (!decrypterPresent && m_decrypter != nullptr && !useDecryptingDecoder)
+        m_encrypted.SetData(m_sampleData.GetData(), m_sampleData.GetDataSize());
+      else if (decrypterPresent && m_decrypter == nullptr && !useDecryptingDecoder)
+        m_sampleData.SetData(m_encrypted.GetData(), m_encrypted.GetDataSize());
+
+      // The samples of the fragment are encrypted with different keys
+      if (m_keyIdRuns.size() > 1 && m_singleSampleDecryptor && m_codecHandler &&
+          (m_decrypter || useDecryptingDecoder))
+      {
+        UpdateSampleKeyId();
+      }
 
-    //AP4_AvcSequenceParameterSet sps;
-    //AP4_AvcFrameParser::ParseFrameForSPS(m_sampleData.GetData(), m_sampleData.GetDataSize(), 4, sps);
+      if (m_decrypter)
+      {
+        m_sampleData.Reserve(m_encrypted.GetDataSize());
+        result = m_decrypter->DecryptSampleData(m_poolId, m_encrypted, m_sampleData, NULL);
 
-    //Protection could have changed in ProcessMoof
-    if (!decrypterPresent && m_decrypter != nullptr && !useDecryptingDecoder)
-      m_encrypted.SetData(m_sampleData.GetData(), m_sampleData.GetDataSize());
-    else if (decrypterPresent && m_decrypter == nullptr && !useDecryptingDecoder)
-      m_sampleData.SetData(m_encrypted.GetData(), m_encrypted.GetDataSize());
+        if (AP4_SUCCEEDED(result) && CanDecryptAhead())
+          DecryptAhead();
+      }
+      else if (useDecryptingDecoder)
+      {
+        m_sampleData.Reserve(m_encrypted.GetDataSize());
+        m_singleSampleDecryptor->DecryptSampleData(m_poolId, m_encrypted, m_sampleData, nullptr,
+                                                   0, nullptr, nullptr);
+      }
+    }
 
     if (m_decrypter)
     {
-      m_sampleData.Reserve(m_encrypted.GetDataSize());
-      if (AP4_FAILED(result =
-                         m_decrypter->DecryptSampleData(m_poolId, m_encrypted, m_sampleData, NULL)))
+      if (AP4_FAILED(result))
       {
         LOG::Log(LOGERROR, "Decrypt Sample returns failure!");
         if (++m_failCount > 50)
@@ -196,12 +409,6 @@ AP4_Result CFragmentedSampleReader::ReadSample()
         m_failCount = 0;
       }
     }
-    else if (useDecryptingDecoder)
-    {
-      m_sampleData.Reserve(m_encrypted.GetDataSize());
-      m_singleSampleDecryptor->DecryptSampleData(m_poolId, m_encrypted, m_sampleData, nullptr, 0,
-                                                 nullptr, nullptr);
-    }
 
     if (m_codecHandler->Transform(m_sample.GetDts(), m_sample.GetDuration(), m_sampleData,
                                   m_track->GetMediaTimeScale()))
@@ -220,6 +427,7 @@ AP4_Result CFragmentedSampleReader::ReadSample()
 
 void CFragmentedSampleReader::Reset(bool bEOS)
 {
+  ClearDecryptAhead();
   AP4_LinearReader::Reset();
   m_eos = bEOS;
   if (m_codecHandler)
@@ -263,6 +471,11 @@ bool CFragmentedSampleReader::TimeSeek(uint64_t pts, bool preceeding)
 {
   AP4_Ordinal sampleIndex;
   AP4_UI64 seekPos(static_cast<AP4_UI64>((pts * m_timeBaseInt) / m_timeBaseExt));
+
+  // The samples read ahead must be discarded,
+  // the seek also moves back the sample cursor of the decrypter
+  ClearDecryptAhead();
+
   if (AP4_SUCCEEDED(SeekSample(m_track->GetId(), seekPos, sampleIndex, preceeding)))
   {
     if (m_decrypter)
@@ -305,10 +518,8 @@ AP4_Result CFragmentedSampleReader::ProcessMoof(AP4_ContainerAtom* moof,
                                                 AP4_Position mdat_payload_offset,
                                                 AP4_UI64 mdat_payload_size)
 {
-  AP4_MovieFragment fragment =
-      AP4_MovieFragment(AP4_DYNAMIC_CAST(AP4_ContainerAtom, moof->Clone()));
   AP4_Array<AP4_UI32> ids;
-  fragment.GetTrackIds(ids);
+  GetMoofTrackIds(moof, ids);
   if (ids.ItemCount() == 1)
   {
     // For prefixed initialization (usually ISM) we don't yet know the
@@ -379,8 +590,7 @@ AP4_Result CFragmentedSampleReader::ProcessMoof(AP4_ContainerAtom* moof,
       AP4_CencSampleInfoTable* sample_table{nullptr};
       AP4_UI32 algorithm_id = 0;
 
-      delete m_decrypter;
-      m_decrypter = 0;
+      m_decrypter = nullptr;
 
       AP4_ContainerAtom* traf =
           AP4_DYNAMIC_CAST(AP4_ContainerAtom, moof->GetChild(AP4_ATOM_TYPE_TRAF, 0));
@@ -388,6 +598,10 @@ AP4_Result CFragmentedSampleReader::ProcessMoof(AP4_ContainerAtom* moof,
       if (!m_protectedDesc || !traf)
         return AP4_ERROR_INVALID_FORMAT;
 
+      // The fragment can be encrypted with a different key than the default one (key rotation)
+      GetSeigKeyIds(traf);
+      m_fragmentKey = m_keyIdRuns.empty() ? m_defaultKey : m_keyIdRuns.front().m_keyId;
+
       // If the boxes saiz, saio, senc are missing, the stream does not conform to the specs and
       // may not be decrypted, so try create an empty senc where all samples will use the same default IV
       if (!traf->GetChild(AP4_ATOM_TYPE_SAIO) && !traf->GetChild(AP4_ATOM_TYPE_SAIZ) &&
@@ -404,9 +618,18 @@ AP4_Result CFragmentedSampleReader::ProcessMoof(AP4_ContainerAtom* moof,
         goto SUCCESS;
 
       if (!m_singleSampleDecryptor)
+      {
+        delete sample_table;
         return AP4_ERROR_INVALID_PARAMETERS;
+      }
+
+      // Reuse the decrypter of the previous fragments, only the sample info table changes
+      if (m_cencDecrypter)
+        m_cencDecrypter->SetSampleInfoTable(sample_table);
+      else
+        m_cencDecrypter = new CAdaptiveCencSampleDecrypter(m_singleSampleDecryptor, sample_table);
 
-      m_decrypter = new CAdaptiveCencSampleDecrypter(m_singleSampleDecryptor, sample_table);
+      m_decrypter = m_cencDecrypter;
 
       // Inform decrypter of pattern decryption (CBCS)
       AP4_UI32 schemeType = m_protectedDesc->GetSchemeType();
@@ -433,9 +656,24 @@ AP4_Result CFragmentedSampleReader::ProcessMoof(AP4_ContainerAtom* moof,
 SUCCESS:
   if (m_singleSampleDecryptor && m_codecHandler)
   {
-     m_singleSampleDecryptor->SetFragmentInfo(
-        m_poolId, m_defaultKey, m_codecHandler->m_naluLengthSize, m_codecHandler->m_extraData,
-        m_decrypterCaps.flags, m_readerCryptoInfo);
+    // With the secure path the decrypter consumes the extradata on each fragment,
+    // otherwise the fragment info must be updated only when changed
+    const bool isSecurePath =
+        (m_decrypterCaps.flags & DRM::DecrypterCapabilites::SSD_SECURE_PATH) != 0;
+
+    if (!m_isFragmentInfoSet || isSecurePath || m_fragmentKey != m_fragmentInfoKey ||
+        m_readerCryptoInfo.m_mode != m_fragmentInfoCrypto.m_mode ||
+        m_readerCryptoInfo.m_cryptBlocks != m_fragmentInfoCrypto.m_cryptBlocks ||
+        m_readerCryptoInfo.m_skipBlocks != m_fragmentInfoCrypto.m_skipBlocks)
+    {
+      m_singleSampleDecryptor->SetFragmentInfo(
+          m_poolId, m_fragmentKey, m_codecHandler->m_naluLengthSize, m_codecHandler->m_extraData,
+          m_decrypterCaps.flags, m_readerCryptoInfo);
+
+      m_isFragmentInfoSet = true;
+      m_fragmentInfoKey = m_fragmentKey;
+      m_fragmentInfoCrypto = m_readerCryptoInfo;
+    }
   }
   return AP4_SUCCESS;
 }
@@ -448,6 +686,8 @@ void CFragmentedSampleReader::UpdateSampleDescription()
     m_codecHandler = nullptr;
   }
   m_bSampleDescChanged = true;
+  // The NALU length size and the extradata can be changed
+  m_isFragmentInfoSet = false;
 
   AP4_SampleDescription* desc = m_track->GetSampleDescription(m_sampleDescIndex - 1);
   if (!desc)
@@ -551,3 +791,91 @@ void CFragmentedSampleReader::ParseTrafTfrf(AP4_UuidAtom* uuidAtom)
     m_observer->OnTFRFatom(time, duration, m_track->GetMediaTimeScale());
   }
 }
+
+bool CFragmentedSampleReader::CanDecryptAhead() const
+{
+  return m_decryptAheadPool && m_decrypter && m_keyIdRuns.size() <= 1 &&
+         (m_decrypterCaps.flags & DRM::DecrypterCapabilites::SSD_SECURE_PATH) == 0 &&
+         m_singleSampleDecryptor->IsConcurrentDecryptSupported();
+}
+
+void CFragmentedSampleReader::DecryptAhead()
+{
+  Tracker* tracker = FindTracker(m_track->GetId());
+  if (!tracker || !tracker->m_SampleTable)
+    return;
+
+  // Read only the samples of the current fragment, the next fragment can change the decrypter
+  const AP4_Cardinal sampleCount = tracker->m_SampleTable->GetSampleCount();
+  if (tracker->m_NextSampleIndex >= sampleCount)
+    return;
+
+  auto adByteStream = dynamic_cast<CAdaptiveByteStream*>(m_FragmentStream);
+  if (!adByteStream)
+    return;
+
+  // Read only the samples already downloaded, waiting for the download of the following
+  // samples would delay the current sample, e.g. with low latency chunked segments
+  const AP4_Position availableEnd = adByteStream->GetAvailableEndPosition();
+
+  const size_t samplesToRead =
+      std::min<size_t>(sampleCount - tracker->m_NextSampleIndex, DECRYPT_AHEAD_MAX_SAMPLES);
+
+  for (size_t i = 0; i < samplesToRead; ++i)
+  {
+    AP4_Sample nextSample;
+    if (AP4_FAILED(tracker->m_SampleTable->GetSample(tracker->m_NextSampleIndex, nextSample)) ||
+        nextSample.GetOffset() + nextSample.GetSize() > availableEnd)
+    {
+      break;
+    }
+
+    auto aheadSample = std::make_unique<DecryptAheadSample>();
+
+    if (AP4_FAILED(ReadNextSample(m_track->GetId(), aheadSample->m_sample,
+                                  aheadSample->m_encrypted)) ||
+        AP4_FAILED(m_decrypter->GetNextSampleCryptoData(aheadSample->m_cryptoData)))
+    {
+      break;
+    }
+
+    aheadSample->m_decrypted.Reserve(aheadSample->m_encrypted.GetDataSize());
+
+    DecryptAheadSample* sample = aheadSample.get();
+    CAdaptiveCencSampleDecrypter* decrypter = m_decrypter;
+    const AP4_UI32 poolId = m_poolId;
+    sample->m_result = m_decryptAheadPool->Submit(
+        [sample, decrypter, poolId]
+        {
+          return decrypter->DecryptSampleData(poolId, sample->m_encrypted, sample->m_decrypted,
+                                              sample->m_cryptoData);
+        });
+
+    m_decryptAheadSamples.emplace_back(std::move(aheadSample));
+  }
+}
+
+AP4_Result CFragmentedSampleReader::GetDecryptedAheadSample()
+{
+  std::unique_ptr<DecryptAheadSample> aheadSample = std::move(m_decryptAheadSamples.front());
+  m_decryptAheadSamples.pop_front();
+
+  const AP4_Result result = aheadSample->m_result.get();
+
+  // The encrypted data is no longer needed, only the decrypted data is given to the codec
+  m_sample = aheadSample->m_sample;
+  m_sampleData.SetData(aheadSample->m_decrypted.GetData(),
+                       aheadSample->m_decrypted.GetDataSize());
+  return result;
+}
+
+void CFragmentedSampleReader::ClearDecryptAhead()
+{
+  // The worker threads use the sample buffers, so wait for the decryptions in progress
+  for (std::unique_ptr<DecryptAheadSample>& aheadSample : m_decryptAheadSamples)
+  {
+    if (aheadSample->m_result.valid())
+      aheadSample->m_result.wait();
+  }
+  m_decryptAheadSamples.clear();
+}
@@ -11,9 +11,13 @@
 #include "SampleReader.h"
 #include "decrypters/IDecrypter.h"
 
+#include <deque>
+#include <memory>
+
 // forwards
 class CAdaptiveCencSampleDecrypter;
 class CodecHandler;
+struct DecryptAheadSample;
 
 class ATTR_DLL_LOCAL CFragmentedSampleReader : public ISampleReader, public AP4_LinearReader
 {
@@ -28,6 +32,7 @@ public:
   virtual bool Initialize(SESSION::CStream* stream) override;
   virtual void SetDecrypter(std::shared_ptr<Adaptive_CencSingleSampleDecrypter> ssd,
                             const DRM::DecrypterCapabilites& dcaps) override;
+  void SetDecryptAheadPool(UTILS::CThreadPool* pool) override { m_decryptAheadPool = pool; }
 
   AP4_Result Start(bool& bStarted) override;
   AP4_Result ReadSample() override;
@@ -59,6 +64,42 @@ private:
   void UpdateSampleDescription();
   void ParseTrafTfrf(AP4_UuidAtom* uuidAtom);
 
+  /*!
+   * \brief Get the KIDs of the samples of a track fragment from the "seig" sample groups,
+   *        used when keys are rotated (ISO/IEC 23001-7 key rotation). The "sbgp" atom maps
+   *        the samples to the group description entries, of the fragment or of the track.
+   * \param traf The track fragment atom
+   */
+  void GetSeigKeyIds(AP4_ContainerAtom* traf);
+
+  /*!
+   * \brief Update the fragment info of the decrypter when the sample just read
+   *        is encrypted with a different KID than the previous sample.
+   */
+  void UpdateSampleKeyId();
+
+  /*!
+   * \brief Check if the samples can be decrypted ahead in parallel.
+   */
+  bool CanDecryptAhead() const;
+
+  /*!
+   * \brief Read the next samples of the current fragment and submit them
+   *        to the worker threads for the decryption.
+   */
+  void DecryptAhead();
+
+  /*!
+   * \brief Get the first sample decrypted ahead, waiting for its decryption.
+   * \return The decryption result
+   */
+  AP4_Result GetDecryptedAheadSample();
+
+  /*!
+   * \brief Discard the samples decrypted ahead, waiting for pending decryptions.
+   */
+  void ClearDecryptAhead();
+
   AP4_Track* m_track;
   AP4_UI32 m_poolId{0};
   AP4_UI32 m_streamId;
@@ -79,8 +120,27 @@ private:
   AP4_DataBuffer m_sampleData;
   CodecHandler* m_codecHandler{nullptr};
   std::vector<uint8_t> m_defaultKey;
+  std::vector<uint8_t> m_fragmentKey; // The KID of the first sample of the current fragment
+  struct KeyIdRun
+  {
+    AP4_UI32 m_sampleCount;
+    std::vector<uint8_t> m_keyId;
+  };
+  // The KIDs of consecutive samples of the current fragment, from the "seig" sample groups
+  std::vector<KeyIdRun> m_keyIdRuns;
   AP4_ProtectedSampleDescription* m_protectedDesc{nullptr};
   std::shared_ptr<Adaptive_CencSingleSampleDecrypter> m_singleSampleDecryptor{nullptr};
+  // The decrypter of the current fragment, nullptr when the fragment is not encrypted
   CAdaptiveCencSampleDecrypter* m_decrypter{nullptr};
+  // The decrypter owned, reused across fragments
+  CAdaptiveCencSampleDecrypter* m_cencDecrypter{nullptr};
   CryptoInfo m_readerCryptoInfo{};
+  // The values of the last SetFragmentInfo call on the single sample decrypter
+  bool m_isFragmentInfoSet{false};
+  std::vector<uint8_t> m_fragmentInfoKey;
+  CryptoInfo m_fragmentInfoCrypto{};
+  // The worker threads of the session to decrypt samples ahead, nullptr if disabled
+  UTILS::CThreadPool* m_decryptAheadPool{nullptr};
+  // Samples read from the current fragment, decrypted in parallel, in the reading order
+  std::deque<std::unique_ptr<DecryptAheadSample>> m_decryptAheadSamples;
 };
@@ -26,6 +26,10 @@ namespace DRM
 {
 struct DecrypterCapabilites;
 }
+namespace UTILS
+{
+class CThreadPool;
+}
 namespace SESSION
 {
 class CStream;
@@ -47,6 +51,11 @@ public:
   virtual bool Initialize(SESSION::CStream* stream) { return true; }
   virtual void SetDecrypter(std::shared_ptr<Adaptive_CencSingleSampleDecrypter> ssd,
                             const DRM::DecrypterCapabilites& dcaps){};
+  /*!
+   * \brief Set the worker threads where to decrypt the samples ahead, if supported.
+   * \param pool The thread pool, nullptr to disable the decrypt ahead
+   */
+  virtual void SetDecryptAheadPool(UTILS::CThreadPool* pool) {}
   /*!
    * \brief Defines if the end of the stream is reached
    */
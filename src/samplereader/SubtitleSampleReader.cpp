@@ -106,7 +106,10 @@ bool CSubtitleSampleReader::InitializeFile(std::string url)
 
   if (!data.empty())
   {
-    AP4_DataBuffer buffer{data.c_str(), static_cast<AP4_Size>(data.size())};
+    // The buffer refer to the downloaded data, without make a copy of the whole file
+    AP4_DataBuffer buffer;
+    buffer.SetBuffer(reinterpret_cast<AP4_Byte*>(data.data()), static_cast<AP4_Size>(data.size()));
+    buffer.SetDataSize(static_cast<AP4_Size>(data.size()));
     m_codecHandler->Transform(0, 0, buffer, 1000);
   }
   return true;
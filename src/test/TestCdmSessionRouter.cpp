@@ -0,0 +1,208 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "../decrypters/HelperWv.h"
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace DRM;
+
+namespace
+{
+CdmMessage MakeMessage(CdmMessageType type, std::string sessionId, std::string data = "")
+{
+  CdmMessage message;
+  message.type = type;
+  message.sessionId = sessionId;
+  message.data.assign(data.begin(), data.end());
+  return message;
+}
+
+CdmMessage MakePromiseMessage(CdmMessageType type, uint32_t promiseId, std::string sessionId)
+{
+  CdmMessage message = MakeMessage(type, sessionId);
+  message.promiseId = promiseId;
+  return message;
+}
+
+// A license session of a PSSH set, receiving the CDM messages as the Widevine decrypter
+class CLicenseSession
+{
+public:
+  uint32_t AddPromise()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_router.AddPromise();
+  }
+
+  bool WaitPromise(uint32_t promiseId)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    bool isResolved{false};
+    m_cond.wait(lock, [&] { return m_router.TakePromiseResult(promiseId, isResolved); });
+    return isResolved;
+  }
+
+  void OnNotify(const CdmMessage& message)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_router.Route(message))
+      return;
+
+    if (message.type == CdmMessageType::SESSION_MESSAGE)
+      m_challenges.emplace_back(message.data.begin(), message.data.end());
+    else if (message.type == CdmMessageType::SESSION_KEY_CHANGE)
+      m_keys.emplace_back(message.data.begin(), message.data.end());
+
+    m_cond.notify_all();
+  }
+
+  std::string GetSessionId()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_router.GetSessionId();
+  }
+
+  std::vector<std::string> m_challenges;
+  std::vector<std::string> m_keys;
+
+private:
+  CCdmSessionRouter m_router;
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+};
+
+// A CDM that sends the messages to all the license sessions, as the CDM adapter
+class CFakeCdm
+{
+public:
+  void Attach(CLicenseSession* session) { m_sessions.emplace_back(session); }
+
+  void CreateSession(uint32_t promiseId, const std::string& pssh)
+  {
+    std::string sessionId;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      sessionId = "session" + std::to_string(++m_sessionsCount);
+    }
+    // The promise is resolved before any other message of the session
+    Notify(MakePromiseMessage(CdmMessageType::PROMISE_RESOLVED, promiseId, sessionId));
+    Notify(MakeMessage(CdmMessageType::SESSION_MESSAGE, sessionId, "challenge-" + pssh));
+    Notify(MakeMessage(CdmMessageType::SESSION_KEY_CHANGE, sessionId, "key-" + pssh));
+  }
+
+  void Notify(const CdmMessage& message)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (CLicenseSession* session : m_sessions)
+      session->OnNotify(message);
+  }
+
+private:
+  std::vector<CLicenseSession*> m_sessions;
+  std::mutex m_mutex;
+  int m_sessionsCount{0};
+};
+} // unnamed namespace
+
+TEST(CdmSessionRouterTest, TwoPsshSetsOpenedConcurrently)
+{
+  for (int i = 0; i < 50; ++i)
+  {
+    CFakeCdm cdm;
+    CLicenseSession sessionA;
+    CLicenseSession sessionB;
+    cdm.Attach(&sessionA);
+    cdm.Attach(&sessionB);
+
+    auto openSession = [&cdm](CLicenseSession& session, std::string pssh)
+    {
+      const uint32_t promiseId = session.AddPromise();
+      std::thread cdmThread([&cdm, promiseId, pssh] { cdm.CreateSession(promiseId, pssh); });
+      EXPECT_TRUE(session.WaitPromise(promiseId));
+      cdmThread.join();
+    };
+
+    std::thread threadA(openSession, std::ref(sessionA), "psshA");
+    std::thread threadB(openSession, std::ref(sessionB), "psshB");
+    threadA.join();
+    threadB.join();
+
+    EXPECT_FALSE(sessionA.GetSessionId().empty());
+    EXPECT_FALSE(sessionB.GetSessionId().empty());
+    EXPECT_NE(sessionA.GetSessionId(), sessionB.GetSessionId());
+
+    // Each session must receive only its own license request and keys
+    ASSERT_EQ(sessionA.m_challenges.size(), 1);
+    EXPECT_EQ(sessionA.m_challenges[0], "challenge-psshA");
+    ASSERT_EQ(sessionA.m_keys.size(), 1);
+    EXPECT_EQ(sessionA.m_keys[0], "key-psshA");
+
+    ASSERT_EQ(sessionB.m_challenges.size(), 1);
+    EXPECT_EQ(sessionB.m_challenges[0], "challenge-psshB");
+    ASSERT_EQ(sessionB.m_keys.size(), 1);
+    EXPECT_EQ(sessionB.m_keys[0], "key-psshB");
+  }
+}
+
+TEST(CdmSessionRouterTest, MessagesWithoutSessionAreIgnored)
+{
+  CCdmSessionRouter router;
+  const uint32_t promiseId = router.AddPromise();
+
+  // Before the creation promise is resolved no session message can be accepted
+  EXPECT_FALSE(router.Route(MakeMessage(CdmMessageType::SESSION_MESSAGE, "other")));
+  EXPECT_FALSE(router.Route(MakeMessage(CdmMessageType::SESSION_MESSAGE, "")));
+
+  bool isResolved{false};
+  EXPECT_FALSE(router.TakePromiseResult(promiseId, isResolved));
+
+  EXPECT_TRUE(router.Route(
+      MakePromiseMessage(CdmMessageType::PROMISE_RESOLVED, promiseId, "session1")));
+  EXPECT_EQ(router.GetSessionId(), "session1");
+  EXPECT_TRUE(router.TakePromiseResult(promiseId, isResolved));
+  EXPECT_TRUE(isResolved);
+  // The settled promise is removed
+  EXPECT_FALSE(router.TakePromiseResult(promiseId, isResolved));
+
+  EXPECT_TRUE(router.Route(MakeMessage(CdmMessageType::SESSION_KEY_CHANGE, "session1")));
+  EXPECT_FALSE(router.Route(MakeMessage(CdmMessageType::SESSION_KEY_CHANGE, "session2")));
+
+  router.ClearSessionId();
+  EXPECT_FALSE(router.Route(MakeMessage(CdmMessageType::SESSION_KEY_CHANGE, "session1")));
+}
+
+TEST(CdmSessionRouterTest, PromisesOfOtherSessions)
+{
+  CCdmSessionRouter routerA;
+  CCdmSessionRouter routerB;
+  const uint32_t promiseA = routerA.AddPromise();
+  const uint32_t promiseB = routerB.AddPromise();
+  EXPECT_NE(promiseA, promiseB);
+
+  const CdmMessage rejectB = MakePromiseMessage(CdmMessageType::PROMISE_REJECTED, promiseB, "");
+  EXPECT_FALSE(routerA.Route(rejectB));
+  EXPECT_TRUE(routerB.Route(rejectB));
+
+  bool isResolved{true};
+  EXPECT_FALSE(routerA.TakePromiseResult(promiseA, isResolved));
+  EXPECT_TRUE(routerB.TakePromiseResult(promiseB, isResolved));
+  EXPECT_FALSE(isResolved);
+  EXPECT_TRUE(routerB.GetSessionId().empty());
+
+  // A persistent session that does not exist is resolved without a session id
+  const CdmMessage resolveA = MakePromiseMessage(CdmMessageType::PROMISE_RESOLVED, promiseA, "");
+  EXPECT_TRUE(routerA.Route(resolveA));
+  EXPECT_TRUE(routerA.TakePromiseResult(promiseA, isResolved));
+  EXPECT_TRUE(isResolved);
+  EXPECT_TRUE(routerA.GetSessionId().empty());
+}
@@ -620,6 +620,150 @@ TEST_F(DASHTreeAdaptiveStreamTest, MisalignedSegmentTimeline)
   EXPECT_EQ(repr->Timeline().GetPos(repr->current_segment_), 0);
 }
 
+TEST_F(DASHTreeTest, MPDPatchUpdate)
+{
+  OpenTestFile("mpd/live_patch.mpd");
+
+  auto& adpSets = tree->m_currentPeriod->GetAdaptationSets();
+  auto& videoRepr = adpSets[0]->GetRepresentations()[0];
+  auto& audioRepr = adpSets[1]->GetRepresentations()[0];
+  // Set the last segment to the current segment to simulate reaching the last segment
+  videoRepr->current_segment_ = videoRepr->Timeline().GetBack();
+  audioRepr->current_segment_ = audioRepr->Timeline().GetBack();
+
+  // The patch remove, add and replace segments of the timelines
+  EXPECT_EQ(tree->RunManifestUpdate("mpd/live_patch_upd.mpd", "mpd/live_patch_1.mpp"),
+            "http://foo.bar/mpd/live_patch.mpp");
+  EXPECT_EQ(videoRepr->Timeline().GetSize(), 5);
+  EXPECT_EQ(videoRepr->Timeline().Get(0)->startPTS_, 180000);
+  EXPECT_EQ(videoRepr->Timeline().GetBack()->startPTS_, 900000);
+  EXPECT_EQ(videoRepr->current_segment_->startPTS_, 720000);
+  EXPECT_EQ(audioRepr->Timeline().GetSize(), 5);
+  EXPECT_EQ(audioRepr->Timeline().Get(0)->startPTS_, 96000);
+  EXPECT_EQ(audioRepr->Timeline().GetBack()->startPTS_, 480000);
+  EXPECT_EQ(audioRepr->current_segment_->startPTS_, 384000);
+
+  // The same patch no longer match the MPD publish time, so fallback to the full MPD
+  EXPECT_EQ(tree->RunManifestUpdate("mpd/live_patch_upd.mpd", "mpd/live_patch_1.mpp"),
+            "http://foo.bar/mpd/live_patch.mpd");
+  EXPECT_EQ(videoRepr->Timeline().GetSize(), 5);
+  EXPECT_EQ(videoRepr->Timeline().Get(0)->startPTS_, 360000);
+  EXPECT_EQ(videoRepr->Timeline().GetBack()->startPTS_, 1080000);
+  EXPECT_EQ(videoRepr->current_segment_->startPTS_, 720000);
+  EXPECT_EQ(audioRepr->Timeline().Get(0)->startPTS_, 192000);
+}
+
+TEST_F(DASHTreeTest, MPDPatchLocationExpired)
+{
+  OpenTestFile("mpd/live_patch.mpd");
+
+  auto& videoRepr = tree->m_currentPeriod->GetAdaptationSets()[0]->GetRepresentations()[0];
+  videoRepr->current_segment_ = videoRepr->Timeline().GetBack();
+
+  // The patch location expire 60 secs (ttl) after the MPD publish time
+  tree->SetNowTime(1622373520000);
+
+  EXPECT_EQ(tree->RunManifestUpdate("mpd/live_patch_upd.mpd", "mpd/live_patch_1.mpp"),
+            "http://foo.bar/mpd/live_patch.mpd");
+  EXPECT_EQ(videoRepr->Timeline().Get(0)->startPTS_, 360000);
+}
+
+TEST_F(DASHTreeTest, ComputeUpdateInterval)
+{
+  OpenTestFile("mpd/live_patch.mpd");
+
+  auto& videoRepr = tree->m_currentPeriod->GetAdaptationSets()[0]->GetRepresentations()[0];
+  videoRepr->SetIsEnabled(true);
+
+  // Playback not started, use the MPD minimum update period
+  EXPECT_EQ(tree->ComputeUpdateInterval(), 2000);
+
+  // Plenty of segments to download (8 secs), the update interval is extended
+  videoRepr->current_segment_ = videoRepr->Timeline().Get(0);
+  EXPECT_EQ(tree->ComputeUpdateInterval(), 6000);
+
+  // Near the live edge, update when the next segment will be available (AST + 12 secs)
+  // plus the clock skew margin
+  videoRepr->current_segment_ = videoRepr->Timeline().Get(3);
+  tree->SetNowTime(1620379956454 + 11000);
+  EXPECT_EQ(tree->ComputeUpdateInterval(), 1500);
+
+  // The next segment should be already available, update as soon as possible
+  tree->SetNowTime(1620379956454 + 14000);
+  EXPECT_EQ(tree->ComputeUpdateInterval(), 500);
+}
+
+TEST_F(DASHTreeTest, UTCTimingClockSync)
+{
+  // The local clock is 5 secs behind the server clock
+  tree->SetNowTime(1622373460000);
+  tree->SetServerTimeResponse("2021-05-30T11:17:45.000Z");
+  OpenTestFile("mpd/live_utctiming.mpd");
+
+  EXPECT_EQ(tree->GetServerTimestamp(), 1622373465000);
+  EXPECT_EQ(tree->stream_start_, 1622373465000);
+
+  // The clock is not synchronized again before the resync interval
+  tree->SetNowTime(1622373462000);
+  tree->SetServerTimeResponse("2021-05-30T11:17:52.000Z");
+  tree->RunManifestUpdate("mpd/live_utctiming.mpd");
+  EXPECT_EQ(tree->GetServerTimestamp(), 1622373467000);
+
+  // After the resync interval, the local clock is now 10 secs behind the server clock
+  tree->SetNowTime(1622373760000);
+  tree->SetServerTimeResponse("2021-05-30T11:22:50.000Z");
+  tree->RunManifestUpdate("mpd/live_utctiming.mpd");
+  EXPECT_EQ(tree->GetServerTimestamp(), 1622373770000);
+  EXPECT_EQ(tree->stream_start_, 1622373470000);
+}
+
+TEST_F(DASHTreeTest, SegmentTemplateAvailabilityTime)
+{
+  tree->SetNowTime(1712130846500);
+
+  OpenTestFile("mpd/segtpl_low_latency.mpd");
+
+  auto& period = tree->m_periods[0];
+  auto& videoRepr = period->GetAdaptationSets()[0]->GetRepresentations()[0];
+  auto& audioRepr = period->GetAdaptationSets()[1]->GetRepresentations()[0];
+
+  // The segment in production is available in advance by the availabilityTimeOffset (1.5 secs)
+  EXPECT_EQ(tree->GetSegmentAvailableTime(period.get(), videoRepr.get(),
+                                          *videoRepr->Timeline().GetBack()),
+            1712130845232);
+
+  // The last generated segment is complete
+  const PLAYLIST::CSegment* audioSeg = audioRepr->Timeline().GetBack();
+  EXPECT_EQ(tree->GetSegmentAvailableTime(period.get(), audioRepr.get(), *audioSeg),
+            1712130844732);
+
+  // The next segment, as generated by InsertLiveSegment, will be available in 232 ms
+  PLAYLIST::CSegment nextSeg = *audioSeg;
+  nextSeg.startPTS_ = audioSeg->m_endPts;
+  nextSeg.m_endPts = nextSeg.startPTS_ + 96000;
+  nextSeg.m_number++;
+  EXPECT_EQ(tree->GetSegmentAvailableTime(period.get(), audioRepr.get(), nextSeg),
+            1712130846732);
+}
+
+TEST_F(DASHTreeTest, SegmentTemplateAvailabilityTimeFractionalDuration)
+{
+  tree->SetNowTime(1704070800000);
+
+  // The segments duration of 96256 / 48000 secs is not an integer number of ms
+  OpenTestFile("mpd/segtpl_frac_duration.mpd");
+
+  auto& period = tree->m_periods[0];
+  auto& repr = period->GetAdaptationSets()[0]->GetRepresentations()[0];
+  const PLAYLIST::CSegment* segment = repr->Timeline().GetBack();
+  ASSERT_NE(segment, nullptr);
+
+  // The 0.333 ms of each segment must not be lost, after one hour they are about 0.6 secs
+  const uint64_t expectedTime = 1704067200000 + segment->m_number * 96256 * 1000 / 48000;
+  EXPECT_EQ(tree->GetSegmentAvailableTime(period.get(), repr.get(), *segment), expectedTime);
+  EXPECT_GT(expectedTime, 1704067200000 + segment->m_number * 2005 + 500);
+}
+
 TEST_F(DASHTreeTest, AdaptionSetSwitching)
 {
   OpenTestFile("mpd/adaptation_set_switching.mpd");
@@ -753,3 +897,85 @@ TEST_F(DASHTreeTest, TSBAvailabilityStartTime)
   EXPECT_EQ(tl.GetFront()->m_number, 129069);
   EXPECT_EQ(tl.GetBack()->m_number, 130268);
 }
+
+TEST_F(DASHTreeTest, LowLatencyAvailabilityTimeOffset)
+{
+  // The now time fall at 1.768 secs of a 2 secs segment, so the segment in production
+  // is already available due to the availabilityTimeOffset of 1.5 secs
+  tree->SetNowTime(1712130846500);
+
+  OpenTestFile("mpd/segtpl_low_latency.mpd");
+
+  EXPECT_EQ(tree->m_lowLatencyDelay, 3000);
+  EXPECT_EQ(tree->m_minLatency, 2000);
+  EXPECT_EQ(tree->m_maxLatency, 6000);
+  EXPECT_DOUBLE_EQ(tree->m_minPlaybackRate.value_or(0), 0.96);
+  EXPECT_DOUBLE_EQ(tree->m_maxPlaybackRate.value_or(0), 1.04);
+
+  auto& videoRepr = tree->m_periods[0]->GetAdaptationSets()[0]->GetRepresentations()[0];
+  EXPECT_EQ(videoRepr->GetSegmentTemplate()->GetAvailabilityTimeOffset(), 1500);
+  EXPECT_FALSE(videoRepr->GetSegmentTemplate()->IsAvailabilityTimeComplete());
+
+  auto& videoTl = videoRepr->Timeline();
+  EXPECT_EQ(videoTl.GetSize(), 31);
+  EXPECT_EQ(videoTl.GetFront()->m_number, 390777);
+  EXPECT_EQ(videoTl.GetBack()->m_number, 390807);
+
+  // Without availabilityTimeOffset only the complete segments are available
+  auto& audioTl =
+      tree->m_periods[0]->GetAdaptationSets()[1]->GetRepresentations()[0]->Timeline();
+  EXPECT_EQ(audioTl.GetSize(), 30);
+  EXPECT_EQ(audioTl.GetFront()->m_number, 390777);
+  EXPECT_EQ(audioTl.GetBack()->m_number, 390806);
+}
+
+TEST_F(DASHTreeTest, LowLatencyAvailabilityTimeOffsetSegTimeline)
+{
+  // The now time fall at 1.6 secs of the segment that follows the last one listed,
+  // so the segment in production is already available due to the availabilityTimeOffset
+  tree->SetNowTime(1704067211600);
+
+  OpenTestFile("mpd/segtimeline_low_latency.mpd");
+
+  auto& videoTl = tree->m_periods[0]->GetAdaptationSets()[0]->GetRepresentations()[0]->Timeline();
+  ASSERT_EQ(videoTl.GetSize(), 6);
+  EXPECT_EQ(videoTl.GetBack()->m_time, 10000);
+  EXPECT_EQ(videoTl.GetBack()->startPTS_, 10000);
+  EXPECT_EQ(videoTl.GetBack()->m_endPts, 12000);
+
+  // Without availabilityTimeOffset only the segments listed are available
+  auto& audioTl = tree->m_periods[0]->GetAdaptationSets()[1]->GetRepresentations()[0]->Timeline();
+  EXPECT_EQ(audioTl.GetSize(), 5);
+  EXPECT_EQ(audioTl.GetBack()->m_time, 8000);
+}
+
+TEST_F(DASHTreeTest, EventStream)
+{
+  tree->SetNowTime(1622373460000);
+  OpenTestFile("mpd/live_eventstream.mpd");
+
+  auto& events = tree->m_periods[0]->GetEventMessages();
+  ASSERT_EQ(events.size(), 2);
+
+  EXPECT_EQ(events[0].m_schemeIdUri, "urn:scte:scte35:2014:xml+bin");
+  EXPECT_EQ(events[0].m_id, 100);
+  EXPECT_EQ(events[0].m_timescale, 90000);
+  // Presentation time relative to the period start (10 secs), less the presentationTimeOffset
+  EXPECT_EQ(events[0].GetPresentationTimeMs(), 12000);
+  EXPECT_EQ(events[0].m_duration, 2700000);
+  EXPECT_EQ(events[0].m_messageData,
+            "<Signal xmlns=\"http://www.scte.org/schemas/35/2016\"><Binary>"
+            "/DAlAAAAAAAAAP/wFAUAAAABf+/+AAAAAH4AKTLgAAEAAAAAzrAH6g==</Binary></Signal>");
+
+  EXPECT_EQ(events[1].m_schemeIdUri, PLAYLIST::EVENT_SCHEME_MPD);
+  EXPECT_EQ(events[1].m_value, "1");
+  EXPECT_EQ(events[1].GetPresentationTimeMs(), 14000);
+  EXPECT_EQ(events[1].m_duration, PLAYLIST::NO_VALUE);
+
+  // The events already signalled are not duplicated by the manifest update
+  tree->RunManifestUpdate("mpd/live_eventstream_upd.mpd");
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_EQ(events[2].m_id, 2);
+  EXPECT_EQ(events[2].GetPresentationTimeMs(), 16000);
+  EXPECT_EQ(events[2].m_messageData, "refresh");
+}
@@ -0,0 +1,138 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "../common/EventMessage.h"
+
+#include <gtest/gtest.h>
+
+using namespace PLAYLIST;
+
+namespace
+{
+void AppendU32(std::vector<uint8_t>& data, uint32_t value)
+{
+  for (int shift = 24; shift >= 0; shift -= 8)
+    data.emplace_back(static_cast<uint8_t>(value >> shift));
+}
+
+void AppendString(std::vector<uint8_t>& data, const std::string& value)
+{
+  data.insert(data.end(), value.begin(), value.end());
+  data.emplace_back(0);
+}
+
+void AppendBox(std::vector<uint8_t>& data, const char* type, const std::vector<uint8_t>& payload)
+{
+  AppendU32(data, static_cast<uint32_t>(payload.size() + 8));
+  data.insert(data.end(), type, type + 4);
+  data.insert(data.end(), payload.begin(), payload.end());
+}
+
+std::vector<uint8_t> CreateEmsgV0(const std::string& scheme,
+                                  const std::string& value,
+                                  uint32_t timescale,
+                                  uint32_t ptsDelta,
+                                  uint32_t duration,
+                                  uint32_t id,
+                                  const std::string& messageData)
+{
+  std::vector<uint8_t> payload;
+  AppendU32(payload, 0); // Version and flags
+  AppendString(payload, scheme);
+  AppendString(payload, value);
+  AppendU32(payload, timescale);
+  AppendU32(payload, ptsDelta);
+  AppendU32(payload, duration);
+  AppendU32(payload, id);
+  payload.insert(payload.end(), messageData.begin(), messageData.end());
+  return payload;
+}
+
+std::vector<uint8_t> CreateEmsgV1(const std::string& scheme,
+                                  const std::string& value,
+                                  uint32_t timescale,
+                                  uint64_t pts,
+                                  uint32_t duration,
+                                  uint32_t id,
+                                  const std::string& messageData)
+{
+  std::vector<uint8_t> payload;
+  AppendU32(payload, 0x01000000); // Version and flags
+  AppendU32(payload, timescale);
+  AppendU32(payload, static_cast<uint32_t>(pts >> 32));
+  AppendU32(payload, static_cast<uint32_t>(pts));
+  AppendU32(payload, duration);
+  AppendU32(payload, id);
+  AppendString(payload, scheme);
+  AppendString(payload, value);
+  payload.insert(payload.end(), messageData.begin(), messageData.end());
+  return payload;
+}
+} // unnamed namespace
+
+TEST(EventMessageTest, ParseVersion0)
+{
+  std::vector<uint8_t> data;
+  AppendBox(data, "styp", {'m', 's', 'd', 'h', 0, 0, 0, 0});
+  AppendBox(data, "emsg",
+            CreateEmsgV0(std::string(EVENT_SCHEME_MPD), "1", 1000, 500, 0xFFFFFFFF, 7, ""));
+  AppendBox(data, "moof", {});
+
+  std::vector<CEventMessage> events;
+  ASSERT_TRUE(ParseEventMessages(data.data(), data.size(), 10000, events));
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0].m_schemeIdUri, EVENT_SCHEME_MPD);
+  EXPECT_EQ(events[0].m_value, "1");
+  EXPECT_EQ(events[0].m_id, 7);
+  EXPECT_EQ(events[0].GetPresentationTimeMs(), 10500);
+  EXPECT_EQ(events[0].m_duration, NO_VALUE);
+  EXPECT_TRUE(events[0].m_messageData.empty());
+}
+
+TEST(EventMessageTest, ParseVersion1)
+{
+  std::vector<uint8_t> data;
+  AppendBox(data, "emsg",
+            CreateEmsgV1("urn:scte:scte35:2013:bin", "", 90000, 0x100000000, 2700000, 12,
+                         std::string("\xFC\x30\x11", 3)));
+  AppendBox(data, "emsg", CreateEmsgV1("urn:test", "x", 1000, 5000, 1000, 13, "payload"));
+  AppendBox(data, "moof", {});
+  // Boxes after moof must be ignored
+  AppendBox(data, "emsg", CreateEmsgV1("urn:test", "x", 1000, 6000, 1000, 14, ""));
+
+  std::vector<CEventMessage> events;
+  ASSERT_TRUE(ParseEventMessages(data.data(), data.size(), 0, events));
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_EQ(events[0].m_schemeIdUri, "urn:scte:scte35:2013:bin");
+  EXPECT_EQ(events[0].m_presentationTime, 0x100000000);
+  EXPECT_EQ(events[0].m_duration, 2700000);
+  EXPECT_EQ(events[0].m_messageData, std::string("\xFC\x30\x11", 3));
+  EXPECT_EQ(events[1].m_id, 13);
+  EXPECT_EQ(events[1].GetPresentationTimeMs(), 5000);
+  EXPECT_EQ(events[1].m_messageData, "payload");
+  EXPECT_FALSE(events[0].IsSameEvent(events[1]));
+}
+
+TEST(EventMessageTest, ParseMalformed)
+{
+  std::vector<uint8_t> data;
+  AppendBox(data, "emsg", CreateEmsgV0("urn:test", "x", 1000, 0, 0, 1, ""));
+  std::vector<CEventMessage> events;
+
+  // Truncated box
+  ASSERT_FALSE(ParseEventMessages(data.data(), data.size() - 4, 0, events));
+  // Missing string terminator
+  std::vector<uint8_t> noTerm;
+  AppendBox(noTerm, "emsg", {0, 0, 0, 0, 'u', 'r', 'n'});
+  ASSERT_FALSE(ParseEventMessages(noTerm.data(), noTerm.size(), 0, events));
+  // Zero timescale
+  std::vector<uint8_t> noTimescale;
+  AppendBox(noTimescale, "emsg", CreateEmsgV0("urn:test", "x", 0, 0, 0, 1, ""));
+  ASSERT_FALSE(ParseEventMessages(noTimescale.data(), noTimescale.size(), 0, events));
+  EXPECT_TRUE(events.empty());
+}
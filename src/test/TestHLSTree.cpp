@@ -26,6 +26,8 @@ protected:
   {
     tree->Uninitialize();
     testHelper::effectiveUrl.clear();
+    testHelper::nextTestFiles.clear();
+    testHelper::downloadList.clear();
     delete tree;
     tree = nullptr;
     delete m_reprChooser;
@@ -92,7 +94,7 @@ protected:
     return tree->PrepareRepresentation(per, adp, rep);
   }
 
-  adaptive::CHLSTree* tree;
+  HLSTestTree* tree;
   CHOOSER::IRepresentationChooser* m_reprChooser{nullptr};
 };
 
@@ -399,3 +401,186 @@ TEST_F(HLSTreeTest, MultipleEncryptionSequenceDrm)
   EXPECT_EQ(periods[0]->GetEncryptionState(), PLAYLIST::EncryptionState::ENCRYPTED_DRM);
   EXPECT_EQ(periods[1]->GetEncryptionState(), PLAYLIST::EncryptionState::ENCRYPTED_DRM);
 }
+
+TEST_F(HLSTreeTest, LowLatencyParts)
+{
+  OpenTestFileMaster("hls/1v_master.m3u8", "https://foo.bar/master.m3u8");
+
+  bool ret = OpenTestFileVariant("hls/llhls_fmp4_v_stream.m3u8", "https://foo.bar/stream.m3u8",
+                                 tree->m_currentPeriod, tree->m_currentAdpSet, tree->m_currentRepr);
+  EXPECT_EQ(ret, true);
+
+  // PART-HOLD-BACK is used as live delay, and the playlist is reloaded at each part
+  EXPECT_EQ(tree->m_lowLatencyDelay, 3000);
+  EXPECT_EQ(tree->m_partDuration, 1000);
+  // With blocking reload the playlist is requested at the half of the part target
+  EXPECT_EQ(tree->m_currentRepr->m_updateInterval, 500);
+
+  const PLAYLIST::CSegContainer& timeline = tree->m_currentRepr->Timeline();
+  ASSERT_EQ(timeline.GetSize(), 3);
+
+  const PLAYLIST::CSegment* segment = timeline.Get(0);
+  EXPECT_EQ(segment->m_number, 100);
+  EXPECT_TRUE(segment->m_parts.empty());
+  EXPECT_FALSE(segment->m_isPartial);
+
+  segment = timeline.Get(1);
+  EXPECT_EQ(segment->m_number, 101);
+  EXPECT_EQ(segment->url, "seg101.mp4");
+  EXPECT_FALSE(segment->m_isPartial);
+  ASSERT_EQ(segment->m_parts.size(), 4);
+  EXPECT_EQ(segment->m_parts[0].m_rangeBegin, 0);
+  EXPECT_EQ(segment->m_parts[0].m_rangeEnd, 999);
+  EXPECT_TRUE(segment->m_parts[0].m_isIndependent);
+  // Byte range without offset, that follow the previous part
+  EXPECT_EQ(segment->m_parts[1].m_rangeBegin, 1000);
+  EXPECT_EQ(segment->m_parts[1].m_rangeEnd, 1799);
+  EXPECT_FALSE(segment->m_parts[1].m_isIndependent);
+  EXPECT_EQ(segment->m_parts[3].m_rangeBegin, 2700);
+  EXPECT_EQ(segment->m_parts[3].m_rangeEnd, 3399);
+
+  // The segment in production, with the gap part excluded and the preload hint at the end
+  segment = timeline.Get(2);
+  EXPECT_EQ(segment->m_number, 102);
+  EXPECT_TRUE(segment->m_isPartial);
+  EXPECT_TRUE(segment->url.empty());
+  EXPECT_EQ(segment->startPTS_, 8000);
+  EXPECT_EQ(segment->m_endPts, 10000);
+  ASSERT_EQ(segment->m_parts.size(), 3);
+  EXPECT_EQ(segment->m_parts[0].m_url, "seg102.part0.mp4");
+  EXPECT_EQ(segment->m_parts[0].m_duration, 1000);
+  EXPECT_EQ(segment->m_parts[0].m_rangeBegin, PLAYLIST::NO_VALUE);
+  EXPECT_EQ(segment->m_parts[1].m_url, "seg102.part1.mp4");
+  EXPECT_EQ(segment->m_parts[2].m_url, "seg102.part3.mp4");
+  EXPECT_TRUE(segment->m_parts[2].m_isPreloadHint);
+  EXPECT_EQ(segment->m_parts[2].m_duration, 0);
+}
+
+TEST_F(HLSTreeTest, LowLatencyDeltaUpdate)
+{
+  OpenTestFileMaster("hls/1v_master.m3u8", "https://foo.bar/master.m3u8");
+
+  bool ret = OpenTestFileVariant("hls/llhls_fmp4_v_stream.m3u8", "https://foo.bar/stream.m3u8",
+                                 tree->m_currentPeriod, tree->m_currentAdpSet, tree->m_currentRepr);
+  EXPECT_EQ(ret, true);
+
+  // The skipped segment no. 101 is taken from the current timeline
+  ret = OpenTestFileVariant("hls/llhls_fmp4_v_stream_delta.m3u8", "", tree->m_currentPeriod,
+                            tree->m_currentAdpSet, tree->m_currentRepr);
+  EXPECT_EQ(ret, true);
+
+  ASSERT_EQ(testHelper::downloadList.size(), 2);
+  EXPECT_EQ(testHelper::downloadList[0], "https://foo.bar/stream.m3u8");
+  EXPECT_EQ(testHelper::downloadList[1], "https://foo.bar/stream.m3u8?_HLS_skip=YES");
+
+  const PLAYLIST::CSegContainer& timeline = tree->m_currentRepr->Timeline();
+  EXPECT_EQ(tree->m_currentRepr->GetStartNumber(), 101);
+  ASSERT_EQ(timeline.GetSize(), 3);
+
+  const PLAYLIST::CSegment* segment = timeline.Get(0);
+  EXPECT_EQ(segment->m_number, 101);
+  EXPECT_EQ(segment->url, "seg101.mp4");
+  EXPECT_EQ(segment->m_parts.size(), 4);
+
+  segment = timeline.Get(1);
+  EXPECT_EQ(segment->m_number, 102);
+  EXPECT_EQ(segment->url, "seg102.mp4");
+  EXPECT_EQ(segment->startPTS_, 8000);
+  EXPECT_EQ(segment->m_endPts, 12000);
+
+  segment = timeline.Get(2);
+  EXPECT_EQ(segment->m_number, 103);
+  EXPECT_TRUE(segment->m_isPartial);
+  EXPECT_EQ(segment->m_parts.size(), 2);
+}
+
+TEST_F(HLSTreeTest, LowLatencyDeltaUpdateMismatch)
+{
+  OpenTestFileMaster("hls/1v_master.m3u8", "https://foo.bar/master.m3u8");
+
+  bool ret = OpenTestFileVariant("hls/llhls_fmp4_v_stream.m3u8", "https://foo.bar/stream.m3u8",
+                                 tree->m_currentPeriod, tree->m_currentAdpSet, tree->m_currentRepr);
+  EXPECT_EQ(ret, true);
+
+  // The skipped segments are older than the current timeline, the full playlist is requested
+  testHelper::nextTestFiles = {"hls/llhls_fmp4_v_stream_delta_mismatch.m3u8",
+                               "hls/llhls_fmp4_v_stream_full.m3u8"};
+  ret = OpenTestFileVariant("hls/llhls_fmp4_v_stream_delta_mismatch.m3u8", "",
+                            tree->m_currentPeriod, tree->m_currentAdpSet, tree->m_currentRepr);
+  EXPECT_EQ(ret, true);
+
+  ASSERT_EQ(testHelper::downloadList.size(), 3);
+  EXPECT_EQ(testHelper::downloadList[1], "https://foo.bar/stream.m3u8?_HLS_skip=YES");
+  EXPECT_EQ(testHelper::downloadList[2], "https://foo.bar/stream.m3u8");
+
+  // The full playlist is merged with the current timeline
+  const PLAYLIST::CSegContainer& timeline = tree->m_currentRepr->Timeline();
+  EXPECT_EQ(tree->m_currentRepr->GetStartNumber(), 101);
+  ASSERT_EQ(timeline.GetSize(), 3);
+
+  const PLAYLIST::CSegment* segment = timeline.Get(0);
+  EXPECT_EQ(segment->m_number, 101);
+  EXPECT_EQ(segment->url, "seg101.mp4");
+
+  segment = timeline.Get(1);
+  EXPECT_EQ(segment->m_number, 102);
+  EXPECT_EQ(segment->url, "seg102.mp4");
+  EXPECT_EQ(segment->startPTS_, 8000);
+  EXPECT_EQ(segment->m_endPts, 12000);
+
+  segment = timeline.Get(2);
+  EXPECT_EQ(segment->m_number, 103);
+  EXPECT_TRUE(segment->m_isPartial);
+  ASSERT_EQ(segment->m_parts.size(), 2);
+  EXPECT_EQ(segment->m_parts[0].m_url, "seg103.part0.mp4");
+}
+
+TEST_F(HLSTreeTest, LowLatencyBlockingReloadWithGapPart)
+{
+  OpenTestFileMaster("hls/1v_master.m3u8", "https://foo.bar/master.m3u8");
+
+  bool ret = OpenTestFileVariant("hls/llhls_fmp4_v_stream.m3u8", "https://foo.bar/stream.m3u8",
+                                 tree->m_currentPeriod, tree->m_currentAdpSet, tree->m_currentRepr);
+  EXPECT_EQ(ret, true);
+
+  tree->m_currentRepr->SetIsEnabled(true);
+  tree->m_currentRepr->m_nextUpdate = std::chrono::steady_clock::now();
+  testHelper::testFile = "hls/llhls_fmp4_v_stream_delta.m3u8";
+  tree->RunPlaylistsUpdate();
+
+  // The segment no. 102 lists two parts and a gap part, so the next part has index 3
+  ASSERT_EQ(testHelper::downloadList.size(), 2);
+  EXPECT_EQ(testHelper::downloadList[1],
+            "https://foo.bar/stream.m3u8?_HLS_msn=102&_HLS_part=3&_HLS_skip=YES");
+  EXPECT_EQ(tree->m_currentRepr->GetStartNumber(), 101);
+}
+
+TEST_F(HLSTreeTest, LowLatencyUpdateRefreshedWhilePaused)
+{
+  OpenTestFileMaster("hls/1v_master.m3u8", "https://foo.bar/master.m3u8");
+
+  bool ret = OpenTestFileVariant("hls/llhls_fmp4_v_stream.m3u8", "https://foo.bar/stream.m3u8",
+                                 tree->m_currentPeriod, tree->m_currentAdpSet, tree->m_currentRepr);
+  EXPECT_EQ(ret, true);
+
+  tree->m_currentRepr->SetIsEnabled(true);
+  tree->m_currentRepr->m_nextUpdate = std::chrono::steady_clock::now();
+
+  // The update downloads a playlist, then the playlist is refreshed by another request
+  // before the update is applied, so the downloaded playlist is outdated
+  tree->RunPlaylistsUpdate(
+      [this]
+      {
+        EXPECT_TRUE(OpenTestFileVariant("hls/llhls_fmp4_v_stream_full.m3u8", "",
+                                        tree->m_currentPeriod, tree->m_currentAdpSet,
+                                        tree->m_currentRepr));
+      });
+
+  ASSERT_EQ(testHelper::downloadList.size(), 3);
+
+  // The timeline of the refreshed playlist is kept
+  const PLAYLIST::CSegContainer& timeline = tree->m_currentRepr->Timeline();
+  EXPECT_EQ(tree->m_currentRepr->GetStartNumber(), 101);
+  ASSERT_EQ(timeline.GetSize(), 3);
+  EXPECT_EQ(timeline.Get(2)->m_number, 103);
+}
@@ -11,6 +11,7 @@
 #include "../utils/CurlUtils.h"
 
 std::string testHelper::testFile;
+std::deque<std::string> testHelper::nextTestFiles;
 std::string testHelper::effectiveUrl;
 std::vector<std::string> testHelper::downloadList;
 
@@ -54,10 +55,17 @@ bool testHelper::DownloadFile(std::string_view url,
                   const std::vector<std::string>& respHeaders,
                   UTILS::CURL::HTTPResponse& resp)
 {
-  if (testHelper::testFile.empty())
+  std::string filePath = testHelper::testFile;
+  if (!testHelper::nextTestFiles.empty())
+  {
+    filePath = testHelper::nextTestFiles.front();
+    testHelper::nextTestFiles.pop_front();
+  }
+
+  if (filePath.empty())
     return false;
 
-  bool ret = LoadFile(testHelper::testFile, resp.data);
+  bool ret = LoadFile(filePath, resp.data);
 
   if (!ret)
     return false;
@@ -159,10 +167,11 @@ std::string AESDecrypter::convertIV(const std::string& input)
 
 void AESDecrypter::ivFromSequence(uint8_t* buffer, uint64_t sid){}
 
-std::string DASHTestTree::RunManifestUpdate(std::string manifestUpdFile)
+std::string DASHTestTree::RunManifestUpdate(std::string manifestUpdFile, std::string patchFile)
 {
   m_manifestUpdUrl.clear();
   testHelper::testFile = manifestUpdFile;
+  m_patchFile = patchFile;
   OnUpdateSegments();
   return m_manifestUpdUrl;
 }
@@ -174,6 +183,12 @@ bool DASHTestTree::DownloadManifestUpd(std::string_view url,
 {
   m_manifestUpdUrl = url.data();
 
+  if (!m_patchLocation.empty() && url == m_patchLocation)
+  {
+    resp.effectiveUrl = url;
+    return !m_patchFile.empty() && testHelper::LoadFile(m_patchFile, resp.data);
+  }
+
   if (testHelper::DownloadFile(url, reqHeaders, respHeaders, resp))
   {
     return true;
@@ -181,11 +196,26 @@ bool DASHTestTree::DownloadManifestUpd(std::string_view url,
   return false;
 }
 
+bool DASHTestTree::DownloadServerTime(std::string_view url, UTILS::CURL::HTTPResponse& resp)
+{
+  resp.effectiveUrl = url;
+  resp.data = m_serverTimeData;
+  return !m_serverTimeData.empty();
+}
+
 HLSTestTree::HLSTestTree() : CHLSTree() 
 {
   m_decrypter = std::make_unique<AESDecrypter>(AESDecrypter(std::string()));
 }
 
+void HLSTestTree::RunPlaylistsUpdate(const std::function<void()>& onPrepared)
+{
+  OnPrepareUpdateSegments();
+  if (onPrepared)
+    onPrepared();
+  OnUpdateSegments();
+}
+
 bool HLSTestTree::DownloadKey(std::string_view url,
                               const std::map<std::string, std::string>& reqHeaders,
                               const std::vector<std::string>& respHeaders,
@@ -203,6 +233,8 @@ bool HLSTestTree::DownloadManifestChild(std::string_view url,
                                         const std::vector<std::string>& respHeaders,
                                         UTILS::CURL::HTTPResponse& resp)
 {
+  testHelper::downloadList.emplace_back(url);
+
   if (testHelper::DownloadFile(url, reqHeaders, respHeaders, resp))
   {
     return true;
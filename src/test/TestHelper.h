@@ -18,6 +18,8 @@
 #include "../utils/log.h"
 
 #include <condition_variable>
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <string_view>
 
@@ -41,6 +43,8 @@ public:
                            UTILS::CURL::HTTPResponse& resp);
 
   static std::string testFile;
+  // Files served in order by the next downloads, then testFile is served
+  static std::deque<std::string> nextTestFiles;
   static std::string effectiveUrl;
   static std::vector<std::string> downloadList;
 };
@@ -110,9 +114,16 @@ public:
 
   /*!
    * \brief Run manually a manifest update with the specified file
-   * \return The url used to make the manifest request
+   * \param manifestUpdFile The file of the full manifest requests
+   * \param patchFile The file of the MPD patch requests, if any
+   * \return The url used to make the last manifest request
    */
-  std::string RunManifestUpdate(std::string manifestUpdFile);
+  std::string RunManifestUpdate(std::string manifestUpdFile, std::string patchFile = "");
+
+  /*!
+   * \brief Set the response body of the UTCTiming server time requests
+   */
+  void SetServerTimeResponse(std::string data) { m_serverTimeData = data; }
 
 private:
   bool DownloadManifestUpd(std::string_view url,
@@ -120,12 +131,16 @@ private:
                            const std::vector<std::string>& respHeaders,
                            UTILS::CURL::HTTPResponse& resp) override;
 
+  bool DownloadServerTime(std::string_view url, UTILS::CURL::HTTPResponse& resp) override;
+
   virtual CDashTree* Clone() const override { return new DASHTestTree{*this}; }
 
   uint64_t m_mockTime = 10000000000;
   std::chrono::system_clock::time_point m_mock_time_chrono = std::chrono::system_clock::now();
 
   std::string m_manifestUpdUrl; // Temporarily stores the url where to request the manifest update
+  std::string m_patchFile; // The file of the MPD patch requests
+  std::string m_serverTimeData; // The response body of the UTCTiming server time requests
 };
 
 class HLSTestTree : public adaptive::CHLSTree
@@ -135,6 +150,13 @@ public:
 
   virtual HLSTestTree* Clone() const override { return new HLSTestTree{*this}; }
 
+  /*!
+   * \brief Run a live playlists update, as made by the update thread.
+   * \param onPrepared [OPT] Called after the playlists are downloaded, before parsing them,
+   *                   as when the updates are paused in the meantime
+   */
+  void RunPlaylistsUpdate(const std::function<void()>& onPrepared = {});
+
 private:
   bool DownloadKey(std::string_view url,
                    const std::map<std::string, std::string>& reqHeaders,
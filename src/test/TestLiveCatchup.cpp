@@ -0,0 +1,121 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "../common/LiveCatchup.h"
+
+#include <gtest/gtest.h>
+
+using namespace adaptive;
+
+namespace
+{
+CLiveCatchup CreateCatchup(uint64_t targetLatency)
+{
+  CLiveCatchup catchup;
+  CLiveCatchup::Config config;
+  config.m_targetLatency = targetLatency;
+  catchup.Configure(config);
+  return catchup;
+}
+} // unnamed namespace
+
+TEST(LiveCatchupTest, DefaultConfig)
+{
+  CLiveCatchup catchup = CreateCatchup(3000);
+  ASSERT_TRUE(catchup.IsEnabled());
+  EXPECT_EQ(catchup.GetConfig().m_minLatency, 2250);
+  EXPECT_EQ(catchup.GetConfig().m_maxLatency, 6000);
+  EXPECT_DOUBLE_EQ(catchup.GetConfig().m_minRate, 0.95);
+  EXPECT_DOUBLE_EQ(catchup.GetConfig().m_maxRate, 1.05);
+
+  CLiveCatchup disabled = CreateCatchup(0);
+  EXPECT_FALSE(disabled.IsEnabled());
+  EXPECT_EQ(disabled.Update(60000, 10000), CLiveCatchup::Action::NONE);
+  EXPECT_DOUBLE_EQ(disabled.GetPlaybackRate(), 1.0);
+}
+
+TEST(LiveCatchupTest, AdjustRateWithinBand)
+{
+  CLiveCatchup catchup = CreateCatchup(3000);
+
+  // Small deviations from the target are not corrected
+  EXPECT_EQ(catchup.Update(3200, 3000), CLiveCatchup::Action::NONE);
+  EXPECT_EQ(catchup.Update(2800, 2000), CLiveCatchup::Action::NONE);
+  EXPECT_DOUBLE_EQ(catchup.GetPlaybackRate(), 1.0);
+
+  // Behind the target, the speed up is proportional to the deviation
+  EXPECT_EQ(catchup.Update(4200, 3000), CLiveCatchup::Action::ADJUST_RATE);
+  EXPECT_DOUBLE_EQ(catchup.GetPlaybackRate(), 1.02);
+  EXPECT_EQ(catchup.Update(4200, 3000), CLiveCatchup::Action::NONE);
+  EXPECT_EQ(catchup.Update(6000, 3000), CLiveCatchup::Action::ADJUST_RATE);
+  EXPECT_DOUBLE_EQ(catchup.GetPlaybackRate(), 1.05);
+
+  // The adjustment continue until the latency is close to the target
+  EXPECT_EQ(catchup.Update(3240, 3000), CLiveCatchup::Action::ADJUST_RATE);
+  EXPECT_DOUBLE_EQ(catchup.GetPlaybackRate(), 1.01);
+  EXPECT_EQ(catchup.Update(3100, 3000), CLiveCatchup::Action::ADJUST_RATE);
+  EXPECT_DOUBLE_EQ(catchup.GetPlaybackRate(), 1.0);
+
+  // Ahead of the target, the playback is slowed down
+  EXPECT_EQ(catchup.Update(2250, 2000), CLiveCatchup::Action::ADJUST_RATE);
+  EXPECT_DOUBLE_EQ(catchup.GetPlaybackRate(), 0.95);
+}
+
+TEST(LiveCatchupTest, NoSpeedUpOnLowBuffer)
+{
+  CLiveCatchup catchup = CreateCatchup(3000);
+
+  EXPECT_EQ(catchup.Update(4200, 1000), CLiveCatchup::Action::NONE);
+  EXPECT_DOUBLE_EQ(catchup.GetPlaybackRate(), 1.0);
+
+  EXPECT_EQ(catchup.Update(4200, 3000), CLiveCatchup::Action::ADJUST_RATE);
+  EXPECT_EQ(catchup.Update(4200, 1000), CLiveCatchup::Action::ADJUST_RATE);
+  EXPECT_DOUBLE_EQ(catchup.GetPlaybackRate(), 1.0);
+}
+
+TEST(LiveCatchupTest, SeekWhenFarBehind)
+{
+  CLiveCatchup catchup = CreateCatchup(16000);
+
+  EXPECT_EQ(catchup.Update(20000, 16000), CLiveCatchup::Action::ADJUST_RATE);
+  EXPECT_EQ(catchup.Update(40000, 30000), CLiveCatchup::Action::SEEK);
+  EXPECT_DOUBLE_EQ(catchup.GetPlaybackRate(), 1.0);
+  // The seek is requested once, until the latency return within the max latency
+  EXPECT_EQ(catchup.Update(40000, 30000), CLiveCatchup::Action::NONE);
+  EXPECT_EQ(catchup.Update(16000, 10000), CLiveCatchup::Action::NONE);
+  EXPECT_EQ(catchup.Update(40000, 30000), CLiveCatchup::Action::SEEK);
+}
+
+TEST(LiveCatchupTest, ServiceDescriptionConfig)
+{
+  CLiveCatchup catchup;
+  CLiveCatchup::Config config;
+  config.m_targetLatency = 3000;
+  config.m_minLatency = 2000;
+  config.m_maxLatency = 6000;
+  config.m_minRate = 0.96;
+  config.m_maxRate = 1.04;
+  catchup.Configure(config);
+
+  EXPECT_EQ(catchup.Update(6000, 3000), CLiveCatchup::Action::ADJUST_RATE);
+  EXPECT_DOUBLE_EQ(catchup.GetPlaybackRate(), 1.04);
+  EXPECT_EQ(catchup.Update(6001, 3000), CLiveCatchup::Action::SEEK);
+  EXPECT_EQ(catchup.Update(2000, 2000), CLiveCatchup::Action::ADJUST_RATE);
+  EXPECT_DOUBLE_EQ(catchup.GetPlaybackRate(), 0.96);
+
+  // Inconsistent values are replaced by defaults
+  config.m_minLatency = 4000;
+  config.m_maxLatency = 2000;
+  config.m_minRate = 1.2;
+  config.m_maxRate = 3.0;
+  catchup.Configure(config);
+  EXPECT_EQ(catchup.GetConfig().m_minLatency, 2250);
+  EXPECT_EQ(catchup.GetConfig().m_maxLatency, 6000);
+  EXPECT_DOUBLE_EQ(catchup.GetConfig().m_minRate, 0.95);
+  EXPECT_DOUBLE_EQ(catchup.GetConfig().m_maxRate, 2.0);
+}
@@ -0,0 +1,379 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "../../lib/mpegts/mpegts/ES_MPEGVideo.h"
+#include "../../lib/mpegts/mpegts/ES_h264.h"
+#include "../../lib/mpegts/mpegts/ES_hevc.h"
+#include "../../lib/mpegts/mpegts/startCode.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace TSDemux;
+
+namespace
+{
+constexpr size_t FRAMES_COUNT = 40;
+
+size_t FindStartCodeNaive(const uint8_t* buf, size_t from, size_t to)
+{
+  for (size_t i = from; i + 2 < to; ++i)
+  {
+    if (buf[i] == 0 && buf[i + 1] == 0 && buf[i + 2] == 1)
+      return i;
+  }
+  return to;
+}
+
+// Random data with a high density of 0 and 1 bytes, to hit all the prefix corner cases
+std::vector<uint8_t> CreateZeroRichData(std::mt19937& rng, size_t size)
+{
+  std::vector<uint8_t> data(size);
+  for (uint8_t& byte : data)
+  {
+    const uint32_t value = rng();
+    if ((value & 3) != 0)
+      byte = static_cast<uint8_t>((value >> 8) % 3);
+    else
+      byte = static_cast<uint8_t>(value >> 16);
+  }
+  return data;
+}
+
+class CBitWriter
+{
+public:
+  void PutBits(uint32_t value, int count)
+  {
+    while (count-- > 0)
+    {
+      if (m_bits % 8 == 0)
+        m_data.emplace_back(0);
+      if ((value >> count) & 1)
+        m_data.back() |= 0x80 >> (m_bits % 8);
+      ++m_bits;
+    }
+  }
+
+  void PutUE(uint32_t value)
+  {
+    int count = 0;
+    while ((value + 1) >> (count + 1))
+      ++count;
+    PutBits(0, count);
+    PutBits(value + 1, count + 1);
+  }
+
+  //! \brief Add the rbsp stop bit, the data is padded to the byte boundary
+  std::vector<uint8_t> GetRbsp()
+  {
+    PutBits(1, 1);
+    return m_data;
+  }
+
+  const std::vector<uint8_t>& GetData() const { return m_data; }
+
+private:
+  std::vector<uint8_t> m_data;
+  size_t m_bits{0};
+};
+
+/*!
+ * \brief Annex-B elementary stream, with the frame boundaries that a parser must find.
+ *        The NAL unit payloads get emulation prevention bytes, so they have no start codes.
+ */
+class CAnnexBStream
+{
+public:
+  void AddNal(const std::vector<uint8_t>& header,
+              const std::vector<uint8_t>& rbsp,
+              bool isFrameStart)
+  {
+    // Mix 3 and 4 bytes start codes, the stream begins with a 4 bytes one
+    const bool isLongStartCode = m_data.size() % 2 == 0;
+    // The first frame begins at the stream start, the other ones on the 3 bytes prefix
+    if (isFrameStart && !m_data.empty())
+      m_boundaries.emplace_back(m_data.size() + (isLongStartCode ? 1 : 0));
+    if (isLongStartCode)
+      m_data.emplace_back(0);
+    m_data.insert(m_data.end(), {0, 0, 1});
+    m_data.insert(m_data.end(), header.begin(), header.end());
+
+    size_t zeros = 0;
+    for (const uint8_t byte : rbsp)
+    {
+      if (zeros >= 2 && byte <= 3)
+      {
+        m_data.emplace_back(3);
+        zeros = 0;
+      }
+      m_data.emplace_back(byte);
+      zeros = byte == 0 ? zeros + 1 : 0;
+    }
+    // The payload ends with a stop bit, the next start code must stay a start code
+    m_data.emplace_back(0x80);
+  }
+
+  /*!
+   * \brief Add the end of sequence NAL unit, that completes the last frame, and a
+   *        trailing filler NAL unit, to let the parsers look ahead of it
+   */
+  void AddEndOfSequence(const std::vector<uint8_t>& eosHeader,
+                        const std::vector<uint8_t>& fillerHeader)
+  {
+    m_data.insert(m_data.end(), {0, 0, 1});
+    m_data.insert(m_data.end(), eosHeader.begin(), eosHeader.end());
+    m_boundaries.emplace_back(m_data.size());
+    AddNal(fillerHeader, std::vector<uint8_t>(16, 0xff), false);
+  }
+
+  const std::vector<uint8_t>& GetData() const { return m_data; }
+
+  std::vector<std::vector<uint8_t>> GetExpectedFrames() const
+  {
+    std::vector<std::vector<uint8_t>> frames;
+    size_t begin = 0;
+    for (const size_t end : m_boundaries)
+    {
+      frames.emplace_back(m_data.begin() + begin, m_data.begin() + end);
+      begin = end;
+    }
+    return frames;
+  }
+
+private:
+  std::vector<uint8_t> m_data;
+  std::vector<size_t> m_boundaries;
+};
+
+std::vector<uint8_t> CreatePayload(std::mt19937& rng)
+{
+  return CreateZeroRichData(rng, 40 + rng() % 2000);
+}
+
+CAnnexBStream CreateMPEG2VideoStream(std::mt19937& rng)
+{
+  CAnnexBStream stream;
+  CBitWriter seqHeader;
+  seqHeader.PutBits(320, 12); // horizontal_size_value
+  seqHeader.PutBits(240, 12); // vertical_size_value
+  seqHeader.PutBits(2, 4); // aspect_ratio_information
+  seqHeader.PutBits(3, 4); // frame_rate_code
+  seqHeader.PutBits(0x3ffff, 18); // bit_rate_value
+  seqHeader.PutBits(1, 1); // marker_bit
+  seqHeader.PutBits(112, 10); // vbv_buffer_size_value
+  seqHeader.PutBits(0, 3); // constrained_parameters_flag, no quantiser matrices
+  stream.AddNal({0xb3}, seqHeader.GetData(), true);
+
+  for (size_t frame = 0; frame < FRAMES_COUNT; ++frame)
+  {
+    CBitWriter picHeader;
+    picHeader.PutBits(static_cast<uint32_t>(frame + 1), 10); // temporal_reference
+    picHeader.PutBits(frame == 0 ? 1 : 2, 3); // picture_coding_type, I or P
+    picHeader.PutBits(0xffff, 16); // vbv_delay
+    stream.AddNal({0x00}, picHeader.GetData(), frame > 0);
+
+    const size_t slices = 1 + rng() % 3;
+    for (size_t slice = 1; slice <= slices; ++slice)
+      stream.AddNal({static_cast<uint8_t>(slice)}, CreatePayload(rng), false);
+  }
+  stream.AddEndOfSequence({0xb7}, {0xb2});
+  return stream;
+}
+
+CAnnexBStream CreateH264Stream(std::mt19937& rng)
+{
+  CAnnexBStream stream;
+  CBitWriter sps;
+  sps.PutBits(66, 8); // profile_idc, baseline
+  sps.PutBits(0xc0, 8); // constraint flags
+  sps.PutBits(30, 8); // level_idc
+  sps.PutUE(0); // seq_parameter_set_id
+  sps.PutUE(0); // log2_max_frame_num_minus4
+  sps.PutUE(2); // pic_order_cnt_type
+  sps.PutUE(1); // max_num_ref_frames
+  sps.PutBits(0, 1); // gaps_in_frame_num_value_allowed_flag
+  sps.PutUE(19); // pic_width_in_mbs_minus1
+  sps.PutUE(14); // pic_height_in_map_units_minus1
+  sps.PutBits(1, 1); // frame_mbs_only_flag
+  sps.PutBits(1, 1); // direct_8x8_inference_flag
+  sps.PutBits(0, 2); // frame_cropping_flag, vui_parameters_present_flag
+  stream.AddNal({0x67}, sps.GetRbsp(), true);
+
+  CBitWriter pps;
+  pps.PutUE(0); // pic_parameter_set_id
+  pps.PutUE(0); // seq_parameter_set_id
+  pps.PutBits(0, 2); // entropy_coding_mode_flag, bottom_field_pic_order_in_frame_present_flag
+  stream.AddNal({0x68}, pps.GetRbsp(), false);
+
+  for (size_t frame = 0; frame < FRAMES_COUNT; ++frame)
+  {
+    const bool isIdr = frame == 0;
+    const size_t slices = 1 + rng() % 3;
+    for (size_t slice = 0; slice < slices; ++slice)
+    {
+      CBitWriter header;
+      header.PutUE(0); // first_mb_in_slice
+      header.PutUE(isIdr ? 7 : 5); // slice_type, all I or all P
+      header.PutUE(0); // pic_parameter_set_id
+      header.PutBits(frame % 16, 4); // frame_num
+      if (isIdr)
+        header.PutUE(0); // idr_pic_id
+
+      std::vector<uint8_t> rbsp = header.GetRbsp();
+      const std::vector<uint8_t> payload = CreatePayload(rng);
+      rbsp.insert(rbsp.end(), payload.begin(), payload.end());
+      stream.AddNal({static_cast<uint8_t>(isIdr ? 0x65 : 0x61)}, rbsp, !isIdr && slice == 0);
+    }
+  }
+  stream.AddEndOfSequence({0x0a}, {0x0c});
+  return stream;
+}
+
+CAnnexBStream CreateHEVCStream(std::mt19937& rng)
+{
+  CAnnexBStream stream;
+  stream.AddNal({0x40, 0x01}, CreateZeroRichData(rng, 24), true); // VPS
+
+  CBitWriter sps;
+  sps.PutBits(0, 4); // sps_video_parameter_set_id
+  sps.PutBits(0, 3); // sps_max_sub_layers_minus1
+  sps.PutBits(1, 1); // sps_temporal_id_nesting_flag
+  for (int i = 0; i < 12; ++i)
+    sps.PutBits(0x5a, 8); // profile_tier_level
+  sps.PutUE(0); // sps_seq_parameter_set_id
+  sps.PutUE(1); // chroma_format_idc
+  sps.PutUE(320); // pic_width_in_luma_samples
+  sps.PutUE(240); // pic_height_in_luma_samples
+  stream.AddNal({0x42, 0x01}, sps.GetRbsp(), false);
+
+  CBitWriter pps;
+  pps.PutUE(0); // pps_pic_parameter_set_id
+  pps.PutUE(0); // pps_seq_parameter_set_id
+  pps.PutBits(0, 1); // dependent_slice_segments_enabled_flag
+  stream.AddNal({0x44, 0x01}, pps.GetRbsp(), false);
+
+  for (size_t frame = 0; frame < FRAMES_COUNT; ++frame)
+  {
+    const bool isIdr = frame == 0;
+    const size_t slices = 1 + rng() % 3;
+    for (size_t slice = 0; slice < slices; ++slice)
+    {
+      CBitWriter header;
+      header.PutBits(slice == 0 ? 1 : 0, 1); // first_slice_segment_in_pic_flag
+      if (isIdr)
+        header.PutBits(0, 1); // no_output_of_prior_pics_flag
+      header.PutUE(0); // slice_pic_parameter_set_id
+
+      std::vector<uint8_t> rbsp = header.GetRbsp();
+      const std::vector<uint8_t> payload = CreatePayload(rng);
+      rbsp.insert(rbsp.end(), payload.begin(), payload.end());
+      // IDR_W_RADL or TRAIL_R NAL unit types
+      stream.AddNal({static_cast<uint8_t>(isIdr ? 0x26 : 0x02), 0x01}, rbsp,
+                    !isIdr && slice == 0);
+    }
+  }
+  stream.AddEndOfSequence({0x48, 0x01}, {0x4c, 0x01});
+  return stream;
+}
+
+/*!
+ * \brief Feed the stream to the parser as the TS demuxer does, by appending the PES
+ *        payloads and reading the stream packets of the completed frames.
+ * \param maxChunkSize The maximum size of the appended chunks, 0 for random sizes
+ */
+std::vector<std::vector<uint8_t>> ParseStream(ElementaryStream& es,
+                                              const std::vector<uint8_t>& data,
+                                              std::mt19937& rng,
+                                              size_t maxChunkSize)
+{
+  std::vector<std::vector<uint8_t>> frames;
+  size_t pos = 0;
+  while (pos < data.size())
+  {
+    const size_t chunkSize = maxChunkSize > 0 ? maxChunkSize : 1 + rng() % 1000;
+    const size_t len = std::min(chunkSize, data.size() - pos);
+    EXPECT_EQ(es.Append(data.data() + pos, len), 0);
+    pos += len;
+
+    STREAM_PKT pkt;
+    while (es.GetStreamPacket(&pkt))
+      frames.emplace_back(pkt.data, pkt.data + pkt.size);
+  }
+  return frames;
+}
+
+template<typename T>
+void CheckParserFrames(CAnnexBStream (*createStream)(std::mt19937&))
+{
+  std::mt19937 rng(3);
+  const CAnnexBStream stream = createStream(rng);
+  const std::vector<std::vector<uint8_t>> expectedFrames = stream.GetExpectedFrames();
+  ASSERT_EQ(expectedFrames.size(), FRAMES_COUNT);
+
+  // Single bytes, TS packet payloads, large PES payloads and random PES payload sizes
+  for (const size_t maxChunkSize : {1, 184, 16384, 0})
+  {
+    T es(0x100);
+    const std::vector<std::vector<uint8_t>> frames =
+        ParseStream(es, stream.GetData(), rng, maxChunkSize);
+
+    ASSERT_EQ(frames.size(), expectedFrames.size()) << "chunk size " << maxChunkSize;
+    for (size_t i = 0; i < frames.size(); ++i)
+      ASSERT_EQ(frames[i], expectedFrames[i]) << "frame " << i << ", chunk size " << maxChunkSize;
+  }
+}
+} // unnamed namespace
+
+TEST(StartCodeTest, FindAtBufferEdges)
+{
+  const std::vector<uint8_t> data{0, 0, 1, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+                                  9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 0, 0, 1};
+  EXPECT_EQ(FindStartCode(data.data(), 0, data.size()), 0);
+  EXPECT_EQ(FindStartCode(data.data(), 1, data.size()), 29);
+  // Prefix truncated by the end of the range
+  EXPECT_EQ(FindStartCode(data.data(), 1, data.size() - 1), data.size() - 1);
+  // Empty and too short ranges
+  EXPECT_EQ(FindStartCode(data.data(), 5, 5), 5);
+  EXPECT_EQ(FindStartCode(data.data(), 0, 2), 2);
+}
+
+TEST(StartCodeTest, SameResultOfNaiveSearch)
+{
+  std::mt19937 rng(1);
+  for (int i = 0; i < 2000; ++i)
+  {
+    const std::vector<uint8_t> data = CreateZeroRichData(rng, rng() % 160);
+    // Cover every alignment of the vector loads and the scalar tail
+    for (size_t from = 0; from <= data.size(); from += 1 + rng() % 3)
+    {
+      const size_t to = from + rng() % (data.size() - from + 1);
+      const size_t expected = FindStartCodeNaive(data.data(), from, to);
+      ASSERT_EQ(FindStartCode(data.data(), from, to), expected);
+      ASSERT_EQ(FindStartCodeScalar(data.data(), from, to), expected);
+    }
+  }
+}
+
+TEST(StartCodeTest, MPEG2VideoParserFrames)
+{
+  CheckParserFrames<ES_MPEG2Video>(CreateMPEG2VideoStream);
+}
+
+TEST(StartCodeTest, H264ParserFrames)
+{
+  CheckParserFrames<ES_h264>(CreateH264Stream);
+}
+
+TEST(StartCodeTest, HEVCParserFrames)
+{
+  CheckParserFrames<ES_hevc>(CreateHEVCStream);
+}
@@ -0,0 +1,173 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "../codechandler/ttml/TTML.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+struct Cue
+{
+  uint64_t pts;
+  uint32_t duration;
+  std::string text;
+};
+
+std::vector<Cue> ReadCues(TTML2SRT& ttml)
+{
+  std::vector<Cue> cues;
+  Cue cue;
+  while (ttml.Prepare(cue.pts, cue.duration))
+  {
+    cue.text.assign(ttml.GetPreparedData(), ttml.GetPreparedDataSize());
+    cues.emplace_back(cue);
+  }
+  return cues;
+}
+
+std::string CreateTTML(const std::string& body)
+{
+  return "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+         "<tt xmlns=\"http://www.w3.org/ns/ttml\""
+         " xmlns:tts=\"http://www.w3.org/ns/ttml#styling\">"
+         "<head><styling>"
+         "<style xml:id=\"s1\" tts:color=\"white\"/>"
+         "<style xml:id=\"s2\" tts:fontStyle=\"italic\"/>"
+         "</styling></head>"
+         "<body style=\"s1\"><div>" +
+         body + "</div></body></tt>";
+}
+
+// Large sidecar file, with the cue end times not in ascending order
+std::string CreateLargeTTML(std::mt19937& rng, size_t cuesCount)
+{
+  std::string body;
+  uint64_t begin{0};
+  for (size_t i = 0; i < cuesCount; ++i)
+  {
+    begin += 500 + rng() % 3000;
+    const uint64_t end = begin + 200 + rng() % (i % 50 == 0 ? 20000 : 2000);
+    body += "<p begin=\"" + std::to_string(begin) + "ms\" end=\"" + std::to_string(end) +
+            "ms\"" + (i % 3 == 0 ? " style=\"s2\"" : "") + ">Line " + std::to_string(i) +
+            "<br/><span tts:fontWeight=\"bold\">Second line</span></p>";
+  }
+  return CreateTTML(body);
+}
+} // unnamed namespace
+
+TEST(TTMLTest, ParseStyledText)
+{
+  const std::string data = CreateTTML(
+      "<p begin=\"00:00:01.000\" end=\"00:00:02.500\">Hello <span style=\"s2\">world</span></p>"
+      "<p begin=\"00:00:01.000\" end=\"00:00:02.500\" tts:color=\"red\">Second<br/>line</p>"
+      "<p begin=\"3s\" end=\"3s\">Zero duration</p>"
+      "<p begin=\"4s\" end=\"5s\"><span tts:textDecoration=\"underline\">Last</span></p>");
+
+  TTML2SRT ttml{true};
+  ASSERT_TRUE(ttml.Parse(data.data(), data.size(), 1000));
+
+  const std::vector<Cue> cues = ReadCues(ttml);
+  ASSERT_EQ(cues.size(), 2);
+  EXPECT_EQ(cues[0].pts, 1000);
+  EXPECT_EQ(cues[0].duration, 1500);
+  EXPECT_EQ(cues[0].text, "<font color=\"white\">Hello </font>"
+                          "<font color=\"white\"><i>world</i></font><br/>"
+                          "<font color=\"red\">Second</font><br/><font color=\"red\">line</font>");
+  EXPECT_EQ(cues[1].pts, 4000);
+  EXPECT_EQ(cues[1].duration, 1000);
+  EXPECT_EQ(cues[1].text, "<font color=\"white\"><u>Last</u></font>");
+}
+
+TEST(TTMLTest, SkipRepeatedCueOfNextSegment)
+{
+  const std::string segment1 = CreateTTML("<p begin=\"1s\" end=\"2s\">First</p>"
+                                          "<p begin=\"2s\" end=\"3s\">Repeated</p>");
+  const std::string segment2 = CreateTTML("<p begin=\"2s\" end=\"3s\">Repeated</p>"
+                                          "<p begin=\"3s\" end=\"4s\">Next</p>");
+  TTML2SRT ttml{false};
+  uint64_t pts;
+  uint32_t duration;
+
+  ASSERT_TRUE(ttml.Parse(segment1.data(), segment1.size(), 1000));
+  EXPECT_EQ(ReadCues(ttml).size(), 2);
+
+  ASSERT_TRUE(ttml.Parse(segment2.data(), segment2.size(), 1000));
+  EXPECT_FALSE(ttml.Prepare(pts, duration));
+  ASSERT_TRUE(ttml.Prepare(pts, duration));
+  EXPECT_EQ(pts, 3000);
+  EXPECT_EQ(std::string(ttml.GetPreparedData(), ttml.GetPreparedDataSize()),
+            "<font color=\"white\">Next</font>");
+}
+
+TEST(TTMLTest, ParseInPlaceSameResult)
+{
+  std::mt19937 rng(1);
+  std::string data = CreateLargeTTML(rng, 500);
+
+  TTML2SRT ttml{true};
+  ASSERT_TRUE(ttml.Parse(data.data(), data.size(), 1000));
+  const std::vector<Cue> cues = ReadCues(ttml);
+
+  TTML2SRT ttmlInPlace{true};
+  ASSERT_TRUE(ttmlInPlace.ParseInPlace(data.data(), data.size(), 1000));
+  const std::vector<Cue> cuesInPlace = ReadCues(ttmlInPlace);
+
+  ASSERT_EQ(cues.size(), cuesInPlace.size());
+  for (size_t i = 0; i < cues.size(); ++i)
+  {
+    EXPECT_EQ(cues[i].pts, cuesInPlace[i].pts);
+    EXPECT_EQ(cues[i].duration, cuesInPlace[i].duration);
+    EXPECT_EQ(cues[i].text, cuesInPlace[i].text);
+  }
+}
+
+TEST(TTMLTest, SeekToFirstCueEndingAfterSeekTime)
+{
+  std::mt19937 rng(2);
+  const std::string data = CreateLargeTTML(rng, 500);
+
+  TTML2SRT ttml{true};
+  ASSERT_TRUE(ttml.Parse(data.data(), data.size(), 1000));
+  const std::vector<Cue> cues = ReadCues(ttml);
+  ASSERT_EQ(cues.size(), 500);
+
+  const uint64_t lastEnd = cues.back().pts + cues.back().duration;
+  size_t lastPos = cues.size() + 1;
+  for (uint64_t seekTime = 0; seekTime < lastEnd + 1000; seekTime += 97)
+  {
+    // Same search of a linear scan
+    size_t expectedPos = 0;
+    while (expectedPos < cues.size() &&
+           cues[expectedPos].pts + cues[expectedPos].duration < seekTime)
+    {
+      expectedPos++;
+    }
+    // The same cue is not fed again after a seek
+    if (expectedPos == lastPos)
+      continue;
+    lastPos = expectedPos;
+
+    ttml.TimeSeek(seekTime);
+    uint64_t pts;
+    uint32_t duration;
+    if (expectedPos < cues.size())
+    {
+      ASSERT_TRUE(ttml.Prepare(pts, duration));
+      EXPECT_EQ(pts, cues[expectedPos].pts);
+    }
+    else
+    {
+      EXPECT_FALSE(ttml.Prepare(pts, duration));
+    }
+  }
+}
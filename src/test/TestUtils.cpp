@@ -13,6 +13,7 @@
 #include "../utils/DigestMD5Utils.h"
 #include "../utils/StringUtils.h"
 #include "../utils/UrlUtils.h"
+#include "../utils/Utils.h"
 #include "../utils/XMLUtils.h"
 
 #include <gtest/gtest.h>
@@ -269,6 +270,17 @@ TEST_F(UtilsTest, XMLDateTimeConversions)
   EXPECT_EQ(XML::ParseDate("2024-05-07T17:00:21.989+0200"), 1715101221.989);
 }
 
+TEST_F(UtilsTest, HttpDateConversions)
+{
+  EXPECT_EQ(UTILS::ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"), 784111777000);
+
+  EXPECT_EQ(UTILS::ParseHttpDate("Tue, 07 May 2024 17:00:21 GMT"), 1715101221000);
+
+  // Malformed
+  EXPECT_EQ(UTILS::ParseHttpDate("2024-05-07T17:00:21Z"), 0);
+  EXPECT_EQ(UTILS::ParseHttpDate("Tue, 07 Foo 2024 17:00:21 GMT"), 0);
+}
+
 TEST_F(UtilsTest, MD5HashTest)
 {
   std::string strTest = "Test";
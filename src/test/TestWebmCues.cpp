@@ -0,0 +1,154 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "../demuxers/WebmCues.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace WEBM;
+
+namespace
+{
+using Bytes = std::vector<uint8_t>;
+
+// Create an EBML element, with the size coded on the minimum number of bytes
+Bytes Element(uint32_t id, const Bytes& body)
+{
+  Bytes data;
+  for (int shift = 24; shift >= 0; shift -= 8)
+  {
+    if (id >> shift || !data.empty())
+      data.emplace_back(static_cast<uint8_t>(id >> shift));
+  }
+  if (body.size() < 0x7F)
+  {
+    data.emplace_back(static_cast<uint8_t>(0x80 | body.size()));
+  }
+  else
+  {
+    data.emplace_back(static_cast<uint8_t>(0x40 | body.size() >> 8));
+    data.emplace_back(static_cast<uint8_t>(body.size()));
+  }
+  data.insert(data.end(), body.begin(), body.end());
+  return data;
+}
+
+// Create an EBML element with unknown size
+Bytes UnknownSizeElement(uint32_t id, const Bytes& body)
+{
+  Bytes data{static_cast<uint8_t>(id >> 24), static_cast<uint8_t>(id >> 16),
+             static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id), 0xFF};
+  data.insert(data.end(), body.begin(), body.end());
+  return data;
+}
+
+Bytes UInt(uint32_t id, uint64_t value)
+{
+  Bytes body;
+  for (int shift = 56; shift >= 0; shift -= 8)
+  {
+    if (value >> shift || !body.empty() || shift == 0)
+      body.emplace_back(static_cast<uint8_t>(value >> shift));
+  }
+  return Element(id, body);
+}
+
+Bytes Concat(std::initializer_list<Bytes> parts)
+{
+  Bytes data;
+  for (const Bytes& part : parts)
+    data.insert(data.end(), part.begin(), part.end());
+  return data;
+}
+
+Bytes CuePointElement(uint64_t time, uint64_t clusterPos)
+{
+  return Element(0xBB, Concat({UInt(0xB3, time),
+                               Element(0xB7, Concat({UInt(0xF7, 1), UInt(0xF1, clusterPos)}))}));
+}
+
+Bytes CuesElement()
+{
+  return Element(0x1C53BB6B, Concat({CuePointElement(0, 4000), CuePointElement(5000, 90000),
+                                     CuePointElement(10000, 170000)}));
+}
+
+void CheckCuePoints(const std::vector<CuePoint>& cuePoints)
+{
+  ASSERT_EQ(cuePoints.size(), 3);
+  EXPECT_EQ(cuePoints[0].pts, 0);
+  EXPECT_EQ(cuePoints[0].duration, 5000);
+  EXPECT_EQ(cuePoints[0].pos_start, 4000);
+  EXPECT_EQ(cuePoints[0].pos_end, 89999);
+  EXPECT_EQ(cuePoints[1].pts, 5000);
+  EXPECT_EQ(cuePoints[1].duration, 5000);
+  EXPECT_EQ(cuePoints[1].pos_start, 90000);
+  EXPECT_EQ(cuePoints[1].pos_end, 169999);
+  EXPECT_EQ(cuePoints[2].pts, 10000);
+  EXPECT_EQ(cuePoints[2].duration, 0);
+  EXPECT_EQ(cuePoints[2].pos_start, 170000);
+  EXPECT_EQ(cuePoints[2].pos_end, ~0ULL);
+}
+} // unnamed namespace
+
+TEST(WebmCuesTest, ParseCuesElement)
+{
+  const Bytes data = CuesElement();
+  std::vector<CuePoint> cuePoints;
+  EXPECT_TRUE(ParseCuePoints(data.data(), data.size(), cuePoints));
+  CheckCuePoints(cuePoints);
+}
+
+TEST(WebmCuesTest, ParseFromFileStart)
+{
+  const Bytes ebmlHeader = Element(0x1A45DFA3, UInt(0x4282, 0x7765));
+  const Bytes info = Element(0x1549A966, UInt(0x2AD7B1, 1000000));
+  const Bytes tracks = Element(0x1654AE6B, Element(0xAE, UInt(0xD7, 1)));
+  const Bytes cluster = Element(0x1F43B675, UInt(0xE7, 0));
+
+  for (const bool isUnknownSize : {false, true})
+  {
+    const Bytes body = Concat({info, tracks, CuesElement(), cluster});
+    const Bytes segment =
+        isUnknownSize ? UnknownSizeElement(0x18538067, body) : Element(0x18538067, body);
+    const Bytes data = Concat({ebmlHeader, segment});
+
+    std::vector<CuePoint> cuePoints;
+    EXPECT_TRUE(ParseCuePoints(data.data(), data.size(), cuePoints));
+    CheckCuePoints(cuePoints);
+  }
+}
+
+TEST(WebmCuesTest, TruncatedCues)
+{
+  Bytes data = CuesElement();
+  // The last CuePoint is incomplete
+  data.resize(data.size() - 2);
+  std::vector<CuePoint> cuePoints;
+  EXPECT_TRUE(ParseCuePoints(data.data(), data.size(), cuePoints));
+  ASSERT_EQ(cuePoints.size(), 2);
+  EXPECT_EQ(cuePoints[1].pts, 5000);
+  EXPECT_EQ(cuePoints[1].pos_end, ~0ULL);
+}
+
+TEST(WebmCuesTest, InvalidData)
+{
+  std::vector<CuePoint> cuePoints;
+  const Bytes noCues = Element(0x1549A966, UInt(0x2AD7B1, 1000000));
+  EXPECT_FALSE(ParseCuePoints(noCues.data(), noCues.size(), cuePoints));
+
+  const Bytes zeros(64, 0);
+  EXPECT_FALSE(ParseCuePoints(zeros.data(), zeros.size(), cuePoints));
+
+  // CuePoint without track positions are ignored
+  const Bytes noPositions = Element(0x1C53BB6B, Element(0xBB, UInt(0xB3, 100)));
+  EXPECT_FALSE(ParseCuePoints(noPositions.data(), noPositions.size(), cuePoints));
+  EXPECT_TRUE(cuePoints.empty());
+}
@@ -36,6 +36,22 @@ bool UTILS::FILESYS::SaveFile(const std::string filePath, const std::string& dat
   return isWritten;
 }
 
+bool UTILS::FILESYS::ReadFile(const std::string& filePath, std::string& data)
+{
+  kodi::vfs::CFile file;
+  if (!file.OpenFile(filePath))
+    return false;
+
+  char buffer[4096];
+  ssize_t bytesRead;
+  while ((bytesRead = file.Read(buffer, sizeof(buffer))) > 0)
+  {
+    data.append(buffer, static_cast<size_t>(bytesRead));
+  }
+  file.Close();
+  return bytesRead == 0;
+}
+
 std::string UTILS::FILESYS::PathCombine(std::string_view path, std::string_view filePath)
 {
   if (path.empty())
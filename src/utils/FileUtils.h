@@ -31,6 +31,14 @@ constexpr char SEPARATOR = '/';
  */
 bool SaveFile(const std::string filePath, const std::string& data, bool overwrite);
 
+/*!
+ * \brief Read the whole content of a file
+ * \param filePath The file path.
+ * \param data [OUT] The data read.
+ * \return True if success, otherwise false.
+ */
+bool ReadFile(const std::string& filePath, std::string& data);
+
 /*!
  * \brief Combine a path with another one
  * \param path The starting path.
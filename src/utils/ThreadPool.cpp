@@ -0,0 +1,58 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "ThreadPool.h"
+
+UTILS::CThreadPool::CThreadPool(size_t threadsCount /* = 0 */)
+{
+  if (threadsCount == 0)
+    threadsCount = std::thread::hardware_concurrency();
+  if (threadsCount == 0)
+    threadsCount = 1;
+
+  m_workers.reserve(threadsCount);
+  for (size_t i = 0; i < threadsCount; ++i)
+  {
+    m_workers.emplace_back(&CThreadPool::Worker, this);
+  }
+}
+
+UTILS::CThreadPool::~CThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_isStopped = true;
+  }
+  m_cvTasks.notify_all();
+
+  for (std::thread& worker : m_workers)
+  {
+    if (worker.joinable())
+      worker.join();
+  }
+}
+
+void UTILS::CThreadPool::Worker()
+{
+  while (true)
+  {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cvTasks.wait(lock, [this] { return m_isStopped || !m_tasks.empty(); });
+
+      // Pending tasks are always completed, so their futures will not be left unsatisfied
+      if (m_tasks.empty())
+        return;
+
+      task = std::move(m_tasks.front());
+      m_tasks.pop();
+    }
+    task();
+  }
+}
@@ -0,0 +1,78 @@
+/*
+ *  Copyright (C) 2024 Team Kodi
+ *  This file is part of Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace UTILS
+{
+
+/*!
+ * \brief A pool with a fixed number of worker threads, where the tasks are executed
+ *        in the same order of submission, with a maximum concurrency equal to the workers count.
+ */
+class CThreadPool
+{
+public:
+  /*!
+   * \brief Create the thread pool.
+   * \param threadsCount The number of worker threads, if 0 will be used the number
+   *                     of hardware threads available
+   */
+  explicit CThreadPool(size_t threadsCount = 0);
+  ~CThreadPool();
+
+  CThreadPool(const CThreadPool&) = delete;
+  CThreadPool& operator=(const CThreadPool&) = delete;
+
+  /*!
+   * \brief Submit a task to be executed by a worker thread.
+   * \param func The task function
+   * \return The future of the task result
+   */
+  template<typename F>
+  auto Submit(F&& func) -> std::future<std::invoke_result_t<F>>
+  {
+    using ResultType = std::invoke_result_t<F>;
+
+    auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(func));
+    std::future<ResultType> future = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.emplace([task] { (*task)(); });
+    }
+    m_cvTasks.notify_one();
+    return future;
+  }
+
+  /*!
+   * \brief Get the number of worker threads.
+   */
+  size_t GetThreadsCount() const { return m_workers.size(); }
+
+private:
+  void Worker();
+
+  std::vector<std::thread> m_workers;
+  std::queue<std::function<void()>> m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_cvTasks;
+  bool m_isStopped{false};
+};
+
+} // namespace UTILS
@@ -9,6 +9,7 @@
 #include "Utils.h"
 
 #include "Base64Utils.h"
+#include "oscompat.h" // _mkgmtime
 #include "StringUtils.h"
 #include "kodi/tools/StringUtils.h"
 
@@ -242,6 +243,34 @@ uint64_t UTILS::GetTimestampMs()
   return std::chrono::duration_cast<std::chrono::milliseconds>(epochTime).count();
 }
 
+uint64_t UTILS::ParseHttpDate(std::string_view dateStr)
+{
+  static const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                 "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+  int day, year, hour, minu, sec;
+  char month[4]{};
+
+  if (std::sscanf(std::string(dateStr).c_str(), "%*3s, %d %3s %d %d:%d:%d", &day, month, &year,
+                  &hour, &minu, &sec) != 6)
+  {
+    return 0;
+  }
+
+  auto itMonth = std::find_if(std::begin(months), std::end(months),
+                              [&month](const char* name) { return std::strcmp(name, month) == 0; });
+  if (itMonth == std::end(months))
+    return 0;
+
+  tm tmd{0};
+  tmd.tm_year = year - 1900;
+  tmd.tm_mon = static_cast<int>(itMonth - std::begin(months));
+  tmd.tm_mday = day;
+  tmd.tm_hour = hour;
+  tmd.tm_min = minu;
+  tmd.tm_sec = sec;
+  return static_cast<uint64_t>(_mkgmtime(&tmd)) * 1000;
+}
+
 std::vector<uint8_t> UTILS::ZeroPadding(const std::vector<uint8_t>& data, const size_t padSize)
 {
   if (data.size() >= padSize || data.empty())
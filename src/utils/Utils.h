@@ -40,6 +40,13 @@ uint64_t GetTimestamp();
  */
 uint64_t GetTimestampMs();
 
+/*!
+ * \brief Parse an HTTP date (RFC 7231 IMF-fixdate), e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+ * \param dateStr The date string
+ * \return The timestamp in milliseconds, or 0 when fails
+ */
+uint64_t ParseHttpDate(std::string_view dateStr);
+
 /*!
  * \brief Add zero-pad on the left side of data when the data size is less than pad size
  * \param data The data